@@ -19,22 +19,32 @@
 #include <string>
 #include <cstring> // memset
 #include <iostream>
+#include <algorithm>
 #include "utils/write_graphviz.hpp"
 #include "utils/timer.hpp"
 #include "utils/to_string.hpp"
+#include "utils/file.hpp"
 #include "reaction_network/network.hpp"
+#if defined(WCS_HAS_METIS)
+#include "partition/metis_partition.hpp"
+#endif // defined(WCS_HAS_METIS)
 #include "des.hpp"
 #include "wcs-ross-bf.hpp"
 
 using revent_t = wcs::Sim_State_Change::revent_t;
 WCS_Global_State gState;
 
+/// Partition the network into as many parts as the total number of LPs
+void setup_partition(const std::string& input_model,
+                     const size_t nparts,
+                     std::vector<wcs::partition_id_t>& parts);
+
 int main(int argc, char **argv)
 {
   tw_opt_add(app_opt);
   tw_init(&argc, &argv);
 
-  SSA_Config& cfg = gState.m_cfg;
+  wcs::SSA_Params& cfg = gState.m_cfg;
   cfg.getopt(argc, argv);
   tw_define_lps(nlp_per_pe, sizeof(WCS_Message));
 
@@ -42,12 +52,17 @@ int main(int argc, char **argv)
     tw_lp_settype(i, &wcs_LPs[0]);
   }
 
+  if (partitioned) {
+    setup_partition(cfg.m_infile, g_tw_nlp * tw_nnodes(), gState.m_parts);
+  }
+
   if( g_tw_mynode == 0 )
   {
     std::cout << "=========================================" << std::endl;
     std::cout << "WCS ROSS Configuration.............." << std::endl;
     std::cout << "   run_id:\t" + std::string(run_id) << std::endl;
     std::cout << "   nlp_per_pe:\t" << g_tw_nlp << std::endl;
+    std::cout << "   partitioned:\t" << partitioned << std::endl;
     std::cout << "   g_tw_ts_end:\t" << g_tw_ts_end << std::endl;;
     std::cout << "   gvt-interval:\t" << g_tw_gvt_interval << std::endl;;
     std::cout << "   extramem:\t" << g_tw_events_per_pe_extra << std::endl;
@@ -65,31 +80,168 @@ int main(int argc, char **argv)
 }
 
 
+void setup_partition(const std::string& input_model,
+                     const size_t nparts,
+                     std::vector<wcs::partition_id_t>& parts)
+{
+  std::shared_ptr<wcs::Network> rnet_ptr = std::make_shared<wcs::Network>();
+  wcs::Network& rnet = *rnet_ptr;
+  rnet.load(input_model);
+  rnet.init();
+
+  if (nparts <= 1ul) {
+    parts.assign(rnet.get_num_vertices(), static_cast<wcs::partition_id_t>(0));
+    return;
+  }
+
+ #if defined(WCS_HAS_METIS)
+  // Every PE computes the same partition as Metis is deterministic given
+  // the same seed, which avoids broadcasting the result.
+  wcs::Metis_Params mp;
+  mp.set(static_cast<idx_t>(nparts), rnet_ptr);
+
+  wcs::Metis_Partition partitioner(mp);
+  partitioner.prepare();
+
+  idx_t objval; /// Total comm volume or edge-cut of the solution
+  if (!partitioner.run(parts, objval)) {
+    WCS_THROW("Failed to partition the network.");
+  }
+ #else
+  WCS_THROW("Partitioning the network requires Metis.");
+ #endif // defined(WCS_HAS_METIS)
+}
+
+
+void WCS_LP_State::build_boundary_tables()
+{
+  const wcs::Network& net = *m_net_ptr;
+  const wcs::Network::graph_t& g = net.graph();
+  const auto my_pid = net.get_partition_id();
+  const size_t num_species = net.get_num_species();
+  const size_t num_reactions = net.get_num_reactions();
+
+  // The LPs that keep a copy of each species, including this one
+  std::vector<std::vector<wcs::partition_id_t>> sharers(num_species);
+  m_reader_offsets.assign(1ul, 0ul);
+  m_reader_offsets.reserve(num_species + 1ul);
+  m_readers.clear();
+
+  for (size_t sidx = 0ul; sidx < num_species; ++sidx) {
+    const auto sd = net.species_i2d(static_cast<wcs::v_idx_t>(sidx));
+    auto& pids = sharers[sidx];
+    pids.push_back(g[sd].get_partition());
+
+    for (const auto ei :
+         boost::make_iterator_range(boost::in_edges(sd, g))) {
+      pids.push_back(g[boost::source(ei, g)].get_partition());
+    }
+    for (const auto ei :
+         boost::make_iterator_range(boost::out_edges(sd, g))) {
+      const auto rd = boost::target(ei, g);
+      const auto pid = g[rd].get_partition();
+      pids.push_back(pid);
+      if (pid == my_pid) {
+        m_readers.push_back(rd);
+      }
+    }
+    std::sort(pids.begin(), pids.end());
+    pids.erase(std::unique(pids.begin(), pids.end()), pids.end());
+    m_reader_offsets.push_back(m_readers.size());
+  }
+
+  m_send_offsets.assign(1ul, 0ul);
+  m_send_offsets.reserve(num_reactions + 1ul);
+  m_sends.clear();
+
+  // Net change of each species by a reaction
+  std::vector<wcs::Network::species_update_t> deltas;
+
+  for (size_t ridx = 0ul; ridx < num_reactions; ++ridx) {
+    const auto rd = net.reaction_i2d(static_cast<wcs::v_idx_t>(ridx));
+    if (g[rd].get_partition() != my_pid) {
+      m_send_offsets.push_back(m_sends.size());
+      continue;
+    }
+
+    deltas.clear();
+    for (const auto& u : net.get_reactant_updates(rd)) {
+      deltas.emplace_back(u.first, -u.second);
+    }
+    for (const auto& u : net.get_product_updates(rd)) {
+      deltas.emplace_back(u.first, u.second);
+    }
+    std::sort(deltas.begin(), deltas.end());
+
+    for (size_t i = 0ul; i < deltas.size(); ) {
+      const auto sidx = deltas[i].first;
+      wcs::stoic_t delta = 0;
+      for (; (i < deltas.size()) && (deltas[i].first == sidx); ++i) {
+        delta += deltas[i].second;
+      }
+      if (delta == 0) continue;
+
+      for (const auto pid : sharers[sidx]) {
+        if (pid == my_pid) continue;
+        m_sends.push_back({static_cast<tw_lpid>(pid), sidx, delta});
+      }
+    }
+    m_send_offsets.push_back(m_sends.size());
+  }
+}
+
+
+std::pair<const WCS_Boundary_Update*, const WCS_Boundary_Update*>
+WCS_LP_State::get_sends(const wcs::v_idx_t ridx) const
+{
+  if (m_send_offsets.empty()) {
+    return std::make_pair(nullptr, nullptr);
+  }
+  return std::make_pair(m_sends.data() + m_send_offsets[ridx],
+                        m_sends.data() + m_send_offsets[ridx + 1ul]);
+}
+
+
+wcs::Network::affected_reactions_t
+WCS_LP_State::get_readers(const wcs::v_idx_t sidx) const
+{
+  return wcs::Network::affected_reactions_t(
+           m_readers.data() + m_reader_offsets[sidx],
+           m_readers.data() + m_reader_offsets[sidx + 1ul]);
+}
+
+
 void wcs_init(WCS_State *s, tw_lp *lp)
 {
-  SSA_Config& cfg = gState.m_cfg;
+  wcs::SSA_Params& cfg = gState.m_cfg;
 
   std::shared_ptr<wcs::Network> rnet_ptr = std::make_shared<wcs::Network>();
   wcs::Network& rnet = *rnet_ptr;
-  rnet.load(cfg.infile);
+  rnet.load(cfg.m_infile);
   rnet.init();
   const wcs::Network::graph_t& g = rnet.graph();
 
-  if (!cfg.gvizfile.empty() &&
-      !wcs::write_graphviz(cfg.gvizfile, g))
+  if (partitioned) {
+    // The partition id is the global id of the LP
+    rnet.set_partition(gState.m_parts,
+                       static_cast<wcs::partition_id_t>(lp->gid));
+  }
+
+  if (!cfg.m_gvizfile.empty() &&
+      !wcs::write_graphviz(cfg.m_gvizfile, g))
   {
-    WCS_THROW("Failed to write " + cfg.gvizfile);
+    WCS_THROW("Failed to write " + cfg.m_gvizfile);
     return;
   }
 
   std::unique_ptr<wcs::SSA_NRM> ssa;
 
   try {
-    if (cfg.method == 1) {
+    if (cfg.m_method == 1) {
       std::cerr << "Next Reaction SSA method." << std::endl;
       ssa = std::make_unique<wcs::SSA_NRM>(rnet_ptr);
     } else {
-      WCS_THROW("Unsupported SSA method (" + std::to_string(cfg.method) + ')');
+      WCS_THROW("Unsupported SSA method (" + std::to_string(cfg.m_method) + ')');
       return;
     }
   } catch (const std::exception& e) {
@@ -97,47 +249,73 @@ void wcs_init(WCS_State *s, tw_lp *lp)
     return;
   }
 
-  if (cfg.tracing) {
-    ssa->set_tracing<wcs::TraceSSA>(cfg.outfile, cfg.frag_size);
+  // Each LP records its own events into a separate file when partitioned
+  const std::string outfile = (partitioned?
+    wcs::append_to_stem(cfg.get_outfile(), "-" + std::to_string(lp->gid)) :
+    cfg.get_outfile());
+
+  if (cfg.m_tracing) {
+    ssa->set_tracing<wcs::TraceSSA>(outfile, cfg.m_frag_size);
     std::cerr << "Enable tracing" << std::endl;
-  } else if (cfg.sampling) {
-    if (cfg.iter_interval > 0u) {
-      ssa->set_sampling<wcs::SamplesSSA>(cfg.iter_interval,
-                                         cfg.outfile,
-                                         cfg.frag_size);
-      std::cerr << "Enable sampling at " << cfg.iter_interval
+  } else if (cfg.m_sampling) {
+    if (cfg.m_iter_interval > 0u) {
+      ssa->set_sampling<wcs::SamplesSSA>(cfg.m_iter_interval,
+                                         outfile,
+                                         cfg.m_frag_size);
+      std::cerr << "Enable sampling at " << cfg.m_iter_interval
                 << " steps interval" << std::endl;
     } else {
-      ssa->set_sampling<wcs::SamplesSSA>(cfg.time_interval,
-                                         cfg.outfile,
-                                         cfg.frag_size);
-      std::cerr << "Enable sampling at " << cfg.time_interval
+      ssa->set_sampling<wcs::SamplesSSA>(cfg.m_time_interval,
+                                         outfile,
+                                         cfg.m_frag_size);
+      std::cerr << "Enable sampling at " << cfg.m_time_interval
                 << " secs interval" << std::endl;
     }
   }
-  ssa->init(cfg.max_iter, cfg.max_time, cfg.seed);
+  // The partitions must draw from different streams of random numbers
+  const unsigned seed = ((partitioned && (cfg.m_seed != 0u))?
+                         cfg.m_seed + static_cast<unsigned>(lp->gid) :
+                         cfg.m_seed);
+  ssa->init(cfg.m_max_iter, cfg.m_max_time, seed);
 
   const size_t lp_idx = gState.m_LP_states.size();
   ssa->m_lp_idx = lp_idx;
   s->m_lp_idx = lp_idx;
+  s->m_sched_seq = 0ul;
   gState.m_LP_states.emplace_back(std::move(ssa), rnet_ptr);
+  if (partitioned) {
+    gState.m_LP_states[lp_idx].build_boundary_tables();
+  }
   gState.m_LP_states[lp_idx].m_t_start = wcs::get_time();
 }
 
 
-void wcs_prerun(WCS_State *s, tw_lp *lp)
+/**
+ * Schedule the next local reaction to this LP under the current sequence
+ * number. Return true if there is any to schedule.
+ */
+static bool schedule_next_reaction(WCS_State *s, const WCS_LP_State& lp_state,
+                                   tw_lp *lp)
 {
-  const WCS_LP_State& lp_state = gState.m_LP_states.at(s->m_lp_idx);
+  wcs::SSA_NRM::priority_t new_firing;
+  if (lp_state.m_ssa_ptr->schedule(new_firing) != wcs::Sim_Method::Success) {
+    return false;
+  }
+  new_firing.first -= tw_now(lp);
+  tw_event* next_evt = tw_event_new(lp->gid, new_firing.first, lp);
+  auto* next_msg = reinterpret_cast<WCS_Message*>(tw_event_data(next_evt));
+  next_msg->type = WCS_EVT_FIRE;
+  next_msg->reaction = lp_state.m_net_ptr->reaction_d2i(new_firing.second);
+  next_msg->seq = s->m_sched_seq;
+  tw_event_send(next_evt);
+  return true;
+}
 
-  wcs::Sim_Method::revent_t reaction_1st;
 
-  if (lp_state.m_ssa_ptr->schedule(reaction_1st) == wcs::Sim_Method::Success)
-  {
-    tw_event* next_evt = tw_event_new(lp->gid, reaction_1st.first, lp);
-    auto* next_msg = reinterpret_cast<WCS_Message*>(tw_event_data(next_evt));
-    next_msg->reaction = lp_state.m_net_ptr->reaction_d2i(reaction_1st.second);
-    tw_event_send(next_evt);
-  }
+void wcs_prerun(WCS_State *s, tw_lp *lp)
+{
+  const WCS_LP_State& lp_state = gState.m_LP_states.at(s->m_lp_idx);
+  schedule_next_reaction(s, lp_state, lp);
 }
 
 
@@ -146,21 +324,45 @@ void wcs_event(WCS_State *s, tw_bf *bf, WCS_Message *msg, tw_lp *lp)
   memset(static_cast<void*>(bf), 0, sizeof(tw_bf));
   const WCS_LP_State& lp_state = gState.m_LP_states.at(s->m_lp_idx);
 
+  if (msg->type == WCS_EVT_UPDATE) {
+    WCS_BF_(bf, WCS_BF_FWD) = 1u;
+    lp_state.m_ssa_ptr->forward_update(tw_now(lp), msg->species, msg->delta,
+                                       lp_state.get_readers(msg->species));
+    // The reaction event scheduled before becomes stale
+    s->m_sched_seq ++;
+    if (schedule_next_reaction(s, lp_state, lp)) {
+      WCS_BF_(bf, WCS_BF_SCHED) = 1u;
+    }
+    return;
+  }
+
+  if (msg->seq != s->m_sched_seq) {
+    return; // Superseded by a species update from another LP
+  }
+
   wcs::Sim_Method::revent_t firing
     = std::make_pair(tw_now(lp), lp_state.m_net_ptr->reaction_i2d(msg->reaction));
 
   if (lp_state.m_ssa_ptr->forward(firing))
   {
     WCS_BF_(bf, WCS_BF_FWD) = 1u;
-    wcs::SSA_NRM::priority_t new_firing;
-    if (lp_state.m_ssa_ptr->schedule(new_firing) == wcs::Sim_Method::Success)
-    {
+
+    // Send the changes of the species shared with other LPs. These take
+    // effect at the time of the reaction. A zero offset is allowed only with
+    // the optimistic synchronization, which the self events rely on as well.
+    const auto sends = lp_state.get_sends(msg->reaction);
+    for (auto u = sends.first; u != sends.second; ++u) {
+      tw_event* evt = tw_event_new(u->m_dest, 0.0, lp);
+      auto* umsg = reinterpret_cast<WCS_Message*>(tw_event_data(evt));
+      umsg->type = WCS_EVT_UPDATE;
+      umsg->species = u->m_species;
+      umsg->delta = u->m_delta;
+      tw_event_send(evt);
+    }
+
+    s->m_sched_seq ++;
+    if (schedule_next_reaction(s, lp_state, lp)) {
       WCS_BF_(bf, WCS_BF_SCHED) = 1u;
-      new_firing.first -= tw_now(lp);
-      tw_event* next_evt = tw_event_new(lp->gid, new_firing.first, lp);
-      auto* next_msg = reinterpret_cast<WCS_Message*>(tw_event_data(next_evt));
-      next_msg->reaction = lp_state.m_net_ptr->reaction_d2i(new_firing.second);
-      tw_event_send(next_evt);
     }
   }
 }
@@ -172,6 +374,13 @@ void wcs_event_reverse(WCS_State *s, tw_bf *bf, WCS_Message *msg, tw_lp *lp)
     return;
   }
   const WCS_LP_State& lp_state = gState.m_LP_states.at(s->m_lp_idx);
+  // The events sent are cancelled by ROSS
+  s->m_sched_seq --;
+
+  if (msg->type == WCS_EVT_UPDATE) {
+    lp_state.m_ssa_ptr->backward_update(msg->species, msg->delta);
+    return;
+  }
 
   wcs::Sim_Method::revent_t firing
     = std::make_pair(tw_now(lp), lp_state.m_net_ptr->reaction_i2d(msg->reaction));
@@ -194,19 +403,31 @@ void wcs_event_commit(WCS_State *s, tw_bf *bf, WCS_Message *msg, tw_lp *lp)
 
 void wcs_final(WCS_State *s, tw_lp *lp)
 {
-  SSA_Config& cfg = gState.m_cfg;
+  wcs::SSA_Params& cfg = gState.m_cfg;
   const WCS_LP_State& lp_state = gState.m_LP_states.at(s->m_lp_idx);
+  const wcs::Network& net = *(lp_state.m_net_ptr);
 
   std::cout << "Wall clock time to run simulation: "
             << wcs::get_time() - lp_state.m_t_start << " (sec)" << std::endl;
 
-  if (cfg.tracing || cfg.sampling) {
+  if (cfg.m_tracing || cfg.m_sampling) {
     lp_state.m_ssa_ptr->finalize_recording();
+  } else if (partitioned) {
+    // Only the species owned by this LP are up to date
+    const wcs::Network::graph_t& g = net.graph();
+    std::string labels;
+    std::string counts;
+    for (const auto sd : net.my_species_list()) {
+      labels += '\t' + g[sd].get_label();
+      counts += '\t' + std::to_string(net.species_count(net.species_d2i(sd)));
+    }
+    std::cout << "Species   (LP " << lp->gid << "):" << labels << std::endl;
+    std::cout << "FinalState(LP " << lp->gid << "):" << counts << std::endl;
   } else {
     std::cout << "Species   : "
-              << lp_state.m_net_ptr->show_species_labels("") << std::endl;
+              << net.show_species_labels("") << std::endl;
     std::cout << "FinalState: "
-              << lp_state.m_net_ptr->show_species_counts() << std::endl;
+              << net.show_species_counts() << std::endl;
   }
 }
 
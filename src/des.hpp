@@ -30,6 +30,14 @@
 // C++ and C state structures
 //----------------------------
 
+/// Change in the count of a species to send to another LP
+struct WCS_Boundary_Update
+{
+  tw_lpid m_dest; ///< LP that keeps a copy of the species
+  wcs::v_idx_t m_species; ///< Species index
+  wcs::stoic_t m_delta; ///< Change in the count
+};
+
 /// LP state
 struct WCS_LP_State
 {
@@ -40,12 +48,41 @@ struct WCS_LP_State
   /// Simulation start time (wall clock)
   double m_t_start;
 
+  /**
+   * The updates to send to other LPs upon firing each local reaction, in the
+   * compressed sparse row format indexed by the reaction index. Empty unless
+   * the network is partitioned.
+   */
+  std::vector<size_t> m_send_offsets;
+  std::vector<WCS_Boundary_Update> m_sends;
+  /**
+   * The local reactions that take each species as an input, in the compressed
+   * sparse row format indexed by the species index. These are to be updated
+   * upon receiving the change of the species from another LP.
+   */
+  std::vector<size_t> m_reader_offsets;
+  std::vector<wcs::Network::v_desc_t> m_readers;
+
   WCS_LP_State(std::unique_ptr<wcs::SSA_NRM>&& ssa_ptr,
                std::shared_ptr<wcs::Network>& net_ptr);
 
   WCS_LP_State(WCS_LP_State&& other) = default;
   WCS_LP_State& operator=(WCS_LP_State&& other) = default;
 
+  /**
+   * Build the tables of the species updates exchanged with other LPs, after
+   * the partition is set to the network. A species is shared by the LP that
+   * owns it and every LP that owns a reaction connected to it. Each of them
+   * keeps a copy of the species count, which must be updated whenever a
+   * reaction of any of them changes the count.
+   */
+  void build_boundary_tables();
+
+  /// Return the list of the species updates to send upon firing a reaction
+  std::pair<const WCS_Boundary_Update*, const WCS_Boundary_Update*>
+    get_sends(const wcs::v_idx_t ridx) const;
+  /// Return the list of the local reactions that read the given species
+  wcs::Network::affected_reactions_t get_readers(const wcs::v_idx_t sidx) const;
 };
 
 WCS_LP_State::WCS_LP_State(std::unique_ptr<wcs::SSA_NRM>&& ssa_ptr,
@@ -57,18 +94,36 @@ WCS_LP_State::WCS_LP_State(std::unique_ptr<wcs::SSA_NRM>&& ssa_ptr,
 /// Structure that contains global state variables
 struct WCS_Global_State
 {
-  SSA_Config m_cfg; ///< Configuration state made from command-line arguments
+  wcs::SSA_Params m_cfg; ///< Configuration made from command-line arguments
+  /// Partition id of each vertex in the order of vertices, if partitioned
+  std::vector<wcs::partition_id_t> m_parts;
   std::vector<WCS_LP_State> m_LP_states; ///< List of per-LP states
 };
 
 /// ROSS-facing structure that does not include any c++ member structure.
 struct WCS_State {
   size_t m_lp_idx;
+  /**
+   * Sequence number of the reaction event currently scheduled. A species
+   * update from another LP reschedules the next reaction, and the event
+   * scheduled earlier with an older number is ignored upon arrival.
+   */
+  unsigned long m_sched_seq;
+};
+
+/// Event type
+enum WCS_Event_Type {
+  WCS_EVT_FIRE = 0, ///< Fire a local reaction
+  WCS_EVT_UPDATE ///< Update a species changed by another LP
 };
 
 /// Event message type
 struct WCS_Message {
-  unsigned reaction;
+  unsigned type; ///< WCS_Event_Type
+  unsigned reaction; ///< Reaction to fire
+  unsigned long seq; ///< Sequence number of the reaction event
+  unsigned species; ///< Species to update
+  int delta; ///< Change in the species count
 };
 
 
@@ -102,12 +157,15 @@ tw_lptype wcs_LPs[] = {
 //  ROSS options
 //-----------------
 static unsigned int nlp_per_pe = 1u;
+static unsigned int partitioned = 0u;
 static char run_id[1024] = "wcs-ross";
 
 const tw_optdef app_opt[] =
 {
   TWOPT_GROUP("WCS ROSS"),
   TWOPT_UINT("nlp", nlp_per_pe, "Number of LPs per processor"),
+  TWOPT_UINT("partition", partitioned,
+             "Partition the network across LPs (1) or replicate it on each (0)"),
   TWOPT_CHAR("run", run_id, "User supplied run name"),
   TWOPT_END()
 };
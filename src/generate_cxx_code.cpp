@@ -43,7 +43,8 @@ int main(int argc, char** argv)
   const char* model_filename = argv[1];
   const bool gen_lib = (argc > 2) && (atoi(argv[2]) != 0);
   const bool show_error = (argc > 3) && (atoi(argv[3]) != 0);
-  const unsigned int chunk_size = ((argc > 4)? atoi(argv[4]) : 1000u);
+  // The chunk size of 0 lets the generator choose it
+  const unsigned int chunk_size = ((argc > 4)? atoi(argv[4]) : 0u);
   const std::string tmp_dir = ((argc > 5)? argv[5] : "/tmp");
   const unsigned int num_threads
     = ((argc > 6)? static_cast<unsigned>(atoi(argv[6])) : 0u);
@@ -69,7 +70,6 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
-  std::cout << "chunk size: " << chunk_size << std::endl;
   double t1 = wcs::get_time();
 
   const std::string lib_filename = wcs::get_libname_from_model(model_filename);
@@ -86,6 +86,9 @@ int main(int argc, char** argv)
 
   double t2 = wcs::get_time();
 
+  std::cout << "chunk size: " << code_generator.get_chunk_size()
+            << ((chunk_size == 0u)? " (chosen)" : "") << std::endl;
+
   std::cout << "Generated source filenames:";
   for (const auto& fn: code_generator.get_src_filenames()) {
     std::cout << ' ' << fn;
@@ -95,8 +98,8 @@ int main(int argc, char** argv)
             << " rate formula files) : " << t2-t1 << " (sec)" << std::endl;
 
   if (gen_lib) {
-    code_generator.compile_code();
-    std::cout << "library file: " << lib_filename << std::endl;
+    const std::string lib_built = code_generator.compile_code();
+    std::cout << "library file: " << lib_built << std::endl;
     double t3 = wcs::get_time();
     std::cout << "Time taken to compile: " << t3-t2 << " (sec)" << std::endl;
   }
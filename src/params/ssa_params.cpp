@@ -20,18 +20,27 @@
 
 namespace wcs {
 
-#define OPTIONS "df:g:hi:o:s:t:m:r:"
+#define OPTIONS "bc:de:f:g:hi:j:k:n:o:p:s:t:m:r:u:w:"
 static const struct option longopts[] = {
+    {"binary",   no_argument,        0, 'b'},
+    {"checkpoint", required_argument, 0, 'c'},
     {"diag",     no_argument,        0, 'd'},
+    {"epsilon",  required_argument,  0, 'e'},
     {"frag_sz",  required_argument,  0, 'f'},
     {"graphviz", required_argument,  0, 'g'},
     {"help",     no_argument,        0, 'h'},
     {"iter",     required_argument,  0, 'i'},
+    {"threads",  required_argument,  0, 'j'},
+    {"ckpt_file", required_argument, 0, 'k'},
+    {"replicas", required_argument,  0, 'n'},
     {"outfile",  required_argument,  0, 'o'},
+    {"profile",  required_argument,  0, 'p'},
     {"seed",     required_argument,  0, 's'},
     {"time",     required_argument,  0, 't'},
     {"method",   required_argument,  0, 'm'},
     {"record",   required_argument,  0, 'r'},
+    {"resume",   required_argument,  0, 'u'},
+    {"write_buf", required_argument, 0, 'w'},
     { 0, 0, 0, 0 },
 };
 
@@ -39,12 +48,19 @@ SSA_Params::SSA_Params()
 : m_seed(0u), m_max_iter(10u),
   m_max_time(wcs::max_sim_time),
   m_method(1),
+  m_tau_epsilon(0.03),
   m_tracing(false),
+  m_binary_trace(false),
   m_sampling(false),
   m_iter_interval(0u),
   m_time_interval(0.0),
   m_frag_size(0),
   m_is_frag_size_set(false),
+  m_num_write_buffers(0u),
+  m_ckpt_iter_interval(0u),
+  m_ckpt_wall_interval(0.0),
+  m_num_replicas(1u),
+  m_num_threads(0u),
   m_is_iter_set(false),
   m_is_time_set(false)
 {}
@@ -57,10 +73,30 @@ void SSA_Params::getopt(int& argc, char** &argv)
 
   while ((c = getopt_long(argc, argv, OPTIONS, longopts, NULL)) != -1) {
     switch (c) {
+      case 'b': /* --binary */
+        m_tracing = true;
+        m_binary_trace = true;
+        m_sampling = false;
+        break;
+      case 'c': /* --checkpoint */
+        if (optarg[0] == 'i') {
+          m_ckpt_iter_interval = static_cast<wcs::sim_iter_t>(atoi(&optarg[1]));
+        } else if (optarg[0] == 'w') {
+          m_ckpt_wall_interval = atof(&optarg[1]);
+        } else {
+          std::cerr << "Unknown checkpoint interval: " << std::string(optarg)
+                    << std::endl;
+          print_usage(argv[0], 1);
+        }
+        break;
       case 'd': /* --diag */
         m_tracing = true;
+        m_binary_trace = false;
         m_sampling = false;
         break;
+      case 'e': /* --epsilon */
+        m_tau_epsilon = static_cast<double>(std::stod(optarg));
+        break;
       case 'f': /* --frag_sz */
         m_frag_size = static_cast<unsigned>(atoi(optarg));
         m_is_frag_size_set = true;
@@ -75,9 +111,25 @@ void SSA_Params::getopt(int& argc, char** &argv)
         m_max_iter = static_cast<wcs::sim_iter_t>(atoi(optarg));
         m_is_iter_set = true;
         break;
+      case 'j': /* --threads */
+        m_num_threads = static_cast<unsigned>(atoi(optarg));
+        break;
+      case 'k': /* --ckpt_file */
+        m_ckpt_file = std::string(optarg);
+        break;
+      case 'n': /* --replicas */
+        m_num_replicas = static_cast<unsigned>(atoi(optarg));
+        if (m_num_replicas == 0u) {
+          std::cerr << "The number of replicas must be positive." << std::endl;
+          print_usage(argv[0], 1);
+        }
+        break;
       case 'o': /* --outfile */
         m_outfile = std::string(optarg);
         break;
+      case 'p': /* --profile */
+        m_profile_file = std::string(optarg);
+        break;
       case 's': /* --seed */
         m_seed = static_cast<unsigned>(atoi(optarg));
         break;
@@ -91,6 +143,7 @@ void SSA_Params::getopt(int& argc, char** &argv)
       case 'r': /* --record */
         m_sampling = true;
         m_tracing = false;
+        m_binary_trace = false;
         {
           if (optarg[0] == 'i') {
             m_iter_interval = static_cast<wcs::sim_iter_t>(atoi(&optarg[1]));
@@ -103,6 +156,16 @@ void SSA_Params::getopt(int& argc, char** &argv)
           }
         }
         break;
+      case 'u': /* --resume */
+        m_resume_file = std::string(optarg);
+        break;
+      case 'w': /* --write_buf */
+        m_num_write_buffers = static_cast<unsigned>(atoi(optarg));
+        if (m_num_write_buffers == 1u) {
+          std::cerr << "Asynchronous writes need at least 2 buffers." << std::endl;
+          print_usage(argv[0], 1);
+        }
+        break;
       default:
         print_usage(argv[0], 1);
         break;
@@ -122,6 +185,22 @@ void SSA_Params::getopt(int& argc, char** &argv)
   if ((m_sampling || m_tracing) && !m_is_frag_size_set) {
     m_frag_size = wcs::default_frag_size;
   }
+  if (m_ckpt_file.empty()) {
+    m_ckpt_file = m_outfile + ".ckpt";
+  }
+  if ((is_checkpointing() || !m_resume_file.empty()) && (m_num_replicas > 1u)) {
+    std::cerr << "Checkpointing is not supported for an ensemble." << std::endl;
+    print_usage(argv[0], 1);
+  }
+  if (!m_profile_file.empty() && (m_num_replicas > 1u)) {
+    std::cerr << "Profiling is not supported for an ensemble." << std::endl;
+    print_usage(argv[0], 1);
+  }
+}
+
+bool SSA_Params::is_checkpointing() const
+{
+  return (m_ckpt_iter_interval > 0u) || (m_ckpt_wall_interval > 0.0);
 }
 
 void SSA_Params::print_usage(const std::string exec, int code)
@@ -154,6 +233,30 @@ void SSA_Params::print_usage(const std::string exec, int code)
     "                                    1 = next reaction (default).\n"
     "                                    2 = Sorted optimized direct method."
     " (feat. propensity sorting)\n"
+    "                                    3 = Composition-rejection method."
+    " (feat. propensity binning)\n"
+    "                                    4 = Tau-leaping method."
+    " (approximate)\n"
+    "                                    5 = Partial-propensity direct method."
+    " (elementary reactions only)\n"
+    "\n"
+    "    -e, --epsilon\n"
+    "            Specify the error control parameter of the tau-leaping\n"
+    "            method, which bounds the relative change in propensities\n"
+    "            per leap (default 0.03).\n"
+    "\n"
+    "    -n, --replicas\n"
+    "            Specify the number of independent replicas to run in an\n"
+    "            ensemble. The network is loaded once per thread, and each\n"
+    "            replica is seeded with a distinct value derived from the\n"
+    "            seed given. The output of each replica is written into the\n"
+    "            file of which the name is that of the output file with\n"
+    "            '.r<replica id>' appended to the stem (default 1).\n"
+    "\n"
+    "    -j, --threads\n"
+    "            Specify the number of threads to run the replicas of an\n"
+    "            ensemble on. Without this, or with 0, the number of hardware\n"
+    "            threads is used.\n"
     "\n"
     "    -g, --graphviz\n"
     "            Specify the name of the file to export the reaction\n"
@@ -162,6 +265,12 @@ void SSA_Params::print_usage(const std::string exec, int code)
     "    -d, --diag\n"
     "            Specify whether to enable tracing for a posteriori diagnosis.\n"
     "\n"
+    "    -b, --binary\n"
+    "            Specify whether to enable tracing in the compact binary\n"
+    "            format, which streams events into the output file as they\n"
+    "            occur. Use `read_trace` to reconstruct the states.\n"
+    "            The fragment size is the number of events to buffer.\n"
+    "\n"
     "    -r, --record\n"
     "            Specify whether to enable sampling at a time/step interval.\n"
     "            (e.g. t5 for every 5 simulation seconds or i5 for every 5 steps).\n"
@@ -169,16 +278,44 @@ void SSA_Params::print_usage(const std::string exec, int code)
     "    -o, --outfile\n"
     "            Specify the output file name for tracing/sampling.\n"
     "\n"
+    "    -p, --profile\n"
+    "            Specify the file to write the activity profile into, which\n"
+    "            lists how many times each reaction fired and how many times\n"
+    "            each species was updated in the run. The partitioner uses\n"
+    "            it to weight the vertices and the edges of the network.\n"
+    "            A run resumed from a checkpoint counts only its own events.\n"
+    "\n"
     "    -f, --frag_sz\n"
     "            Specify how many records per temporary output file fragment \n"
     "            in tracing/sampling.\n"
+    "\n"
+    "    -c, --checkpoint\n"
+    "            Specify whether to save a checkpoint at an interval of\n"
+    "            iterations or wall-clock seconds (e.g. i100000 for every\n"
+    "            100000 steps or w600 for every 10 minutes). Both can be\n"
+    "            given. Only the methods 0, 1 and 2 support this.\n"
+    "\n"
+    "    -k, --ckpt_file\n"
+    "            Specify the checkpoint file name. Without this, '.ckpt' is\n"
+    "            appended to the output file name.\n"
+    "\n"
+    "    -u, --resume\n"
+    "            Specify the checkpoint file to resume from. The rest of the\n"
+    "            options must be the same as those of the run checkpointed,\n"
+    "            except the limits on the time and the iterations.\n"
+    "\n"
+    "    -w, --write_buf\n"
+    "            Specify the number of fragment buffers to write the fragments\n"
+    "            in the background, e.g., 2 for double buffering. The\n"
+    "            simulation waits only when all the buffers are full.\n"
+    "            Without this, or with 0, fragments are written synchronously.\n"
     "\n";
   exit(code);
 }
 
 void SSA_Params::print() const
 {
-  static const char* method_name[4] = {"DM", "NRM", "SOD", "Unknown"};
+  static const char* method_name[7] = {"DM", "NRM", "SOD", "CR", "TAU", "PDM", "Unknown"};
   using std::to_string;
   using std::string;
   string msg;
@@ -187,15 +324,25 @@ void SSA_Params::print() const
   msg += " - max_iter: " + to_string(m_max_iter) + "\n";
   msg += " - max_time: " + to_string(m_max_time) + "\n";
   msg += " - method: " + string{method_name[m_method]} + "\n";
+  msg += " - tau_epsilon: " + to_string(m_tau_epsilon) + "\n";
   msg += " - tracing: " + string{m_tracing? "true" : "false"} + "\n";
+  msg += " - binary_trace: " + string{m_binary_trace? "true" : "false"} + "\n";
   msg += " - sampling: " + string{m_sampling? "true" : "false"} + "\n";
   msg += " - iter_interval: " + to_string(m_iter_interval) + "\n";
   msg += " - time_interval: " + to_string(m_time_interval) + "\n";
   msg += " - frag_size: " + to_string(m_frag_size) + "\n";
   msg += " - is_frag_size_set: " + string{m_is_frag_size_set? "true" : "false"} + "\n";
+  msg += " - num_write_buffers: " + to_string(m_num_write_buffers) + "\n";
+  msg += " - ckpt_iter_interval: " + to_string(m_ckpt_iter_interval) + "\n";
+  msg += " - ckpt_wall_interval: " + to_string(m_ckpt_wall_interval) + "\n";
+  msg += " - ckpt_file: " + m_ckpt_file + "\n";
+  msg += " - resume_file: " + m_resume_file + "\n";
+  msg += " - num_replicas: " + to_string(m_num_replicas) + "\n";
+  msg += " - num_threads: " + to_string(m_num_threads) + "\n";
   msg += " - infile: " + m_infile + "\n";
   msg += " - outfile: " + m_outfile + "\n";
   msg += " - gvizfile: " + m_gvizfile + "\n";
+  msg += " - profile_file: " + m_profile_file + "\n";
   msg += " - is_iter_set: " + string{m_is_iter_set? "true" : "false"} + "\n";
   msg += " - is_time_set: " + string{m_is_time_set? "true" : "false"} + "\n";
 
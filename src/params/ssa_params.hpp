@@ -32,20 +32,42 @@ class SSA_Params {
   void print() const;
   void set_outfile(const std::string& ofname);
   std::string get_outfile() const;
+  /// Whether to save checkpoints periodically
+  bool is_checkpointing() const;
 
   unsigned m_seed;
   wcs::sim_iter_t m_max_iter;
   wcs::sim_time_t m_max_time;
   int m_method;
+  /// Error control parameter of tau-leaping
+  double m_tau_epsilon;
   bool m_tracing;
+  /// Whether to write the trace in the binary format
+  bool m_binary_trace;
   bool m_sampling;
   wcs::sim_iter_t m_iter_interval;
   wcs::sim_time_t m_time_interval;
   unsigned m_frag_size;
   bool m_is_frag_size_set;
+  /// Number of buffers to write fragments in the background (0 for sync)
+  unsigned m_num_write_buffers;
+  /// Checkpoint interval in iterations (0 to disable)
+  wcs::sim_iter_t m_ckpt_iter_interval;
+  /// Checkpoint interval in wall-clock seconds (0 to disable)
+  double m_ckpt_wall_interval;
+  /// File to save checkpoints into
+  std::string m_ckpt_file;
+  /// Checkpoint file to resume from, if not empty
+  std::string m_resume_file;
+  /// Number of independent replicas to run in an ensemble
+  unsigned m_num_replicas;
+  /// Number of threads to run the replicas on (0 for the hardware concurrency)
+  unsigned m_num_threads;
 
   std::string m_infile;
   std::string m_gvizfile;
+  /// File to write the activity profile into, if not empty
+  std::string m_profile_file;
 
   bool m_is_iter_set;
   bool m_is_time_set;
@@ -31,13 +31,14 @@ using idx_t = int;
 #endif // defined(WCS_HAS_METIS)
 
 
-#define OPTIONS "hb:cd:ei:mp:o:rs:u:v:"
+#define OPTIONS "hb:cd:ef:i:mp:o:rs:u:v:"
 static const struct option longopts[] = {
     {"help",      no_argument,        0, 'h'},
     {"ub_vwgt",   required_argument,  0, 'b'},
     {"cut_obj",   no_argument,        0, 'c'},
     {"dbglvl",    required_argument,  0, 'd'},
     {"embedded",  no_argument,        0, 'e'},
+    {"profile",   required_argument,  0, 'f'},
     {"n_iters",   required_argument,  0, 'i'},
     {"minconn",   no_argument,        0, 'm'},
     {"n_parts",   required_argument,  0, 'p'},
@@ -66,6 +67,7 @@ struct Config {
 
   std::string infile;
   std::string outfile;
+  std::string profile; ///< Activity profile to weight the graph by
 
   Config();
   void getopt(int& argc, char** &argv);
@@ -76,7 +78,7 @@ struct Config {
 Config::Config()
 : n_iters(10), n_parts(2), seed(7177), ufactor(300), ub_vwgt(1), vratio(1.0),
   rm_coarse(false), minconn(false), cut_obj(false), run_embedded(false),
-  verbose(false), dbglvl(0), infile(""), outfile("")
+  verbose(false), dbglvl(0), infile(""), outfile(""), profile("")
 {}
 
 void Config::getopt(int& argc, char** &argv)
@@ -100,6 +102,9 @@ void Config::getopt(int& argc, char** &argv)
       case 'e': /* --embedded */
         run_embedded = true;
         break;
+      case 'f': /* --profile */
+        profile = std::string(optarg);
+        break;
       case 'i': /* --n_iters */
         n_iters = static_cast<idx_t>(atoi(optarg));
         if (n_iters < static_cast<idx_t>(1)) {
@@ -166,6 +171,7 @@ void Config::print() const
   cout << " - dbglvl: " << dbglvl << endl;
   cout << " - infile: " << infile << endl;
   cout << " - outfile: " << outfile << endl;
+  cout << " - profile: " << profile << endl;
   cout << "===============================" << endl << endl;
 }
 
@@ -191,6 +197,11 @@ void Config::print_usage(const std::string exec, int code)
     "            Run a hard-coded example without using an input graph\n"
     "            The input graph file is ignored.\n"
     "\n"
+    "    -f, --profile\n"
+    "            Activity profile written by `ssa --profile` on the same\n"
+    "            network. Vertices and edges are weighted by the number of\n"
+    "            firings and updates in it instead of by the reaction rates.\n"
+    "\n"
     "    -i, --n_iters\n"
     "            Number of refinement iterations. 10 by default\n"
     "\n"
@@ -231,6 +242,7 @@ void set_metis_options(const Config& cfg, wcs::Metis_Params& mp)
                  cfg.ufactor, cfg.dbglvl);
   mp.limit_max_vertex_weight(cfg.ub_vwgt);
   mp.set_ratio_of_vertex_weight_to_size(cfg.vratio);
+  mp.set_profile(cfg.profile);
   mp.m_verbose = cfg.verbose;
   mp.m_outfile = cfg.outfile;
 }
@@ -0,0 +1,143 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include "partition/activity_profile.hpp"
+#include "utils/exception.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_partition
+ *  @{ */
+
+void Activity_Profile::set(const Network& net,
+                           const std::vector<count_t>& firings)
+{
+  const size_t num_reactions = net.get_num_reactions();
+  const size_t num_species = net.get_num_species();
+  if (firings.size() != num_reactions) {
+    WCS_THROW("The firing counts do not match the reactions of the network.");
+  }
+  const Network::graph_t& g = net.graph();
+
+  std::vector<count_t> updates(num_species, static_cast<count_t>(0u));
+  m_reactions.clear();
+  m_reactions.reserve(num_reactions);
+
+  for (size_t ridx = 0ul; ridx < num_reactions; ++ridx) {
+    const auto rd = net.reaction_i2d(static_cast<v_idx_t>(ridx));
+    const auto n = firings[ridx];
+    m_reactions.emplace_back(g[rd].get_label(), n);
+    if (n == static_cast<count_t>(0u)) continue;
+
+    for (const auto& u : net.get_reactant_updates(rd)) {
+      updates[u.first] += n;
+    }
+    for (const auto& u : net.get_product_updates(rd)) {
+      updates[u.first] += n;
+    }
+  }
+
+  m_species.clear();
+  m_species.reserve(num_species);
+  for (size_t sidx = 0ul; sidx < num_species; ++sidx) {
+    const auto sd = net.species_i2d(static_cast<v_idx_t>(sidx));
+    m_species.emplace_back(g[sd].get_label(), updates[sidx]);
+  }
+}
+
+void Activity_Profile::write(const std::string& filename) const
+{
+  std::ofstream ofs(filename);
+  if (!ofs) {
+    WCS_THROW("Failed to open " + filename);
+  }
+
+  for (const auto& r : m_reactions) {
+    ofs << "R\t" << r.second << '\t' << r.first << '\n';
+  }
+  for (const auto& s : m_species) {
+    ofs << "S\t" << s.second << '\t' << s.first << '\n';
+  }
+  if (!ofs) {
+    WCS_THROW("Failed to write " + filename);
+  }
+}
+
+void Activity_Profile::read(const std::string& filename)
+{
+  std::ifstream ifs(filename);
+  if (!ifs) {
+    WCS_THROW("Failed to open " + filename);
+  }
+  m_reactions.clear();
+  m_species.clear();
+
+  std::string line;
+  size_t line_no = 0ul;
+
+  while (std::getline(ifs, line)) {
+    line_no ++;
+    if (line.empty() || (line[0] == '#')) continue;
+
+    std::istringstream iss(line);
+    std::string kind;
+    count_t n = static_cast<count_t>(0u);
+    std::string label;
+    iss >> kind >> n;
+    // The label is the rest of the line after the separating tab
+    if (iss.get() != '\t' || !std::getline(iss, label) || label.empty() ||
+        ((kind != "R") && (kind != "S"))) {
+      WCS_THROW("Invalid entry at line " + std::to_string(line_no) + " of " +
+                filename);
+    }
+    auto& entries = ((kind == "R")? m_reactions : m_species);
+    entries.emplace_back(std::move(label), n);
+  }
+}
+
+void Activity_Profile::map_to(const Network& net, std::vector<count_t>& firings,
+                              std::vector<count_t>& updates) const
+{
+  const Network::graph_t& g = net.graph();
+  size_t num_matched = 0ul;
+
+  auto lookup = [&](const std::vector<entry_t>& entries,
+                    const Network::map_idx2desc_t& vertices,
+                    std::vector<count_t>& counts)
+  {
+    std::unordered_map<std::string, count_t> by_label;
+    by_label.reserve(entries.size());
+    for (const auto& e : entries) {
+      by_label.emplace(e.first, e.second);
+    }
+
+    counts.assign(vertices.size(), static_cast<count_t>(0u));
+    for (size_t i = 0ul; i < vertices.size(); ++i) {
+      const auto it = by_label.find(g[vertices[i]].get_label());
+      if (it != by_label.cend()) {
+        counts[i] = it->second;
+        num_matched ++;
+      }
+    }
+  };
+
+  // The reaction list and the species list are in the order of the index
+  lookup(m_reactions, net.reaction_list(), firings);
+  lookup(m_species, net.species_list(), updates);
+
+  if (num_matched == 0ul) {
+    WCS_THROW("The activity profile does not match the network.");
+  }
+}
+
+/**@}*/
+} // end of namespace wcs
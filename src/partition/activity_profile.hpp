@@ -0,0 +1,78 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef __WCS_PARTITION_ACTIVITY_PROFILE_HPP__
+#define __WCS_PARTITION_ACTIVITY_PROFILE_HPP__
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "reaction_network/network.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_partition
+ *  @{ */
+
+/**
+ * Activity of a reaction network measured in a simulation run, i.e., how many
+ * times each reaction fired and how many times the count of each species
+ * changed. This guides the partitioning to balance the actual event load and
+ * to keep the busy species together with the reactions that update them.
+ *
+ * The profile is written as a text file of which each line consists of the
+ * kind of the vertex ('R' for reaction or 'S' for species), the count, and
+ * the label of the vertex separated by a tab. It refers to the vertices by
+ * the label such that it remains valid for the same model in another format.
+ */
+class Activity_Profile {
+ public:
+  using count_t = uint64_t;
+  using entry_t = std::pair<std::string, count_t>;
+
+  /**
+   * Take the number of firings of each reaction in the order of the reaction
+   * index, and derive the number of updates of each species from it. A
+   * firing updates a species once for each side of the reaction, reactants
+   * or products, in which the count of the species changes.
+   */
+  void set(const Network& net, const std::vector<count_t>& firings);
+
+  void write(const std::string& filename) const;
+  void read(const std::string& filename);
+
+  /**
+   * Look up the counts of the reactions and the species of the given network
+   * by the label, and return those in the order of the reaction index and of
+   * the species index respectively. A vertex not found in the profile gets
+   * zero. Throw an exception if the profile shares no vertex with the network.
+   */
+  void map_to(const Network& net, std::vector<count_t>& firings,
+              std::vector<count_t>& updates) const;
+
+  const std::vector<entry_t>& reactions() const { return m_reactions; }
+  const std::vector<entry_t>& species() const { return m_species; }
+
+ protected:
+  /// Number of firings by the reaction label
+  std::vector<entry_t> m_reactions;
+  /// Number of updates by the species label
+  std::vector<entry_t> m_species;
+};
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_PARTITION_ACTIVITY_PROFILE_HPP__
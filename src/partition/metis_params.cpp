@@ -48,7 +48,7 @@ void Metis_Params::make_options_consistent()
     // Partitioning objective: comm volumne
     m_opts[METIS_OPTION_OBJTYPE] = METIS_OBJTYPE_VOL;
   }
-  if (m_vwgt_max == m_vwgt_min) {
+  if ((m_vwgt_max == m_vwgt_min) && m_profile.empty()) {
     m_nvwghts = 0;
   } else {
     m_nvwghts = 1;
@@ -77,6 +77,12 @@ void Metis_Params::set_ratio_of_vertex_weight_to_size(double r)
   make_options_consistent();
 }
 
+void Metis_Params::set_profile(const std::string& profile)
+{
+  m_profile = profile;
+  make_options_consistent();
+}
+
 /// Specify the number of desired partitions and the input graph
 bool Metis_Params::set(idx_t np, std::shared_ptr<wcs::Network> rnet)
 {
@@ -170,6 +176,7 @@ void Metis_Params::print() const
   std::cout << " - Vertex weight lower-bound: " << m_vwgt_min << std::endl;
   std::cout << " - Vertex weight upper-bound: " << m_vwgt_max << std::endl;
   std::cout << " - Ratio of vertex weight to size: " << m_ratio_w2s << std::endl;
+  std::cout << " - Activity profile: " << m_profile << std::endl;
 
   std::cout << " - Objective: " << objective_str.at(m_opts[METIS_OPTION_OBJTYPE]) << std::endl;
   std::cout << " - Coarsening: " << coarsening_str.at(m_opts[METIS_OPTION_CTYPE]) << std::endl;
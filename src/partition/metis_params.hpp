@@ -21,6 +21,7 @@
 #include <metis.h>
 #include <array>
 #include <memory>
+#include <string>
 #include "reaction_network/network.hpp"
 
 namespace wcs {
@@ -35,6 +36,8 @@ class Metis_Params {
   idx_t m_vwgt_min;
   idx_t m_vwgt_max; ///< Upper-bound on the vertex weight
   double m_ratio_w2s; ///< ratio of vertex weight to vertex size
+  /// Activity profile to weight the vertices and the edges by, if not empty
+  std::string m_profile;
   std::shared_ptr<wcs::Network> m_rnet; ///< Reaction network
   bool m_verbose; ///< Show extra info about partitioning
   /** Name of partition result file. `-` followed by the partition index will
@@ -75,6 +78,17 @@ class Metis_Params {
    * the default), then the vertex size is not used in partitioning.
    */
   void set_ratio_of_vertex_weight_to_size(double r);
+  /**
+   * Weight the graph by the activity profile written by a simulation run of
+   * the same network instead of by the reaction rates. The vertex weight of
+   * a reaction maps from the number of its firings, and the weight of an
+   * edge maps from the number of the firings of the reaction plus that of the
+   * updates of the species at the two ends. Thus, the partitioning balances
+   * the actual event load, and avoids cutting the busy edges. If the upper
+   * bound of the vertex weight is the same as the lower bound, a default
+   * range is used.
+   */
+  void set_profile(const std::string& profile);
 
   idx_t get_seed() const;
   void print() const;
@@ -17,8 +17,11 @@
 // Only enable when METIS is available
 #if defined(WCS_HAS_METIS)
 #include <set>
+#include <algorithm>
 #include <cstddef> // NULL used in Metis
+#include <limits>
 #include <string>
+#include <tuple>
 #include "partition/metis_partition.hpp"
 #include "utils/exception.hpp"
 
@@ -51,7 +54,23 @@ void Metis_Partition::prepare()
   m_num_vertices = (m_p.m_rnet)->get_num_vertices();
   build_map_from_desc_to_idx();
   populate_adjacny_list();
+  load_profile();
   populate_vertex_info();
+  populate_edge_weights();
+}
+
+
+void Metis_Partition::load_profile()
+{
+  m_firings.clear();
+  m_updates.clear();
+  if (m_p.m_profile.empty()) {
+    return;
+  }
+
+  Activity_Profile profile;
+  profile.read(m_p.m_profile);
+  profile.map_to(*(m_p.m_rnet), m_firings, m_updates);
 }
 
 
@@ -164,7 +183,9 @@ void Metis_Partition::populate_adjacny_list()
  * constraint). In case of a species vertex, we assign the minimum value
  * possible for its weight, which is 1 as it needs to be a non-zero positive
  * integral value. In case of a reaction vertex, we linearly convert the
- * floating-point rate into an integer value.
+ * floating-point rate into an integer value. With an activity profile, the
+ * number of firings of the reaction measured in a simulation run is used in
+ * place of the rate.
  */
 void Metis_Partition::populate_vertex_info()
 {
@@ -186,12 +207,32 @@ void Metis_Partition::populate_vertex_info()
   // Vertex sizes (used in com_puting communication volumne)
   m_vsize.clear();
 
-  if (vwgt_max == vwgt_min) {
+  const bool use_profile = !m_firings.empty();
+
+  if ((vwgt_max == vwgt_min) && !use_profile) {
     return;
   }
 
-  // Min, max, and sum of reaction rates
-  const auto [r_min, r_max, r_sum] = m_p.m_rnet->find_min_max_rate();
+  // Min, max, and sum of reaction rates, or of the firings in the profile
+  reaction_rate_t r_min = static_cast<reaction_rate_t>(0);
+  reaction_rate_t r_max = static_cast<reaction_rate_t>(0);
+  reaction_rate_t r_sum = static_cast<reaction_rate_t>(0);
+
+  if (use_profile) {
+    r_min = std::numeric_limits<reaction_rate_t>::max();
+    for (const auto n : m_firings) {
+      const auto r = static_cast<reaction_rate_t>(n);
+      r_min = std::min(r_min, r);
+      r_max = std::max(r_max, r);
+      r_sum += r;
+    }
+    if (r_max <= static_cast<reaction_rate_t>(0)) {
+      WCS_THROW("No reaction fired in the activity profile!");
+      return;
+    }
+  } else {
+    std::tie(r_min, r_max, r_sum) = m_p.m_rnet->find_min_max_rate();
+  }
 
   // Upper bound of vertex weight representation
   constexpr idx_t vwgt_ub = std::numeric_limits<idx_t>::max() - 1;
@@ -237,8 +278,11 @@ void Metis_Partition::populate_vertex_info()
   // Largest possible width
   idx_t width = (vwgt_ub - vwgt_min * n_vertices) * r_ratio;
   // Adjust width if requested
-  if ((vwgt_max > static_cast<idx_t>(0)) &&
-      (width + vwgt_min > vwgt_max))
+  if (vwgt_max == vwgt_min) {
+    // Only with the profile, of which the range of weights is not given
+    width = std::min(width, profile_wgt_width);
+  } else if ((vwgt_max > static_cast<idx_t>(0)) &&
+             (width + vwgt_min > vwgt_max))
   {
     width = vwgt_max - vwgt_min;
   }
@@ -252,9 +296,15 @@ void Metis_Partition::populate_vertex_info()
     const auto vt = static_cast<v_prop_t::vertex_type>(v.get_typeid());
 
     if (vt == v_prop_t::_reaction_) {
-      const auto& rv = graph[*vi]; // vertex (property) of the reaction
-      const auto& rp = rv.property<r_prop_t>(); // detailed vertex property data
-      const auto r = rp.get_rate();
+      reaction_rate_t r = static_cast<reaction_rate_t>(0);
+      if (use_profile) {
+        r = static_cast<reaction_rate_t>
+              (m_firings[m_p.m_rnet->reaction_d2i(*vi)]);
+      } else {
+        const auto& rv = graph[*vi]; // vertex (property) of the reaction
+        const auto& rp = rv.property<r_prop_t>(); // detailed vertex property
+        r = rp.get_rate();
+      }
       const idx_t vwgt = vwgt_min + static_cast<idx_t>(width * r/r_max);
       m_vwgt.push_back(vwgt);
     } else {
@@ -278,6 +328,70 @@ void Metis_Partition::populate_vertex_info()
 }
 
 
+/*
+ * An edge connects a reaction and a species. When the reaction fires, it
+ * updates the species, and when the species is updated, the propensity of
+ * the reaction changes. If the edge is cut, each of these events becomes a
+ * message between the partitions. Thus, the weight of an edge is linearly
+ * mapped from the number of the firings of the reaction plus that of the
+ * updates of the species in the activity profile. As the sum of the weights
+ * needs to be representable by idx_t, the range of the weights is limited
+ * similarly to that of the vertex weights.
+ */
+void Metis_Partition::populate_edge_weights()
+{
+  m_adjwgt.clear();
+  if (m_firings.empty()) {
+    return;
+  }
+
+  const graph_t& graph = (m_p.m_rnet)->graph();
+  const auto& rnet = *(m_p.m_rnet);
+
+  // Activity of each edge in the same order as the adjacency list
+  std::vector<count_t> activity;
+  activity.reserve(m_adjncy.size());
+  count_t a_max = static_cast<count_t>(0u);
+
+  for (size_t i = 1ul; i < m_xadj.size(); ++i) {
+    const auto& vd = m_idx2vd.at(i-1);
+    const bool is_reaction = (static_cast<v_prop_t::vertex_type>
+                               (graph[vd].get_typeid()) == v_prop_t::_reaction_);
+
+    for (auto j = m_xadj[i-1]; j < m_xadj[i]; ++j) {
+      const auto& vd_connected = m_idx2vd.at(m_adjncy[j]);
+      const auto& rd = (is_reaction? vd : vd_connected);
+      const auto& sd = (is_reaction? vd_connected : vd);
+      const count_t a = m_firings[rnet.reaction_d2i(rd)]
+                      + m_updates[rnet.species_d2i(sd)];
+      activity.push_back(a);
+      a_max = std::max(a_max, a);
+    }
+  }
+
+  // Minimum edge weight (needs to be non-zero positive interger)
+  constexpr idx_t adjwgt_min = static_cast<idx_t>(1);
+  // Upper bound of edge weight representation
+  constexpr idx_t adjwgt_ub = std::numeric_limits<idx_t>::max() - 1;
+  const auto n_entries = static_cast<idx_t>(activity.size());
+
+  if (n_entries == static_cast<idx_t>(0)) {
+    return;
+  }
+  // Largest width with which the sum of the weights does not exceed adjwgt_ub
+  const idx_t width
+    = std::min((adjwgt_ub - adjwgt_min * n_entries) / n_entries,
+               profile_wgt_width);
+
+  m_adjwgt.reserve(activity.size());
+  for (const auto a : activity) {
+    const double ratio = ((a_max == static_cast<count_t>(0u))?
+                          0.0 : static_cast<double>(a) / a_max);
+    m_adjwgt.push_back(adjwgt_min + static_cast<idx_t>(width * ratio));
+  }
+}
+
+
 bool Metis_Partition::check_run(const int ret, const bool verbose)
 {
   std::string msg;
@@ -315,10 +429,11 @@ bool Metis_Partition::run(std::vector<idx_t>& parts, idx_t& objval)
 
   idx_t* vwgt_ptr = (m_vwgt.empty()? NULL : m_vwgt.data());
   idx_t* vsize_ptr = (m_vsize.empty()? NULL : m_vsize.data());
+  idx_t* adjwgt_ptr = (m_adjwgt.empty()? NULL : m_adjwgt.data());
 
   int ret
     = METIS_PartGraphKway(&nvtxs, &(m_p.m_nvwghts), m_xadj.data(), m_adjncy.data(),
-                          vwgt_ptr, vsize_ptr, NULL, &(m_p.m_nparts), NULL,
+                          vwgt_ptr, vsize_ptr, adjwgt_ptr, &(m_p.m_nparts), NULL,
                           NULL, m_p.m_opts.data(), &objval, parts.data());
 
   return check_run(ret);
@@ -27,6 +27,7 @@
 #include <type_traits> // is_same
 #include "reaction_network/network.hpp"
 #include "partition/metis_params.hpp"
+#include "partition/activity_profile.hpp"
 
 namespace wcs {
 /** \addtogroup wcs_partition
@@ -82,6 +83,13 @@ class Metis_Partition {
   using v_prop_t = wcs::Network::v_prop_t;
   using r_prop_t = wcs::Network::r_prop_t;
   using reaction_rate_t = wcs::reaction_rate_t;
+  using count_t = Activity_Profile::count_t;
+
+  /**
+   * Range of the weights mapped from the activity profile when the upper
+   * bound of the vertex weight is not given
+   */
+  static constexpr idx_t profile_wgt_width = static_cast<idx_t>(1000);
 
   /**
    * Build a map from the BGL vertex descriptor to the sequential index of
@@ -90,8 +98,12 @@ class Metis_Partition {
   void build_map_from_desc_to_idx();
   /// Populate the adjacency list in compressed storage format for Metis
   void populate_adjacny_list();
+  /// Load the activity profile, and map its counts to the vertices
+  void load_profile();
   /// Populate the list of vertex weights and the list of vertex sizes
   void populate_vertex_info();
+  /// Populate the list of edge weights from the activity profile
+  void populate_edge_weights();
 
  protected:
   static constexpr bool is_bidirectional
@@ -116,6 +128,13 @@ class Metis_Partition {
   std::vector<idx_t> m_vwgt;
   /// Vertex sizes used in computing communication volume
   std::vector<idx_t> m_vsize;
+  /// Edge weights in the same order as the adjacency list
+  std::vector<idx_t> m_adjwgt;
+
+  /// Number of firings of each reaction by the reaction index in the profile
+  std::vector<count_t> m_firings;
+  /// Number of updates of each species by the species index in the profile
+  std::vector<count_t> m_updates;
 
   /// Number of undirected edges recognized by Metis partitioning
   size_t m_num_edges;
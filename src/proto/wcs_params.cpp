@@ -31,6 +31,7 @@ static void set_metis_options(const wcs_proto::WCS_Params::Partition_Params& cfg
                  cfg.ufactor(), cfg.dbglvl());
   mp.limit_max_vertex_weight(cfg.ub_vwgt());
   mp.set_ratio_of_vertex_weight_to_size(cfg.vratio());
+  mp.set_profile(cfg.profile());
   mp.m_verbose = cfg.verbose();
   mp.m_outfile = cfg.outfile();
 
@@ -19,9 +19,16 @@
 #include "utils/input_filetype.hpp"
 #include "utils/generate_cxx_code.hpp"
 #include "utils/timer.hpp"
-#include <type_traits> // is_same<>
+#include "utils/state_io.hpp"
+#include "utils/streamvec.hpp"
+#include "utils/detect_methods.hpp"
+#include <type_traits> // is_same<>, is_integral<>
 #include <algorithm> // lexicographical_compare(), sort()
 #include <limits> // numeric_limits
+#include <cstdint>
+#include <fstream>
+#include <iterator> // istreambuf_iterator
+#include <dlfcn.h> // dlopen
 
 #if defined(WCS_HAS_SBML)
 #include <sbml/SBMLTypes.h>
@@ -32,6 +39,54 @@ namespace wcs {
 /** \addtogroup wcs_reaction_network
  *  @{ */
 
+namespace {
+/**
+ * Look up the index of a vertex from a dense table using the vertex
+ * descriptor as the position. This is only valid when the vertex descriptor
+ * is an integral sequence number as with the `vecS` vertex list.
+ */
+template <typename VD>
+inline const v_idx_t& dense_d2i(const std::vector<v_idx_t>& table, const VD d)
+{
+  return table[d];
+}
+
+template <typename VD>
+inline v_idx_t& dense_d2i(std::vector<v_idx_t>& table, const VD d)
+{
+  return table[d];
+}
+
+/// Write a string with the length prefixed
+void write_string(std::ostream& os, const std::string& str)
+{
+  const uint64_t len = static_cast<uint64_t>(str.size());
+  os << bits(len);
+  os.write(str.data(), static_cast<std::streamsize>(len));
+}
+
+/// Read a string written by write_string()
+void read_string(std::istream& is, std::string& str)
+{
+  uint64_t len = 0ull;
+  is >> bits(len);
+  if (!is) {
+    return;
+  }
+  str.resize(static_cast<size_t>(len));
+  is.read(&str[0], static_cast<std::streamsize>(len));
+}
+} // end of anonymous namespace
+
+/// Version of the network snapshot layout
+static constexpr uint32_t snapshot_version = 1u;
+/// Whether the rates are computed by the formulas compiled via ExprTk
+#if defined(WCS_HAS_EXPRTK)
+static constexpr bool snapshot_by_exprtk = true;
+#else
+static constexpr bool snapshot_by_exprtk = false;
+#endif // defined(WCS_HAS_EXPRTK)
+
 sim_time_t Network::m_etime_ulimit = std::numeric_limits<sim_time_t>::infinity();
 
 void Network::load(const std::string filename, const bool reuse)
@@ -42,6 +97,8 @@ void Network::load(const std::string filename, const bool reuse)
     loadGraphML(filename);
   } else if (filetype == input_filetype::input_type::_sbml_) {
     loadSBML(filename, reuse);
+  } else if (filetype == input_filetype::input_type::_snapshot_) {
+    loadSnapshot(filename);
   } else if (filetype == input_filetype::input_type::_ioerror_) {
     WCS_THROW("Could not find the requested file.");
     return;
@@ -59,13 +116,10 @@ void Network::loadGraphML(const std::string graphml_filename)
   WCS_THROW("Must enable ExprTk for .graphml files.");
   return;
   #endif
-  ::wcs::GraphFactory gfactory;
-
-  if (!gfactory.read_graphml(graphml_filename)) {
+  if (!::wcs::GraphFactory::read_graphml(graphml_filename, m_graph)) {
     WCS_THROW("Failed to read " + graphml_filename);
     return;
   }
-  gfactory.copy_to(m_graph);
 }
 
 void Network::print_parameters_of_reactions(
@@ -158,6 +212,7 @@ void Network::loadSBML(const std::string sbml_filename, const bool reuse)
         m_dep_params_f, m_dep_params_nf, m_rate_rules_dep_map);
 
   const std::string library_file = code_generator.compile_code();
+  m_library_file = library_file;
 
   using std::operator<<;
   std::cerr << "Constructing a graph from the SBML model ..." << std::endl;
@@ -168,6 +223,10 @@ void Network::loadSBML(const std::string sbml_filename, const bool reuse)
                       m_dep_params_f, m_dep_params_nf,
                       m_rate_rules_dep_map);
 
+  #if defined(WCS_JIT_BATCH_RATES)
+  load_rate_kernels(library_file);
+  #endif // defined(WCS_JIT_BATCH_RATES)
+
   #else
   gfactory.convert_to(*model, m_graph, "",{},{},{});
   #endif // !defined(WCS_HAS_EXPRTK)
@@ -181,11 +240,338 @@ void Network::loadSBML(const std::string sbml_filename, const bool reuse)
 
 }
 
+/**
+ * The snapshot consists of a header, the vertices in the order of iteration,
+ * the edges in the order added, the lists of species and reactions by their
+ * positions in the vertex order, and the rate inputs of every reaction in the
+ * compressed sparse row format indexed by the reaction index. Strings are
+ * prefixed by the length.
+ */
+void Network::save_snapshot(const std::string& filename) const
+{
+  if (m_rate_input_offsets.size() != m_reactions.size() + 1ul) {
+    WCS_THROW("The network must be initialized before taking a snapshot.");
+  }
+
+  std::vector<char> buffer;
+  {
+    wcs::ostreamvec<char> ostrmbuf(buffer);
+    std::ostream os(&ostrmbuf);
+
+    os.write(input_filetype::snapshot_magic,
+             sizeof(input_filetype::snapshot_magic));
+    os << bits(snapshot_version) << bits(snapshot_by_exprtk);
+    write_string(os, m_library_file);
+
+    // Position of each vertex in the order of iteration
+    std::unordered_map<v_desc_t, uint64_t> vpos;
+    vpos.reserve(get_num_vertices());
+
+    const uint64_t num_vertices = static_cast<uint64_t>(get_num_vertices());
+    os << bits(num_vertices);
+
+    v_iter_t vi, vi_end;
+    for (boost::tie(vi, vi_end) = boost::vertices(m_graph); vi != vi_end; ++vi) {
+      const uint64_t pos = static_cast<uint64_t>(vpos.size());
+      vpos.emplace(*vi, pos);
+
+      const v_prop_t& v = m_graph[*vi];
+      const int tid = v.get_typeid();
+      os << bits(tid);
+      write_string(os, v.get_label());
+
+      const auto vt = static_cast<v_prop_t::vertex_type>(tid);
+      if (vt == v_prop_t::_species_) {
+        os << bits(v.property<Species>().get_count());
+      } else if (vt == v_prop_t::_reaction_) {
+        const auto& rp = v.property<r_prop_t>();
+        os << bits(rp.get_rate_constant());
+        write_string(os, rp.get_rate_formula());
+      }
+    }
+
+    // Follow the order in which the edges have been added, such that both
+    // the in-edges and the out-edges of every vertex keep their order.
+    const uint64_t num_edges = static_cast<uint64_t>(boost::num_edges(m_graph));
+    os << bits(num_edges);
+    for (const auto& e : m_graph.m_edges) {
+      const uint64_t src = vpos.at(e.m_source);
+      const uint64_t dst = vpos.at(e.m_target);
+      const e_prop_t& ep = e.get_property();
+      os << bits(src) << bits(dst) << bits(ep.get_stoichiometry_ratio());
+      write_string(os, ep.get_label());
+    }
+
+    std::vector<uint64_t> species(m_species.size());
+    for (size_t i = 0ul; i < m_species.size(); ++i) {
+      species[i] = vpos.at(m_species[i]);
+    }
+    std::vector<uint64_t> reactions(m_reactions.size());
+    for (size_t i = 0ul; i < m_reactions.size(); ++i) {
+      reactions[i] = vpos.at(m_reactions[i]);
+    }
+    os << bits(species) << bits(reactions);
+
+    std::vector<uint64_t> input_offsets;
+    std::vector<uint64_t> inputs;
+    std::vector<stoic_t> input_stoic;
+    input_offsets.reserve(m_reactions.size() + 1ul);
+    input_offsets.push_back(0ull);
+    for (const auto& rd : m_reactions) {
+      const auto& rp = m_graph[rd].property<r_prop_t>();
+      for (const auto& ri : rp.get_rate_inputs()) {
+        inputs.push_back(vpos.at(ri.first));
+        input_stoic.push_back(ri.second);
+      }
+      input_offsets.push_back(static_cast<uint64_t>(inputs.size()));
+    }
+    os << bits(input_offsets) << bits(inputs) << bits(input_stoic);
+
+    if (!os) {
+      WCS_THROW("Failed to serialize the snapshot.");
+    }
+  }
+
+  std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+  ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  ofs.close();
+  if (!ofs) {
+    WCS_THROW("Failed to write the snapshot " + filename);
+  }
+}
+
+void Network::loadSnapshot(const std::string snapshot_filename)
+{
+  std::ifstream ifs(snapshot_filename, std::ios::binary);
+  if (!ifs) {
+    WCS_THROW("Failed to open the snapshot " + snapshot_filename);
+  }
+  const std::vector<char> buffer((std::istreambuf_iterator<char>(ifs)),
+                                 std::istreambuf_iterator<char>());
+  wcs::istreamvec<char> istrmbuf(buffer);
+  std::istream is(&istrmbuf);
+
+  char magic[sizeof(input_filetype::snapshot_magic)] = {'\0'};
+  uint32_t version = 0u;
+  bool by_exprtk = false;
+  is.read(magic, sizeof(magic));
+  is >> bits(version) >> bits(by_exprtk);
+  if (!is || !std::equal(magic, magic + sizeof(magic),
+                         input_filetype::snapshot_magic)) {
+    WCS_THROW(snapshot_filename + " is not a network snapshot.");
+  }
+  if (version != snapshot_version) {
+    WCS_THROW("Unsupported snapshot version " + std::to_string(version));
+  }
+  if (by_exprtk != snapshot_by_exprtk) {
+    WCS_THROW(std::string("The snapshot requires a build ") +
+              (by_exprtk? "with" : "without") + " ExprTk.");
+  }
+  read_string(is, m_library_file);
+
+  uint64_t num_vertices = 0ull;
+  is >> bits(num_vertices);
+  if (!is) {
+    WCS_THROW("The snapshot " + snapshot_filename + " is truncated.");
+  }
+
+  if constexpr (has_reserve_for_vertex_list<graph_t>::value) {
+    m_graph.m_vertices.reserve(num_vertices);
+  }
+  // The vertex descriptor by the position in the snapshot
+  std::vector<v_desc_t> vds;
+  vds.reserve(num_vertices);
+
+  for (uint64_t i = 0ull; i < num_vertices; ++i) {
+    int tid = 0;
+    std::string label;
+    species_cnt_t count = static_cast<species_cnt_t>(0u);
+    reaction_rate_t rate_const = static_cast<reaction_rate_t>(0.0);
+    std::string formula;
+
+    is >> bits(tid);
+    read_string(is, label);
+    const auto vt = static_cast<v_prop_t::vertex_type>(tid);
+    if (vt == v_prop_t::_species_) {
+      is >> bits(count);
+    } else if (vt == v_prop_t::_reaction_) {
+      is >> bits(rate_const);
+      read_string(is, formula);
+    }
+    if (!is) {
+      WCS_THROW("The snapshot " + snapshot_filename + " is truncated.");
+    }
+
+    VertexFlat flat;
+    flat.set_type(static_cast<VertexFlat::vertex_type>(tid));
+    flat.set_label(label);
+    flat.set_rate_constant(rate_const);
+    flat.set_rate_formula(formula);
+    const v_desc_t vd = boost::add_vertex(v_prop_t{flat, m_graph}, m_graph);
+    if (vt == v_prop_t::_species_) {
+      // The count of the flat vertex is not wide enough
+      m_graph[vd].property<Species>().set_count(count);
+    }
+    vds.push_back(vd);
+  }
+
+  uint64_t num_edges = 0ull;
+  is >> bits(num_edges);
+  for (uint64_t i = 0ull; is && (i < num_edges); ++i) {
+    uint64_t src = 0ull;
+    uint64_t dst = 0ull;
+    stoic_t stoic = static_cast<stoic_t>(0);
+    std::string label;
+    is >> bits(src) >> bits(dst) >> bits(stoic);
+    read_string(is, label);
+    if (!is || (src >= num_vertices) || (dst >= num_vertices)) {
+      WCS_THROW("The snapshot " + snapshot_filename + " is corrupted.");
+    }
+    boost::add_edge(vds[src], vds[dst], e_prop_t{stoic, label}, m_graph);
+  }
+
+  std::vector<uint64_t> species;
+  std::vector<uint64_t> reactions;
+  std::vector<uint64_t> input_offsets;
+  std::vector<uint64_t> inputs;
+  std::vector<stoic_t> input_stoic;
+  is >> bits(species) >> bits(reactions)
+     >> bits(input_offsets) >> bits(inputs) >> bits(input_stoic);
+
+  if (!is || (input_offsets.size() != reactions.size() + 1ul) ||
+      (inputs.size() != input_stoic.size()) ||
+      (input_offsets.back() != inputs.size())) {
+    WCS_THROW("The snapshot " + snapshot_filename + " is corrupted.");
+  }
+
+  const auto to_desc = [&](const uint64_t pos) {
+    if (pos >= num_vertices) {
+      WCS_THROW("The snapshot " + snapshot_filename + " is corrupted.");
+    }
+    return vds[pos];
+  };
+
+  m_species.clear();
+  m_species.reserve(species.size());
+  for (const auto pos : species) {
+    m_species.push_back(to_desc(pos));
+  }
+  m_reactions.clear();
+  m_reactions.reserve(reactions.size());
+  for (const auto pos : reactions) {
+    m_reactions.push_back(to_desc(pos));
+  }
+
+  m_snapshot_inputs.assign(reactions.size(), {});
+  for (size_t i = 0ul; i < reactions.size(); ++i) {
+    auto& rinputs = m_snapshot_inputs[i];
+    rinputs.reserve(input_offsets[i+1] - input_offsets[i]);
+    for (auto j = input_offsets[i]; j < input_offsets[i+1]; ++j) {
+      rinputs.emplace_back(to_desc(inputs[j]), input_stoic[j]);
+    }
+  }
+
+  #if !defined(WCS_HAS_EXPRTK)
+  // Look up the rate function of each reaction in the library referred to
+  std::string library_name = m_library_file;
+  if (library_name.find_first_of("/") == std::string::npos) {
+    library_name = "./" + library_name;
+  }
+  void* handle = dlopen(library_name.c_str(), RTLD_LAZY);
+  if (!handle) {
+    WCS_THROW("Cannot open library '" + library_name + "': " \
+              + std::string(dlerror()) + "\n");
+    return;
+  }
+  dlerror();
+
+  for (const auto& rd : m_reactions) {
+    const std::string rate_function = "wcs__rate_" + m_graph[rd].get_label();
+    void * const reaction_function_rate = dlsym(handle, rate_function.c_str());
+    const char *dlsym_error = dlerror();
+    if (dlsym_error) {
+      WCS_THROW("Cannot load symbol " + rate_function + ": " + dlsym_error + "\n");
+      return;
+    }
+    m_graph[rd].property<r_prop_t>().set_calc_rate_fn(
+      reinterpret_cast<rate_function_pointer>(reaction_function_rate));
+  }
+
+  #if defined(WCS_JIT_BATCH_RATES)
+  load_rate_kernels(m_library_file);
+  #endif // defined(WCS_JIT_BATCH_RATES)
+  #endif // !defined(WCS_HAS_EXPRTK)
+
+  m_from_snapshot = true;
+}
+
+void Network::init_from_snapshot()
+{
+  std::vector<std::string> names;
+
+  for (size_t i = 0ul; i < m_reactions.size(); ++i) {
+    const v_desc_t reaction = m_reactions[i];
+    const auto& inputs = m_snapshot_inputs[i];
+
+    names.clear();
+    for (const auto& in : inputs) {
+      names.emplace_back(m_graph[in.first].get_label());
+    }
+
+    s_involved_t products;
+    for(const auto ei_out :
+        boost::make_iterator_range(boost::out_edges(reaction, m_graph))) {
+      v_desc_t product = boost::target(ei_out, m_graph);
+      products.insert(std::make_pair(m_graph[product].get_label(),
+                                     std::make_pair(product, 1)));
+    }
+
+    auto& r = m_graph[reaction].checked_property< Reaction<v_desc_t> >();
+    r.restore_rate_inputs(inputs, names);
+    r.set_products(products);
+  }
+
+  m_snapshot_inputs.clear();
+  m_snapshot_inputs.shrink_to_fit();
+  m_from_snapshot = false;
+}
+
 void Network::init()
 {
   #if !defined(WCS_HAS_EXPRTK) && !defined(WCS_HAS_SBML)
   WCS_THROW("Must enable either ExprTk or SBML.");
   #endif
+  if (m_from_snapshot) {
+    // The lists of reactions and species have been restored as they were,
+    // with the species already sorted.
+    init_from_snapshot();
+  } else {
+    init_from_graph();
+    sort_species();
+  }
+  build_index_maps();
+
+ #if defined(WCS_JIT_BATCH_RATES)
+  // The kernels refer to the reactions by the order in the SBML model, which
+  // is the order that the reactions are added to the graph, and thus listed
+  // here. Make sure that the kernels cover every reaction.
+  if ((m_rates_chunk > 0u) &&
+      (static_cast<size_t>(m_rates_chunk) * m_rates_chunk_fns.size()
+         < m_reactions.size())) {
+    std::cerr << "The batched rate kernels do not cover every reaction. "
+              << "Using the function of each reaction instead." << std::endl;
+    m_rates_chunk = static_cast<v_idx_t>(0u);
+  }
+ #endif // defined(WCS_JIT_BATCH_RATES)
+
+  build_state_arrays();
+
+  m_pid = unassigned_partition;
+  build_dependency_graph();
+}
+
+void Network::init_from_graph()
+{
   const size_t num_vertices = get_num_vertices();
 
   m_reactions.reserve(num_vertices);
@@ -296,15 +682,8 @@ void Network::init()
       #endif // !defined(WCS_HAS_EXPRTK)
 
       r.set_products(products);
-
-      set_reaction_rate(*vi);
     }
   }
-
-  sort_species();
-  build_index_maps();
-
-  m_pid = unassigned_partition;
 }
 
 /// Overwrite the reaction rate to a given value
@@ -314,70 +693,159 @@ void Network::set_reaction_rate(const Network::v_desc_t r,
   const auto& rv = m_graph[r]; // vertex (property) of the reaction
   auto& rp = rv.property<r_prop_t>(); // detailed vertex property data
   rp.set_rate(rate);
+  m_reaction_rates[reaction_d2i(r)] = rate;
 }
 
 /**
  * Computes the reaction rate based on the population of the reaction driving
  * species and the reaction constant.
+ * The species counts are gathered directly from the dense array using the
+ * precomputed indices of the rate inputs into the parameter buffer of the
+ * reaction, which avoids any memory allocation.
+ * A reaction may take a same reactant species multiple times. e.g., X + X -> Y
+ * In such a case, the formula accounts for it, e.g., as [X]([X]-1)/2
  */
 reaction_rate_t Network::set_reaction_rate(const Network::v_desc_t r) const
 {
-  auto & rprop = m_graph[r].checked_property< Reaction<v_desc_t> >();
-  const auto& ri = rprop.get_rate_inputs();
-  std::vector<reaction_rate_t> params;
-  // GG: rate constant is part of the Reaction object
-  params.reserve(ri.size()+1u); // reserve space for species count and rate constant
-
-  for (auto driver : ri) { // add species counts here and the rate constant will be appended later
-    const auto& s = m_graph[driver.first].checked_property<Species>();
-    const stoic_t num_same = driver.second;
-    // A reaction may take a same reactant species multiple times.
-    // e.g., X + X -> Y
-    // In such a case, num_same_reactants is more than 1. Two in the example.
-    // In the example, the reaction rate is computed as [X]([X]-1)/2
-    // TODO: move this logic into ReactionBase::set_rate_fn()
-    species_cnt_t n = s.get_count();
-
-    if (num_same == static_cast<stoic_t>(0)) {
-        // This is a parameter that the reaction rate is dependent on but
-        // not modified by the reaction (i.e., neither reactant nor product)
-        params.push_back(static_cast<reaction_rate_t>(n));
-    } else {
-      params.push_back(static_cast<reaction_rate_t>(n));
-    }
+  const auto ridx = reaction_d2i(r);
+
+ #if defined(WCS_JIT_BATCH_RATES)
+  if (m_rates_chunk > 0u) {
+    calc_rates_by_kernels(&ridx, 1ul);
+    sync_reaction_rates(&ridx, 1ul);
+    return m_reaction_rates[ridx];
+  }
+ #endif // defined(WCS_JIT_BATCH_RATES)
+
+  // The type of the property has been checked while building the input table
+  auto& rprop = m_graph[r].property<r_prop_t>();
+  const auto rate = rprop.calc_rate(m_species_counts.data(),
+                      m_rate_input_idx.data() + m_rate_input_offsets[ridx]);
+  m_reaction_rates[ridx] = rate;
+  return rate;
+}
+
+void Network::set_reaction_rates(const v_idx_t* const ridx,
+                                 const size_t n) const
+{
+ #if defined(WCS_JIT_BATCH_RATES)
+  if (m_rates_chunk > 0u) {
+    calc_rates_by_kernels(ridx, n);
+    sync_reaction_rates(ridx, n);
+    return;
+  }
+ #endif // defined(WCS_JIT_BATCH_RATES)
+  for (size_t i = 0ul; i < n; ++i) {
+    set_reaction_rate(m_reactions[ridx[i]]);
   }
-  return rprop.calc_rate(std::move(params));
 }
 
 double Network::compute_all_reaction_rates(const unsigned n) const
 {
   double t_start = get_time();
+ #if defined(WCS_JIT_BATCH_RATES)
+  if (m_rates_chunk > 0u) {
+    for (unsigned i = 0u; i < n; i++) {
+      for (const auto& fn : m_rates_chunk_fns) {
+        fn(m_species_counts.data(), m_rate_input_idx.data(),
+           m_rate_input_offsets.data(), m_reaction_rates.data());
+      }
+    }
+    for (size_t i = 0ul; i < m_reactions.size(); ++i) {
+      auto& rprop = m_graph[m_reactions[i]].property<r_prop_t>();
+      rprop.set_rate(m_reaction_rates[i]);
+    }
+    return get_time() - t_start;
+  }
+ #endif // defined(WCS_JIT_BATCH_RATES)
   for (unsigned i = 0u; i < n; i++) {
     for (const auto& r: reaction_list()) {
-      auto & rprop = m_graph[r].checked_property< Reaction<v_desc_t> >();
-      const auto& ri = rprop.get_rate_inputs();
-      std::vector<reaction_rate_t> params;
-      // GG: rate constant is part of the Reaction object
-      params.reserve(ri.size()+1u); // reserve space for species count and rate constant
-
-      for (auto driver : ri) { // add species counts here and the rate constant will be appended later
-        const auto& s = m_graph[driver.first].checked_property<Species>();
-        //const stoic_t num_same = driver.second;
-        species_cnt_t n = s.get_count();
-        params.push_back(static_cast<reaction_rate_t>(n));
-      }
-
-      rprop.calc_rate(std::move(params));
+      set_reaction_rate(r);
     }
   }
   return get_time() - t_start;
 }
 
+#if defined(WCS_JIT_BATCH_RATES)
+void Network::load_rate_kernels(const std::string& library_file)
+{
+  m_rates_chunk = static_cast<v_idx_t>(0u);
+  m_rates_chunk_fns.clear();
+  m_rates_list_fns.clear();
+
+  std::string library_name = library_file;
+  if (library_name.find_first_of("/") == std::string::npos) {
+    library_name = "./" + library_name;
+  }
+  // This only adds a reference to the library that has been already opened
+  // while constructing the graph.
+  void* handle = dlopen(library_name.c_str(), RTLD_LAZY);
+  if (!handle) {
+    WCS_THROW("Cannot open library '" + library_name + "': " \
+              + std::string(dlerror()) + "\n");
+    return;
+  }
+  dlerror();
+
+  const auto* const chunk_size = reinterpret_cast<const unsigned int*>(
+                                   dlsym(handle, "wcs__rates_chunk_size"));
+  const auto* const num_chunks = reinterpret_cast<const unsigned int*>(
+                                   dlsym(handle, "wcs__rates_num_chunks"));
+  if ((chunk_size == nullptr) || (num_chunks == nullptr) ||
+      (*chunk_size == 0u)) {
+    dlerror();
+    std::cerr << "No batched rate kernel is found in " << library_name
+              << ". Regenerate the library to use them." << std::endl;
+    return;
+  }
+
+  m_rates_chunk_fns.resize(*num_chunks);
+  m_rates_list_fns.resize(*num_chunks);
+  for (unsigned int k = 0u; k < *num_chunks; ++k) {
+    const std::string chunk_fn = "wcs__rates_chunk_" + std::to_string(k);
+    const std::string list_fn = "wcs__rates_list_" + std::to_string(k);
+    m_rates_chunk_fns[k]
+      = reinterpret_cast<rates_chunk_fn_t>(dlsym(handle, chunk_fn.c_str()));
+    m_rates_list_fns[k]
+      = reinterpret_cast<rates_list_fn_t>(dlsym(handle, list_fn.c_str()));
+    const char *dlsym_error = dlerror();
+    if (dlsym_error) {
+      WCS_THROW("Cannot load symbol " + chunk_fn + ": " + dlsym_error + "\n");
+      return;
+    }
+  }
+  m_rates_chunk = static_cast<v_idx_t>(*chunk_size);
+}
+
+void Network::calc_rates_by_kernels(const v_idx_t* const ridx,
+                                    const size_t n) const
+{
+  for (size_t i = 0ul; i < n; ) {
+    const auto k = ridx[i] / m_rates_chunk;
+    size_t j = i + 1ul;
+    while ((j < n) && (ridx[j] / m_rates_chunk == k)) {
+      ++j;
+    }
+    m_rates_list_fns[k](m_species_counts.data(), m_rate_input_idx.data(),
+                        m_rate_input_offsets.data(), ridx + i, j - i,
+                        m_reaction_rates.data());
+    i = j;
+  }
+}
+
+void Network::sync_reaction_rates(const v_idx_t* const ridx,
+                                  const size_t n) const
+{
+  for (size_t i = 0ul; i < n; ++i) {
+    auto& rprop = m_graph[m_reactions[ridx[i]]].property<r_prop_t>();
+    rprop.set_rate(m_reaction_rates[ridx[i]]);
+  }
+}
+#endif // defined(WCS_JIT_BATCH_RATES)
+
 reaction_rate_t Network::get_reaction_rate(const Network::v_desc_t r) const
 {
-  const auto& rv = m_graph[r]; // vertex (property) of the reaction
-  const auto& rp = rv.property<r_prop_t>(); // detailed vertex property data
-  return rp.get_rate();
+  return m_reaction_rates[reaction_d2i(r)];
 }
 
 void Network::sort_species()
@@ -469,24 +937,19 @@ bool Network::check_reaction(const wcs::Network::v_desc_t r) const
     return false;
   }
 
-  // reactant species
-  for (const auto ei_in : boost::make_iterator_range(boost::in_edges(r, m_graph))) {
-    const auto vd_reactant = boost::source(ei_in, m_graph);
-    const auto& sv_reactant = m_graph[vd_reactant];
-    if constexpr (wcs::Vertex::_num_vertex_types_  > 3) {
-      // in case that there are other type of vertices than species or reaction
-      if (sv_reactant.get_type() != wcs::Vertex::_species_) continue;
-    }
+  const auto max_count = Species::get_max_count();
 
-    const auto& sp_reactant = sv_reactant.property<Species>();
-    const auto stoichio = m_graph[ei_in].get_stoichiometry_ratio();
-    if (!sp_reactant.dec_check(stoichio)) {
+  // reactant species
+  for (const auto& u : get_reactant_updates(r)) {
+    const auto stoichio = static_cast<species_cnt_t>(u.second);
+    if (m_species_counts[u.first] < stoichio) {
      #if 0  // change to 1 to take all messages (0 default)
       using std::operator>>;
       std::cerr << "reaction " << m_graph[r].get_label()
                 << " has insufficient amount of reactants "
-                << sv_reactant.get_label() << " (" << stoichio << " < "
-                << sp_reactant.get_count() << ")" << std::endl;
+                << m_graph[species_i2d(u.first)].get_label() << " ("
+                << stoichio << " < " << m_species_counts[u.first] << ")"
+                << std::endl;
      #endif
       // check if reaction is possible, i.e., decrement is possible
       set_reaction_rate(r, 0.0);
@@ -495,17 +958,9 @@ bool Network::check_reaction(const wcs::Network::v_desc_t r) const
   }
 
   // product species
-  for (const auto ei_out : boost::make_iterator_range(boost::out_edges(r, m_graph))) {
-    const auto vd_product = boost::target(ei_out, m_graph);
-    const auto& sv_product = m_graph[vd_product];
-    if constexpr (wcs::Vertex::_num_vertex_types_  > 3) {
-      // in case that there are other type of vertices than species or reaction
-      if (sv_product.get_type() != wcs::Vertex::_species_) continue;
-    }
-
-    const auto& sp_product = sv_product.property<Species>();
-    const auto stoichio = m_graph[ei_out].get_stoichiometry_ratio();
-    if (!sp_product.inc_check(stoichio)) {
+  for (const auto& u : get_product_updates(r)) {
+    const auto stoichio = static_cast<species_cnt_t>(u.second);
+    if ((max_count - m_species_counts[u.first]) < stoichio) {
       // check if reaction is possible, i.e., increment is possible
       using std::operator>>;
       std::cerr << "reaction " << m_graph[r].get_label()
@@ -532,10 +987,7 @@ Network::find_min_max_rate() const
   reaction_rate_t r_max = std::numeric_limits<reaction_rate_t>::min();
   reaction_rate_t r_sum = static_cast<reaction_rate_t>(0);
 
-  for(const auto& vd : reaction_list()) {
-    const auto& rv = m_graph[vd]; // vertex (property) of the reaction
-    const auto& rp = rv.property<r_prop_t>(); // detailed vertex property data
-    const auto r = rp.get_rate();
+  for(const auto r : m_reaction_rates) {
     r_min = std::min(r_min, r);
     r_max = std::max(r_max, r);
     r_sum += r;
@@ -586,10 +1038,8 @@ std::string Network::show_reaction_rates() const
   std::string str;
   str.reserve(get_num_reactions()*15);
 
-  for(const auto& vd : reaction_list()) {
-    const auto& rv = m_graph[vd]; // vertex (property) of the reaction
-    const auto& rp = rv.property<r_prop_t>(); // detailed vertex property data
-    str += '\t' + std::to_string(rp.get_rate());
+  for(const auto r : m_reaction_rates) {
+    str += '\t' + std::to_string(r);
   }
   return str;
 }
@@ -631,6 +1081,152 @@ void Network::build_index_maps()
       m_r_idx_map[rd] = ridx++;
     }
   }
+  if constexpr (std::is_integral<v_desc_t>::value) {
+    m_v_idx.assign(get_num_vertices(), static_cast<v_idx_t>(0u));
+    for (const auto& x : m_s_idx_map) {
+      dense_d2i(m_v_idx, x.first) = x.second;
+    }
+    for (const auto& x : m_r_idx_map) {
+      dense_d2i(m_v_idx, x.first) = x.second;
+    }
+  }
+}
+
+void Network::build_state_arrays()
+{
+  m_species_counts.assign(m_species.size(), static_cast<species_cnt_t>(0));
+  m_reaction_rates.assign(m_reactions.size(), static_cast<reaction_rate_t>(0));
+
+  v_idx_t sidx = static_cast<v_idx_t>(0u);
+  for (const auto& sd : m_species) {
+    auto& s = m_graph[sd].checked_property<Species>();
+    s.bind_count(&m_species_counts[sidx++]);
+  }
+
+  m_rate_input_offsets.clear();
+  m_rate_input_offsets.reserve(m_reactions.size() + 1u);
+  m_rate_input_idx.clear();
+  m_rate_input_offsets.push_back(0ul);
+
+  for (const auto& rd : m_reactions) {
+    const auto& rp = m_graph[rd].checked_property<r_prop_t>();
+    for (const auto& driver : rp.get_rate_inputs()) {
+      m_rate_input_idx.push_back(species_d2i(driver.first));
+    }
+    m_rate_input_offsets.push_back(m_rate_input_idx.size());
+  }
+
+  for (const auto& rd : m_reactions) {
+    set_reaction_rate(rd);
+  }
+}
+
+void Network::build_dependency_graph()
+{
+  const size_t num_reactions = m_reactions.size();
+
+  m_update_offsets.clear();
+  m_update_offsets.reserve(2ul * num_reactions + 1ul);
+  m_species_updates.clear();
+  m_dep_offsets.clear();
+  m_dep_offsets.reserve(num_reactions + 1ul);
+  m_dep_reactions.clear();
+
+  m_update_offsets.push_back(0ul);
+  m_dep_offsets.push_back(0ul);
+
+  reaction_list_t affected;
+
+  auto add_affected = [&](const v_desc_t rd, const v_desc_t sd) {
+    for (const auto ei :
+         boost::make_iterator_range(boost::out_edges(sd, m_graph)))
+    {
+      const auto rd_affected = boost::target(ei, m_graph);
+      if (rd_affected == rd) continue;
+     #if (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
+      if ((m_pid != unassigned_partition) &&
+          (m_graph[rd_affected].get_partition() != m_pid)) continue;
+     #endif // (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
+      affected.push_back(rd_affected);
+    }
+  };
+
+  for (const auto& rd : m_reactions) {
+    affected.clear();
+
+    // reactant species
+    for (const auto ei_in :
+         boost::make_iterator_range(boost::in_edges(rd, m_graph)))
+    {
+      const auto sd = boost::source(ei_in, m_graph);
+      if constexpr (wcs::Vertex::_num_vertex_types_  > 3) {
+        // in case that there are other type of vertices than species or reaction
+        if (m_graph[sd].get_type() != wcs::Vertex::_species_) continue;
+      }
+      const auto stoichio = m_graph[ei_in].get_stoichiometry_ratio();
+      if (stoichio == static_cast<stoic_t>(0)) {
+        continue;
+      }
+      m_species_updates.emplace_back(species_d2i(sd), stoichio);
+      add_affected(rd, sd);
+    }
+    m_update_offsets.push_back(m_species_updates.size());
+
+    // product species
+    for (const auto ei_out :
+         boost::make_iterator_range(boost::out_edges(rd, m_graph)))
+    {
+      const auto sd = boost::target(ei_out, m_graph);
+      if constexpr (wcs::Vertex::_num_vertex_types_  > 3) {
+        // in case that there are other type of vertices than species or reaction
+        if (m_graph[sd].get_type() != wcs::Vertex::_species_) continue;
+      }
+      const auto stoichio = m_graph[ei_out].get_stoichiometry_ratio();
+      if (stoichio == static_cast<stoic_t>(0)) {
+        continue;
+      }
+      m_species_updates.emplace_back(species_d2i(sd), stoichio);
+      add_affected(rd, sd);
+    }
+    m_update_offsets.push_back(m_species_updates.size());
+
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()),
+                   affected.end());
+    m_dep_reactions.insert(m_dep_reactions.end(),
+                           affected.begin(), affected.end());
+    m_dep_offsets.push_back(m_dep_reactions.size());
+  }
+
+  m_species_updates.shrink_to_fit();
+  m_dep_reactions.shrink_to_fit();
+}
+
+Network::affected_reactions_t
+Network::get_affected_reactions(const v_desc_t r) const
+{
+  const auto ridx = reaction_d2i(r);
+  return boost::make_iterator_range(
+           m_dep_reactions.data() + m_dep_offsets[ridx],
+           m_dep_reactions.data() + m_dep_offsets[ridx + 1ul]);
+}
+
+Network::species_updates_range_t
+Network::get_reactant_updates(const v_desc_t r) const
+{
+  const auto ridx = 2ul * reaction_d2i(r);
+  return boost::make_iterator_range(
+           m_species_updates.data() + m_update_offsets[ridx],
+           m_species_updates.data() + m_update_offsets[ridx + 1ul]);
+}
+
+Network::species_updates_range_t
+Network::get_product_updates(const v_desc_t r) const
+{
+  const auto ridx = 2ul * reaction_d2i(r) + 1ul;
+  return boost::make_iterator_range(
+           m_species_updates.data() + m_update_offsets[ridx],
+           m_species_updates.data() + m_update_offsets[ridx + 1ul]);
 }
 
 const Network::map_desc2idx_t& Network::get_reaction_map() const
@@ -645,7 +1241,11 @@ const Network::map_desc2idx_t& Network::get_species_map() const
 
 v_idx_t Network::reaction_d2i(v_desc_t d) const
 {
-  return m_r_idx_map.at(d);
+  if constexpr (std::is_integral<v_desc_t>::value) {
+    return dense_d2i(m_v_idx, d);
+  } else {
+    return m_r_idx_map.at(d);
+  }
 }
 
 Network::v_desc_t Network::reaction_i2d(v_idx_t i) const
@@ -655,7 +1255,11 @@ Network::v_desc_t Network::reaction_i2d(v_idx_t i) const
 
 v_idx_t Network::species_d2i(v_desc_t d) const
 {
-  return m_s_idx_map.at(d);
+  if constexpr (std::is_integral<v_desc_t>::value) {
+    return dense_d2i(m_v_idx, d);
+  } else {
+    return m_s_idx_map.at(d);
+  }
 }
 
 Network::v_desc_t Network::species_i2d(v_idx_t i) const
@@ -663,6 +1267,61 @@ Network::v_desc_t Network::species_i2d(v_idx_t i) const
   return m_species.at(i);
 }
 
+const std::vector<species_cnt_t>& Network::species_counts() const
+{
+  return m_species_counts;
+}
+
+const std::vector<reaction_rate_t>& Network::reaction_rates() const
+{
+  return m_reaction_rates;
+}
+
+void Network::reset_species_counts(const std::vector<species_cnt_t>& counts)
+{
+  if (counts.size() != m_species_counts.size()) {
+    WCS_THROW("The number of species counts given (" +
+              std::to_string(counts.size()) + ") does not match that of " +
+              "the species in the network (" +
+              std::to_string(m_species_counts.size()) + ")");
+  }
+  std::copy(counts.cbegin(), counts.cend(), m_species_counts.begin());
+
+  for (const auto& rd : m_reactions) {
+    set_reaction_rate(rd);
+  }
+}
+
+species_cnt_t Network::species_count(const v_idx_t sidx) const
+{
+  return m_species_counts[sidx];
+}
+
+reaction_rate_t Network::reaction_rate(const v_idx_t ridx) const
+{
+  return m_reaction_rates[ridx];
+}
+
+bool Network::inc_species_count(const v_idx_t sidx, const species_cnt_t c)
+{
+  auto& cnt = m_species_counts[sidx];
+  if ((Species::get_max_count() - cnt) < c) {
+    return false;
+  }
+  cnt += c;
+  return true;
+}
+
+bool Network::dec_species_count(const v_idx_t sidx, const species_cnt_t c)
+{
+  auto& cnt = m_species_counts[sidx];
+  if (cnt < c) {
+    return false;
+  }
+  cnt -= c;
+  return true;
+}
+
 void Network::set_partition(const map_idx2desc_t& idx2vd,
                             const std::vector<partition_id_t>& parts,
                             const partition_id_t my_pid)
@@ -697,6 +1356,10 @@ void Network::set_partition(const map_idx2desc_t& idx2vd,
       }
     }
   }
+ #if (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
+  // Only the local reactions are to be updated
+  build_dependency_graph();
+ #endif // (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
 }
 
 void Network::set_partition(const std::vector<partition_id_t>& parts,
@@ -736,6 +1399,38 @@ void Network::set_partition(const std::vector<partition_id_t>& parts,
     // TODO: else if it is not connected to any local vertex
     // deallocate the proporty specific to the vertex type
   }
+ #if (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
+  // Only the local reactions are to be updated
+  build_dependency_graph();
+ #endif // (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
+}
+
+void Network::set_partition(const std::vector<partition_id_t>& parts)
+{
+  if (get_num_vertices() != parts.size()) {
+    std::string errmsg =
+      "Inconsistent sizes between the number of vertices and the number of partitions!";
+    WCS_THROW(errmsg);
+    return;
+  }
+  const bool was_local = (m_pid != unassigned_partition);
+  m_pid = unassigned_partition;
+  m_my_reactions.clear();
+  m_my_species.clear();
+
+  size_t i = 0u;
+  v_iter_t vi, vi_end;
+
+  for (boost::tie(vi, vi_end) = boost::vertices(m_graph); vi != vi_end; ++vi) {
+    m_graph[*vi].set_partition(parts[i++]);
+  }
+ #if (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
+  if (was_local) { // Restore the dependencies on non-local reactions
+    build_dependency_graph();
+  }
+ #else
+  (void) was_local;
+ #endif // (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
 }
 
 const Network::reaction_list_t& Network::my_reaction_list() const
@@ -814,7 +1509,7 @@ void Network::print() const
 
     num_inactive += static_cast<size_t>(inactive);
     if (inactive) {
-      m_graph[vd].property<r_prop_t>().set_rate(0.0);
+      set_reaction_rate(vd, 0.0);
     }
 
     std::cout << std::endl << "    by the rate " << rp.get_rate()
@@ -27,6 +27,8 @@
 #include <string>
 #include <unordered_map>
 #include <tuple>
+#include <vector>
+#include <boost/range/iterator_range.hpp>
 #include "bgl.hpp"
 #include "reaction_network/species.hpp"
 #include "reaction_network/reaction.hpp"
@@ -90,6 +92,15 @@ class Network {
   /// Map a BGL vertex descriptor to the reaction index
   using map_desc2idx_t = std::unordered_map<v_desc_t, v_idx_t>;
 
+  /// Read-only view of the reactions affected by firing a reaction
+  using affected_reactions_t = boost::iterator_range<const v_desc_t*>;
+  /// Species update by a reaction as a pair of the species index and the amount
+  using species_update_t = std::pair<v_idx_t, stoic_t>;
+  using species_updates_t = std::vector<species_update_t>;
+  /// Read-only view of the species updates made by firing a reaction
+  using species_updates_range_t
+    = boost::iterator_range<const species_update_t*>;
+
  public:
   /** Load an input model file.
    *  We primarily support SBML as the formats of an input file. However,
@@ -99,12 +110,29 @@ class Network {
    *  in a previous run, by default, we skip the generation of a new library
    *  file and reuse the existing library file. Setting the second argument
    *  `reuse` to false forces regeneration.
+   *  A binary snapshot written by save_snapshot() is also accepted, which
+   *  skips parsing the model and interpreting the rate formulas.
    */
   void load(const std::string graphml_filename, const bool reuse = true);
   void init();
+  /**
+   * Write a compact binary snapshot of this network, which must have been
+   * initialized. It contains the topology, the stoichiometries, the labels,
+   * the initial species counts, the rate constants and formulas, the order
+   * of the rate inputs of each reaction, and the path to the library of the
+   * rate functions generated if any. The library is referred to, but not
+   * embedded, and thus must remain available to load the snapshot.
+   */
+  void save_snapshot(const std::string& filename) const;
   void set_reaction_rate(const v_desc_t r, const reaction_rate_t rate) const;
   reaction_rate_t set_reaction_rate(const v_desc_t r) const;
   reaction_rate_t get_reaction_rate(const v_desc_t r) const;
+  /**
+   * Recompute the rates of the reactions at the given indices. With the
+   * batched kernels of the rate code generated, each run of the consecutive
+   * indices that belong to a same chunk is evaluated in a single call.
+   */
+  void set_reaction_rates(const v_idx_t* const ridx, const size_t n) const;
   /** Computes reaction rate of every reaction `n' number of times and returns
     * total execution time */
   double compute_all_reaction_rates(const unsigned n = 1u) const;
@@ -144,6 +172,52 @@ class Network {
   v_idx_t species_d2i(v_desc_t d) const;
   v_desc_t species_i2d(v_idx_t i) const;
 
+  /// Allow read-only access to the dense array of species counts
+  const std::vector<species_cnt_t>& species_counts() const;
+  /// Allow read-only access to the dense array of reaction rates
+  const std::vector<reaction_rate_t>& reaction_rates() const;
+  /// Return the count of the species at the given index
+  species_cnt_t species_count(const v_idx_t sidx) const;
+  /// Return the rate of the reaction at the given index
+  reaction_rate_t reaction_rate(const v_idx_t ridx) const;
+  /**
+   * Increase the count of the species at the given index by the amount c.
+   * Return false without updating if it would exceed the maximum allowed.
+   */
+  bool inc_species_count(const v_idx_t sidx, const species_cnt_t c);
+  /**
+   * Decrease the count of the species at the given index by the amount c.
+   * Return false without updating if there are not as many.
+   */
+  bool dec_species_count(const v_idx_t sidx, const species_cnt_t c);
+  /**
+   * Overwrite every species count with the given list in the order of the
+   * species index, and recompute the rate of every reaction. This allows
+   * rerunning a simulation from the initial state saved without reloading
+   * the network.
+   */
+  void reset_species_counts(const std::vector<species_cnt_t>& counts);
+
+  /**
+   * Return the list of the reactions of which the propensity may change by
+   * firing the given reaction, excluding the reaction itself. These are the
+   * reactions that take as an input any of the species of which the count
+   * changes by the given reaction. The list is sorted by the vertex
+   * descriptor without any duplicate.
+   */
+  affected_reactions_t get_affected_reactions(const v_desc_t r) const;
+  /**
+   * Return the list of reactant species of the given reaction with the
+   * amount by which each decreases when the reaction fires. Species of zero
+   * stoichiometry (e.g., enzymes) are not included.
+   */
+  species_updates_range_t get_reactant_updates(const v_desc_t r) const;
+  /**
+   * Return the list of product species of the given reaction with the
+   * amount by which each increases when the reaction fires.
+   */
+  species_updates_range_t get_product_updates(const v_desc_t r) const;
+
   /**
    * Set the partition id to each vertex (of both reaction and species types),
    * using the the list of partition ids ordered as the vertex descriptors
@@ -157,6 +231,12 @@ class Network {
 
   void set_partition(const std::vector<partition_id_t>& parts,
                      const partition_id_t my_pid);
+  /**
+   * Set the partition id to each vertex in the order of vertices without
+   * choosing the local partition, such that this network can be shared among
+   * all the partitions. The dependency graph remains to cover every reaction.
+   */
+  void set_partition(const std::vector<partition_id_t>& parts);
   /**
    * Allow read-only access to the list of reactions that belong to this
    * partition.
@@ -172,13 +252,47 @@ class Network {
   /// Sort the species list by the label (in lexicogrphical order)
   void sort_species();
   void build_index_maps();
+  /**
+   * Allocate the dense arrays of species counts and reaction rates, and bind
+   * the count of each species to its entry in the array. Build the table of
+   * the species indices of the rate inputs of every reaction. Then, compute
+   * the initial rate of every reaction.
+   */
+  void build_state_arrays();
+  /**
+   * Build the static dependency graph among reactions as well as the table
+   * of the species updates by each reaction, both in the compressed sparse
+   * row format indexed by the reaction index. When running partitions using
+   * OpenMP or ROSS, only the reactions local to this partition are considered
+   * to be affected.
+   */
+  void build_dependency_graph();
+  /// Add the vertices of the graph to the lists of reactions and species
+  void init_from_graph();
+  /// Set up the reactions using the rate inputs restored from a snapshot
+  void init_from_snapshot();
   void loadGraphML(const std::string graphml_filename);
+  /// Rebuild the graph directly from the binary snapshot
+  void loadSnapshot(const std::string snapshot_filename);
   void loadSBML(const std::string sbml_filename, const bool reuse = true);
   static void print_parameters_of_reactions(
              const params_map_t& dep_params_f,
              const params_map_t& dep_params_nf,
              const rate_rules_dep_t& rate_rules_dep_map);
 
+ #if defined(WCS_JIT_BATCH_RATES)
+  /**
+   * Look up the batched rate kernels in the library of the generated code.
+   * If not found, e.g., in a library generated without them, rates are
+   * computed via the function of each reaction.
+   */
+  void load_rate_kernels(const std::string& library_file);
+  /// Evaluate the rates of the listed reactions using the batched kernels
+  void calc_rates_by_kernels(const v_idx_t* const ridx, const size_t n) const;
+  /// Copy the rates computed by the kernels into the reaction properties
+  void sync_reaction_rates(const v_idx_t* const ridx, const size_t n) const;
+ #endif // defined(WCS_JIT_BATCH_RATES)
+
  protected:
   /// The BGL graph to represent a reaction network
   graph_t m_graph;
@@ -195,6 +309,49 @@ class Network {
   /// Map a BGL vertex descriptor to the species index
   map_desc2idx_t m_s_idx_map;
 
+  /**
+   * Map a BGL vertex descriptor to the index of either species or reaction.
+   * This is only used when the vertex descriptor is an integral sequence
+   * number, in which case it replaces the lookup via the hash maps above.
+   */
+  std::vector<v_idx_t> m_v_idx;
+
+  /// Species counts in the order of the species index
+  std::vector<species_cnt_t> m_species_counts;
+  /**
+   * Reaction rates in the order of the reaction index. As with the rate kept
+   * in the reaction property, this can be updated via a const network.
+   */
+  mutable std::vector<reaction_rate_t> m_reaction_rates;
+
+  /**
+   * Offsets into m_rate_input_idx by the reaction index. The species indices
+   * of the rate inputs of the i-th reaction are in
+   * [m_rate_input_offsets[i], m_rate_input_offsets[i+1]) in the same order as
+   * Reaction::get_rate_inputs().
+   */
+  std::vector<size_t> m_rate_input_offsets;
+  /// Concatenated lists of the species indices of the rate inputs
+  std::vector<v_idx_t> m_rate_input_idx;
+
+  /**
+   * Offsets into m_dep_reactions by the reaction index. The reactions
+   * affected by the i-th reaction are in [m_dep_offsets[i], m_dep_offsets[i+1])
+   */
+  std::vector<size_t> m_dep_offsets;
+  /// Concatenated lists of the reactions affected by each reaction
+  reaction_list_t m_dep_reactions;
+
+  /**
+   * Offsets into m_species_updates by the reaction index. The reactant updates
+   * of the i-th reaction are in [m_update_offsets[2i], m_update_offsets[2i+1])
+   * and the product updates are in
+   * [m_update_offsets[2i+1], m_update_offsets[2i+2]).
+   */
+  std::vector<size_t> m_update_offsets;
+  /// Concatenated lists of the species updates by each reaction
+  species_updates_t m_species_updates;
+
   /**
    * The upper limit of the delay period for an active reaction to fire beyond
    * which we consider the reaction inactive/disabled. This is by default set to
@@ -209,6 +366,16 @@ class Network {
   /// List of species that belong to this partition
   species_list_t m_my_species;
 
+  /// The library of the generated rate functions, which is empty with ExprTk
+  std::string m_library_file;
+  /// Whether the graph has been loaded from a snapshot but not initialized
+  bool m_from_snapshot = false;
+  /**
+   * Rate inputs of each reaction in the order of the reaction index, restored
+   * from a snapshot. This is only kept from loading a snapshot until init().
+   */
+  std::vector<Reaction<v_desc_t>::involved_species_t> m_snapshot_inputs;
+
  #if !defined(WCS_HAS_EXPRTK)
   /// all params in formula expected as input per reaction
   params_map_t m_dep_params_f;
@@ -220,6 +387,24 @@ class Network {
    */
   rate_rules_dep_t m_rate_rules_dep_map;
  #endif // !defined(WCS_HAS_EXPRTK
+
+ #if defined(WCS_JIT_BATCH_RATES)
+  /// Kernel that evaluates the rate of every reaction in a chunk
+  using rates_chunk_fn_t = void (*)(const species_cnt_t*, const v_idx_t*,
+                                    const size_t*, reaction_rate_t*);
+  /// Kernel that evaluates the rates of the listed reactions in a chunk
+  using rates_list_fn_t = void (*)(const species_cnt_t*, const v_idx_t*,
+                                   const size_t*, const v_idx_t*, const size_t,
+                                   reaction_rate_t*);
+
+  /**
+   * The number of reactions in each chunk of the batched kernels, which is
+   * zero if the kernels are not available.
+   */
+  v_idx_t m_rates_chunk = static_cast<v_idx_t>(0u);
+  std::vector<rates_chunk_fn_t> m_rates_chunk_fns;
+  std::vector<rates_list_fn_t> m_rates_list_fns;
+ #endif // defined(WCS_JIT_BATCH_RATES)
 };
 
 /**@}*/
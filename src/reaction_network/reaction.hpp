@@ -41,6 +41,23 @@ class Reaction : public ReactionBase {
   const involved_species_t& get_rate_inputs() const;
   void set_products(const std::map<std::string, rdriver_t>& products);
   reaction_rate_t calc_rate(std::vector<reaction_rate_t>&& params) override;
+  /**
+   * Compute the rate by gathering the inputs directly from the given array of
+   * species counts into the preallocated parameter buffer. `input_idx` lists
+   * the index of each input species in the array in the same order as
+   * get_rate_inputs(). This does not involve any memory allocation.
+   */
+  reaction_rate_t calc_rate(const species_cnt_t* const counts,
+                            const v_idx_t* const input_idx);
+
+  /**
+   * Set the rate inputs in the given order without interpreting the formula,
+   * e.g., when restoring a network from a snapshot. `names` are the labels of
+   * the input species in the same order, which are the variables of the rate
+   * formula.
+   */
+  void restore_rate_inputs(const involved_species_t& inputs,
+                           const std::vector<std::string>& names);
 
 #if defined(WCS_HAS_EXPRTK)
   void set_rate_inputs(const std::map<std::string, rdriver_t>& species_involved);
@@ -57,6 +74,12 @@ class Reaction : public ReactionBase {
 
  private:
   Reaction* clone_impl() const override;
+  /// Evaluate the rate formula with the parameters currently in the buffer
+  reaction_rate_t eval_rate();
+#if defined(WCS_HAS_EXPRTK)
+  /// Register the rest of the symbols, and compile the rate formula
+  void compile_rate_formula();
+#endif // defined(WCS_HAS_EXPRTK)
 
   std::vector<reaction_rate_t> m_params;
   bool m_is_composite;
@@ -145,6 +145,31 @@ inline void Reaction<VD>::set_rate_inputs(const std::map<std::string, rdriver_t>
   m_rate_inputs.resize(j);
   m_params.resize(j);
 
+  compile_rate_formula();
+}
+
+template <typename VD>
+inline void Reaction<VD>::restore_rate_inputs(
+  const involved_species_t& inputs,
+  const std::vector<std::string>& names)
+{
+  if (inputs.size() != names.size()) {
+    WCS_THROW("The number of rate inputs differs from that of their names");
+  }
+  m_rate_inputs = inputs;
+  // The symbol table refers to the entries of m_params, which must not
+  // reallocate from now on.
+  m_params.assign(inputs.size(), static_cast<reaction_rate_t>(0.0));
+  for (size_t i = 0ul; i < names.size(); ++i) {
+    m_sym_table.add_variable(names[i], m_params[i]);
+  }
+
+  compile_rate_formula();
+}
+
+template <typename VD>
+inline void Reaction<VD>::compile_rate_formula()
+{
   m_sym_table.add_variable("m_rate", m_rate);
   m_sym_table.add_constant("r_const", m_rate_const);
   m_sym_table.add_constants();
@@ -174,6 +199,13 @@ reaction_rate_t Reaction<VD>::calc_rate(std::vector<reaction_rate_t>&& params)
   // get_rate_inputs()
   m_params.assign(params.begin(), params.end());
 
+  return eval_rate();
+}
+
+template <typename VD>
+inline reaction_rate_t Reaction<VD>::eval_rate()
+{
+  // The symbol table refers to the entries of m_params
   if (!m_is_composite) {
     m_rate = m_expr.value();
   } else {
@@ -332,6 +364,17 @@ std::vector<std::string>& dep_params_nrf)
 
 }
 
+template <typename VD>
+inline void Reaction<VD>::restore_rate_inputs(
+  const involved_species_t& inputs,
+  const std::vector<std::string>& names)
+{
+  // The generated rate function takes the inputs by the position
+  (void) names;
+  m_rate_inputs = inputs;
+  m_params.resize(inputs.size());
+}
+
 template <typename VD>
 reaction_rate_t Reaction<VD>::calc_rate(std::vector<reaction_rate_t>&& params)
 {
@@ -348,6 +391,12 @@ reaction_rate_t Reaction<VD>::calc_rate(std::vector<reaction_rate_t>&& params)
   // get_rate_inputs()
   m_params.assign(params.begin(), params.end());
 
+  return eval_rate();
+}
+
+template <typename VD>
+inline reaction_rate_t Reaction<VD>::eval_rate()
+{
   m_rate = m_calc_rate(m_params);
 
   // Depending on the species population, reaction rate formula can evaluate
@@ -370,6 +419,20 @@ inline void Reaction<VD>::set_products(const std::map<std::string, rdriver_t>& p
 #error "Must enable either ExprTk or SBML"
 #endif
 
+template <typename VD>
+inline reaction_rate_t Reaction<VD>::calc_rate(const species_cnt_t* const counts,
+                                               const v_idx_t* const input_idx)
+{
+  // The order of parameters is the same as the one in the return of
+  // get_rate_inputs(), of which the size is the same as that of m_params
+  const size_t num_params = m_params.size();
+  for (size_t i = 0ul; i < num_params; ++i) {
+    m_params[i] = static_cast<reaction_rate_t>(counts[input_idx[i]]);
+  }
+
+  return eval_rate();
+}
+
 template <typename VD>
 inline const typename Reaction<VD>::involved_species_t& Reaction<VD>::get_rate_inputs() const
 {
@@ -19,17 +19,20 @@ species_cnt_t Species::m_max_count = std::numeric_limits<species_cnt_t>::max();
 
 Species::Species()
 : VertexPropertyBase(),
-  m_count(static_cast<species_cnt_t>(0))
+  m_count(static_cast<species_cnt_t>(0)),
+  m_count_ptr(&m_count)
 {}
 
 Species::Species(const Species& rhs)
 : VertexPropertyBase(rhs),
-  m_count(rhs.m_count)
+  m_count(rhs.get_count()),
+  m_count_ptr(&m_count)
 {}
 
 Species::Species(Species&& rhs) noexcept
 : VertexPropertyBase(std::move(rhs)),
-  m_count(rhs.m_count)
+  m_count(rhs.get_count()),
+  m_count_ptr(&m_count)
 {
   if (this != &rhs) {
     reset(rhs);
@@ -40,7 +43,7 @@ Species& Species::operator=(const Species& rhs)
 {
   if (this != &rhs) {
     VertexPropertyBase::operator=(rhs);
-    m_count = rhs.m_count;
+    *m_count_ptr = rhs.get_count();
   }
   return *this;
 }
@@ -49,7 +52,7 @@ Species& Species::operator=(Species&& rhs) noexcept
 {
   if (this != &rhs) {
     VertexPropertyBase::operator=(std::move(rhs));
-    m_count = rhs.m_count;
+    *m_count_ptr = rhs.get_count();
     reset(rhs);
   }
   return *this;
@@ -71,41 +74,42 @@ void Species::reset(Species& obj)
 {
   VertexPropertyBase::reset(obj);
   obj.m_count = static_cast<species_cnt_t>(0);
+  obj.m_count_ptr = &(obj.m_count);
 }
 
 bool Species::inc_count()
 {
-  if (m_count >= m_max_count) {
+  if ((*m_count_ptr) >= m_max_count) {
     return false;
   }
-  m_count ++;
+  (*m_count_ptr) ++;
   return true;
 }
 
 bool Species::dec_count()
 {
-  if (m_count <= static_cast<species_cnt_t>(0)) {
+  if ((*m_count_ptr) <= static_cast<species_cnt_t>(0)) {
     return false;
   }
-  m_count --;
+  (*m_count_ptr) --;
   return true;
 }
 
 bool Species::inc_count(const species_cnt_t c)
 {
-  if ((m_max_count -  m_count) < c) {
+  if ((m_max_count -  (*m_count_ptr)) < c) {
     return false;
   }
-  m_count += c;
+  (*m_count_ptr) += c;
   return true;
 }
 
 bool Species::dec_count(const species_cnt_t c)
 {
-  if (m_count < c) {
+  if ((*m_count_ptr) < c) {
     return false;
   }
-  m_count -= c;
+  (*m_count_ptr) -= c;
   return true;
 }
 
@@ -119,26 +123,40 @@ constexpr bool check_if_negative(const T& val) {
 
 bool Species::set_count(const species_cnt_t c)
 {
-  if (check_if_negative(m_count) || (m_count > m_max_count)) {
+  if (check_if_negative(*m_count_ptr) || ((*m_count_ptr) > m_max_count)) {
     return false;
   }
-  m_count = c;
+  *m_count_ptr = c;
   return true;
 }
 
 species_cnt_t Species::get_count() const
 {
-  return m_count;
+  return *m_count_ptr;
 }
 
 bool Species::inc_check(const species_cnt_t c) const
 {
-  return ((m_max_count -  m_count) >= c);
+  return ((m_max_count -  (*m_count_ptr)) >= c);
 }
 
 bool Species::dec_check(const species_cnt_t c) const
 {
-  return (m_count >= c);
+  return ((*m_count_ptr) >= c);
+}
+
+void Species::bind_count(species_cnt_t* const cnt_ptr)
+{
+  if (cnt_ptr == nullptr) {
+    return;
+  }
+  *cnt_ptr = *m_count_ptr;
+  m_count_ptr = cnt_ptr;
+}
+
+species_cnt_t Species::get_max_count()
+{
+  return m_max_count;
 }
 
 /**@}*/
@@ -43,6 +43,15 @@ class Species : public VertexPropertyBase {
   bool inc_check(const species_cnt_t c) const;
   /// Check if decreasing the count by the given amount c is possible.
   bool dec_check(const species_cnt_t c) const;
+  /**
+   * Keep the count in the given external storage from now on, such as the
+   * dense array of species counts of the network. The current count is
+   * carried over. Copying or moving a species detaches the count from the
+   * external storage.
+   */
+  void bind_count(species_cnt_t* const cnt_ptr);
+  /// Return the maximum count allowed for a species
+  static species_cnt_t get_max_count();
 
  protected:
   void reset(Species& obj);
@@ -52,6 +61,8 @@ class Species : public VertexPropertyBase {
 
  protected:
   species_cnt_t m_count; ///< copy number of the species
+  /// Where the count is actually kept. Either m_count or an external storage
+  species_cnt_t* m_count_ptr;
   /// The maximum count for a species allowed
   static species_cnt_t m_max_count;
 };
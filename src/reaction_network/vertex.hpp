@@ -35,6 +35,7 @@
 #include <string>
 #include <map>
 #include <iostream>
+#include <type_traits>
 #include "wcs_types.hpp"
 #include "bgl.hpp"
 #include "reaction_network/vertex_flat.hpp"
@@ -90,8 +91,19 @@ class Vertex {
   void set_partition(const partition_id_t pid);
   partition_id_t get_partition() const;
 
+  /**
+   * Return the detailed property of the given type. The access relies on
+   * the type of the vertex known by the caller, and is only checked in the
+   * debug build. This avoids the cost of dynamic_cast in the inner loops.
+   */
   template <typename P> P& property() const;
+  /**
+   * Return the detailed property of the given type after checking it against
+   * the vertex type. Throw an exception upon a mismatch.
+   */
   template <typename P> P& checked_property() const;
+  /// Return the type of the vertex that carries the property of type P
+  template <typename P> static constexpr vertex_type property_type();
 
  protected:
   void set_type(const vertex_type);
@@ -133,17 +145,17 @@ Vertex::Vertex(const VertexFlat& flat, const G& g)
 {
   switch(m_type) {
     case _species_: {
-        m_p = std::unique_ptr<Species>(new Species);
-        dynamic_cast<Species*>(m_p.get())->set_count(flat.get_count());
+        auto sp = std::unique_ptr<Species>(new Species);
+        sp->set_count(flat.get_count());
+        m_p = std::move(sp);
         break;
       }
     case _reaction_: {
         using v_desc_t = typename boost::graph_traits<G>::vertex_descriptor;
-        m_p = std::unique_ptr< Reaction<v_desc_t> >(new Reaction<v_desc_t>);
-        dynamic_cast<Reaction<v_desc_t>*>(m_p.get())->
-          set_rate_constant(flat.get_rate_constant());
-        dynamic_cast<Reaction<v_desc_t>*>(m_p.get())->
-          set_rate_formula(flat.get_rate_formula());
+        auto rp = std::unique_ptr< Reaction<v_desc_t> >(new Reaction<v_desc_t>);
+        rp->set_rate_constant(flat.get_rate_constant());
+        rp->set_rate_formula(flat.get_rate_formula());
+        m_p = std::move(rp);
     break;
       }
     default:
@@ -324,18 +336,40 @@ Vertex::Vertex(
 }
 #endif // defined(WCS_HAS_SBML)
 
+template <typename P>
+constexpr Vertex::vertex_type Vertex::property_type()
+{
+  return std::is_base_of<ReactionBase, P>::value? _reaction_ :
+         (std::is_base_of<Species, P>::value? _species_ : _undefined_);
+}
+
 template <typename P> P& Vertex::property() const
 {
-  return *dynamic_cast<P*>(m_p.get());
+ #if defined(WCS_DEBUG)
+  return checked_property<P>();
+ #else
+  return *static_cast<P*>(m_p.get());
+ #endif // defined(WCS_DEBUG)
 }
 
 template <typename P> P& Vertex::checked_property() const
 {
+  static_assert(property_type<P>() != _undefined_,
+                "Not a type of vertex property");
+  if ((m_type != property_type<P>()) || !m_p) {
+    WCS_THROW("Attempted to dereference a wrong type of property pointer.");
+  }
+ #if defined(WCS_DEBUG)
+  // The type tag does not tell apart the vertex descriptor type with which
+  // a Reaction is instantiated
   auto ptr = dynamic_cast<P*>(m_p.get());
   if (ptr == nullptr) {
     WCS_THROW("Attempted to dereference a wrong type of property pointer.");
   }
   return *ptr;
+ #else
+  return *static_cast<P*>(m_p.get());
+ #endif // defined(WCS_DEBUG)
 }
 
 /**@}*/
@@ -0,0 +1,213 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <algorithm>
+#include "sim_methods/digest_pool.hpp"
+#include "utils/exception.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_sim_methods
+ *  @{ */
+
+/// The initial number of records in the pool
+constexpr size_t digest_pool_min_records = 64ul;
+
+Digest_Pool::Digest_Pool()
+: m_first(0ul), m_count(0ul)
+{
+  reset(digest_pool_min_records);
+}
+
+void Digest_Pool::reset(const size_t num_records, const size_t num_times,
+                        const size_t num_bytes)
+{
+  size_t n = digest_pool_min_records;
+  while (n < num_records) {
+    n *= 2ul;
+  }
+  m_records.clear();
+  m_records.resize(n);
+  m_first = 0ul;
+  m_count = 0ul;
+
+  m_times.clear();
+  m_times.resize(num_times);
+  m_rng.clear();
+  m_rng.resize(num_bytes);
+}
+
+size_t Digest_Pool::slot(const size_t i) const
+{
+  return ((m_first + i) & (m_records.size() - 1ul));
+}
+
+void Digest_Pool::grow_records()
+{
+  std::vector<record_t> records(m_records.size() * 2ul);
+  for (size_t i = 0ul; i < m_count; ++i) {
+    records[i] = m_records[slot(i)];
+  }
+  m_records.swap(records);
+  m_first = 0ul;
+}
+
+template <typename T>
+void Digest_Pool::relocate(std::vector<T>& ring, const size_t capacity,
+                           size_t record_t::* pos, size_t record_t::* len)
+{
+  std::vector<T> buf(capacity);
+  size_t cursor = 0ul;
+
+  for (size_t i = 0ul; i < m_count; ++i) {
+    record_t& rec = m_records[slot(i)];
+    std::copy_n(ring.data() + rec.*pos, rec.*len, buf.data() + cursor);
+    rec.*pos = cursor;
+    cursor += rec.*len;
+  }
+  ring.swap(buf);
+}
+
+template <typename T>
+size_t Digest_Pool::alloc(std::vector<T>& ring, const size_t n,
+                          size_t record_t::* pos, size_t record_t::* len)
+{
+  size_t head = 0ul;
+  size_t tail = 0ul;
+  if (m_count > 0ul) {
+    head = front().*pos;
+    tail = back().*pos + back().*len;
+  }
+  if (n == 0ul) {
+    return tail;
+  }
+
+  const size_t capacity = ring.size();
+  if (tail >= head) { // The live range does not wrap around
+    if (tail + n <= capacity) {
+      return tail;
+    }
+    // Keep the head strictly ahead of the tail so that the live range that
+    // wraps around is not confused with an empty one.
+    if (n < head) {
+      return 0ul;
+    }
+  } else if (tail + n < head) {
+    return tail;
+  }
+
+  size_t live = 0ul;
+  for (size_t i = 0ul; i < m_count; ++i) {
+    live += m_records[slot(i)].*len;
+  }
+  relocate(ring, std::max(capacity * 2ul, (live + n) * 2ul), pos, len);
+
+  return live;
+}
+
+void Digest_Pool::push(const sim_time_t t)
+{
+  const size_t tpos
+    = alloc(m_times, 0ul, &record_t::m_times_pos, &record_t::m_num_times);
+  const size_t rpos
+    = alloc(m_rng, 0ul, &record_t::m_rng_pos, &record_t::m_rng_size);
+
+  if (m_count == m_records.size()) {
+    grow_records();
+  }
+  record_t& rec = m_records[slot(m_count)];
+  rec.m_sim_time = t;
+  rec.m_reaction_fired = v_desc_t{};
+  rec.m_fired = false;
+  rec.m_times_pos = tpos;
+  rec.m_num_times = 0ul;
+  rec.m_rng_pos = rpos;
+  rec.m_rng_size = 0ul;
+  rec.m_rng_draws = 0ul;
+  ++ m_count;
+}
+
+void Digest_Pool::push(const Sim_State_Change& digest, const bool fired)
+{
+  const size_t num_times = digest.m_reaction_times.size();
+  const size_t rng_size = digest.m_rng_state.size();
+
+  const size_t tpos = alloc(m_times, num_times,
+                            &record_t::m_times_pos, &record_t::m_num_times);
+  std::copy_n(digest.m_reaction_times.data(), num_times,
+              m_times.data() + tpos);
+
+  const size_t rpos = alloc(m_rng, rng_size,
+                            &record_t::m_rng_pos, &record_t::m_rng_size);
+  std::copy_n(digest.m_rng_state.data(), rng_size, m_rng.data() + rpos);
+
+  if (m_count == m_records.size()) {
+    grow_records();
+  }
+  record_t& rec = m_records[slot(m_count)];
+  rec.m_sim_time = digest.m_sim_time;
+  rec.m_reaction_fired = digest.m_reaction_fired;
+  rec.m_fired = fired;
+  rec.m_times_pos = tpos;
+  rec.m_num_times = num_times;
+  rec.m_rng_pos = rpos;
+  rec.m_rng_size = rng_size;
+  rec.m_rng_draws = digest.m_rng_draws;
+  ++ m_count;
+}
+
+void Digest_Pool::pop_back()
+{
+ #ifndef NDEBUG
+  if (BOOST_UNLIKELY(m_count == 0ul)) {
+    WCS_THROW("No digest to remove!");
+  }
+ #endif
+  -- m_count;
+}
+
+void Digest_Pool::pop_front(const size_t n)
+{
+ #ifndef NDEBUG
+  if (BOOST_UNLIKELY(m_count < n)) {
+    WCS_THROW("Not enough digests to remove!");
+  }
+ #endif
+  m_first = slot(n);
+  m_count -= n;
+}
+
+const Digest_Pool::record_t& Digest_Pool::operator[](const size_t i) const
+{
+  return m_records[slot(i)];
+}
+
+const Digest_Pool::record_t& Digest_Pool::front() const
+{
+  return m_records[m_first];
+}
+
+const Digest_Pool::record_t& Digest_Pool::back() const
+{
+  return m_records[slot(m_count - 1ul)];
+}
+
+const Digest_Pool::rtime_t*
+Digest_Pool::reaction_times(const record_t& rec) const
+{
+  return m_times.data() + rec.m_times_pos;
+}
+
+const char* Digest_Pool::rng_state(const record_t& rec) const
+{
+  return m_rng.data() + rec.m_rng_pos;
+}
+
+/**@}*/
+} // end of namespace wcs
@@ -0,0 +1,132 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef __WCS_SIM_METHODS_DIGEST_POOL_HPP__
+#define __WCS_SIM_METHODS_DIGEST_POOL_HPP__
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <cstddef>
+#include <vector>
+#include "wcs_types.hpp"
+#include "sim_methods/sim_state_change.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_sim_methods
+ *  @{ */
+
+/**
+ * Store of the digests of the events executed optimistically, which are
+ * needed to roll the events back. A digest is appended by every forward
+ * event, removed from the back upon a rollback, and removed from the front
+ * upon the commit of the event.
+ *
+ * Instead of allocating a Sim_State_Change per event, the fixed-size part of
+ * each digest is kept in a ring buffer of records, and the variable-size part,
+ * i.e., the previous times of the affected reactions and the serialized state
+ * of the random number generator, is kept in a ring buffer of each kind. The
+ * latter is empty when the generator is rolled back by the number of draws. A
+ * record refers to its part of these buffers by the position and the length.
+ * Thus, once the buffers grow large enough to cover the span of the events
+ * not yet committed, pushing and popping a digest no longer allocates memory.
+ * Committing a number of events at once only advances the front of the rings.
+ */
+class Digest_Pool {
+ public:
+  using v_desc_t = Sim_State_Change::v_desc_t;
+  using rtime_t = Sim_State_Change::reaction_times_t::value_type;
+
+  struct record_t {
+    sim_time_t m_sim_time; ///< Simulation time of the event
+    v_desc_t m_reaction_fired; ///< Reaction fired by the event
+    /// Whether the event fired a reaction or only updated species counts
+    bool m_fired;
+    size_t m_times_pos; ///< Position of the reaction times in the ring
+    size_t m_num_times; ///< Number of the reaction times
+    size_t m_rng_pos; ///< Position of the RNG state in the ring
+    size_t m_rng_size; ///< Byte size of the RNG state
+    size_t m_rng_draws; ///< Number of the values drawn from the RNG
+  };
+
+  Digest_Pool();
+
+  /**
+   * Drop every digest, and preallocate for the given number of records as
+   * well as the given total length of the reaction times and RNG states.
+   */
+  void reset(const size_t num_records, const size_t num_times = 0ul,
+             const size_t num_bytes = 0ul);
+
+  /// Append a digest with no state saved, such as the one at the beginning
+  void push(const sim_time_t t);
+  /**
+   * Append the digest of an event by copying its state into the pool. An
+   * event that does not fire a reaction, such as the update of the species
+   * shared with another partition, is marked by `fired` being false.
+   */
+  void push(const Sim_State_Change& digest, const bool fired = true);
+  /// Remove the digest at the back, i.e., of the latest event
+  void pop_back();
+  /// Remove the given number of digests from the front, i.e., the oldest ones
+  void pop_front(const size_t n = 1ul);
+
+  bool empty() const { return (m_count == 0ul); }
+  size_t size() const { return m_count; }
+
+  /// Return the i-th record from the front
+  const record_t& operator[](const size_t i) const;
+  const record_t& front() const;
+  const record_t& back() const;
+
+  /// Return the pointer to the reaction times saved by the given record
+  const rtime_t* reaction_times(const record_t& rec) const;
+  /// Return the pointer to the RNG state saved by the given record
+  const char* rng_state(const record_t& rec) const;
+
+ protected:
+  size_t slot(const size_t i) const;
+  void grow_records();
+
+  /**
+   * Allocate a contiguous span of the given length in a ring buffer of
+   * payloads, of which the live range starts at `head` and ends at `tail`.
+   * The span is placed at the tail if it fits before the end of the buffer,
+   * or at the beginning otherwise, leaving the rest of the buffer unused until
+   * the front wraps around. Grow the buffer when neither fits. Return the
+   * position of the span.
+   */
+  template <typename T>
+  size_t alloc(std::vector<T>& ring, const size_t n,
+               size_t record_t::* pos, size_t record_t::* len);
+
+  /// Reallocate the ring buffer, and pack the live payloads at its beginning
+  template <typename T>
+  void relocate(std::vector<T>& ring, const size_t capacity,
+                size_t record_t::* pos, size_t record_t::* len);
+
+ protected:
+  /// Ring buffer of records, of which the size is a power of two
+  std::vector<record_t> m_records;
+  size_t m_first; ///< Slot of the record at the front
+  size_t m_count; ///< Number of the records in the pool
+
+  /// Ring buffer of the reaction times saved by the records
+  std::vector<rtime_t> m_times;
+  /// Ring buffer of the RNG states saved by the records
+  std::vector<char> m_rng;
+};
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_SIM_METHODS_DIGEST_POOL_HPP__
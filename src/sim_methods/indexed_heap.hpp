@@ -0,0 +1,309 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef __WCS_SIM_METHODS_INDEXED_HEAP_HPP__
+#define __WCS_SIM_METHODS_INDEXED_HEAP_HPP__
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <algorithm> // min
+#include <cstddef>
+#include <new> // align_val_t
+#include <utility> // pair
+#include <vector>
+#include "wcs_types.hpp"
+#include "utils/state_io.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_sim_methods
+ *  @{ */
+
+/// The size of a cache line assumed for aligning heap nodes
+constexpr size_t cache_line_size = 64ul;
+
+/// Allocator that aligns the storage at the given byte boundary
+template <typename T, size_t A = cache_line_size>
+struct aligned_allocator {
+  using value_type = T;
+  template <typename U> struct rebind { using other = aligned_allocator<U, A>; };
+
+  aligned_allocator() noexcept = default;
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U, A>&) noexcept {}
+
+  T* allocate(const size_t n)
+  {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(A)));
+  }
+  void deallocate(T* const p, const size_t) noexcept
+  {
+    ::operator delete(p, std::align_val_t(A));
+  }
+
+  template <typename U>
+  bool operator==(const aligned_allocator<U, A>&) const noexcept { return true; }
+  template <typename U>
+  bool operator!=(const aligned_allocator<U, A>&) const noexcept { return false; }
+};
+
+/**
+ * Indexed d-ary heap of (priority, key) pairs, of which the key is a dense
+ * index in the range of [0, num_keys). The position of each key in the heap is
+ * tracked by a plain array indexed by the key, which allows updating the
+ * priority of a key in place without a hash lookup per swap.
+ *
+ * The entry that compares the highest by `Compare` is at the top. i.e.,
+ * `Compare(a, b)` returns true if `a` is to come out before `b`.
+ *
+ * The nodes are stored with an offset of `D-1` slots such that the children
+ * of every node, which are contiguous, start at a multiple of `D` slots from
+ * the cache-aligned base. With 16-byte entries and D = 4, the children of a
+ * node fit in a single cache line.
+ */
+template <typename P, typename Compare, unsigned D = 4u>
+class Indexed_Heap {
+public:
+  static_assert(D >= 2u, "The arity of the heap must be at least 2");
+
+  using priority_t = P;
+  using key_t = v_idx_t;
+  using entry_t = std::pair<priority_t, key_t>;
+  /// Type of the position in the heap
+  using pos_t = int;
+  static constexpr pos_t npos = static_cast<pos_t>(-1);
+  static constexpr unsigned arity = D;
+
+  Indexed_Heap(const Compare& cmp = Compare());
+
+  /// Set the comparator
+  void set_compare(const Compare& cmp);
+  /// Remove every entry and prepare the position table for the number of keys
+  void reset(const size_t num_keys);
+  /// Append an entry without maintaining the heap order until make() is called
+  void push_back(const priority_t& p, const key_t k);
+  /// Establish the heap order over the entries appended
+  void make();
+
+  bool empty() const;
+  size_t size() const;
+  /// Return the entry at the top of the heap
+  const entry_t& top() const;
+  /// Return the current priority of the given key
+  const priority_t& priority(const key_t k) const;
+  /// Check if the given key is in the heap
+  bool contains(const key_t k) const;
+  /// Change the priority of the given key, and restore the heap order
+  void update(const key_t k, const priority_t& p);
+
+  /// Write the number of keys and the entries in the heap order by `bits()`
+  template <typename S> S& save_bits(S& os) const;
+  /// Restore the entries written by `save_bits()` in the same order
+  template <typename S> S& load_bits(S& is);
+
+protected:
+  /// Return the offset to the storage of the node at the given position
+  static size_t slot(const pos_t i);
+  entry_t& at(const pos_t i);
+  const entry_t& at(const pos_t i) const;
+  /// Move the entry at the given position up, and return whether it moved
+  bool sift_up(pos_t i);
+  void sift_down(pos_t i);
+
+protected:
+  /// Heap nodes stored with an offset of D-1 slots
+  std::vector<entry_t, aligned_allocator<entry_t>> m_nodes;
+  /// The number of entries in the heap
+  pos_t m_size;
+  /// Position of each key in the heap
+  std::vector<pos_t> m_pos;
+  Compare m_cmp;
+};
+
+template <typename P, typename C, unsigned D>
+inline Indexed_Heap<P, C, D>::Indexed_Heap(const C& cmp)
+: m_nodes(D-1u), m_size(0), m_cmp(cmp)
+{}
+
+template <typename P, typename C, unsigned D>
+inline void Indexed_Heap<P, C, D>::set_compare(const C& cmp)
+{
+  m_cmp = cmp;
+}
+
+template <typename P, typename C, unsigned D>
+inline void Indexed_Heap<P, C, D>::reset(const size_t num_keys)
+{
+  m_nodes.clear();
+  m_nodes.reserve(num_keys + D - 1u);
+  m_nodes.resize(D - 1u);
+  m_size = static_cast<pos_t>(0);
+  m_pos.assign(num_keys, npos);
+}
+
+template <typename P, typename C, unsigned D>
+inline void Indexed_Heap<P, C, D>::push_back(const P& p, const key_t k)
+{
+  m_nodes.emplace_back(p, k);
+  m_pos.at(k) = m_size++;
+}
+
+template <typename P, typename C, unsigned D>
+inline void Indexed_Heap<P, C, D>::make()
+{
+  if (m_size < static_cast<pos_t>(2)) return;
+  for (pos_t i = (m_size - 2) / static_cast<pos_t>(D) + 1; i-- > 0; ) {
+    sift_down(i);
+  }
+}
+
+template <typename P, typename C, unsigned D>
+inline bool Indexed_Heap<P, C, D>::empty() const
+{
+  return (m_size == static_cast<pos_t>(0));
+}
+
+template <typename P, typename C, unsigned D>
+inline size_t Indexed_Heap<P, C, D>::size() const
+{
+  return static_cast<size_t>(m_size);
+}
+
+template <typename P, typename C, unsigned D>
+inline const typename Indexed_Heap<P, C, D>::entry_t&
+Indexed_Heap<P, C, D>::top() const
+{
+  return at(0);
+}
+
+template <typename P, typename C, unsigned D>
+inline const P& Indexed_Heap<P, C, D>::priority(const key_t k) const
+{
+  return at(m_pos[k]).first;
+}
+
+template <typename P, typename C, unsigned D>
+inline bool Indexed_Heap<P, C, D>::contains(const key_t k) const
+{
+  return (k < m_pos.size()) && (m_pos[k] != npos);
+}
+
+template <typename P, typename C, unsigned D>
+inline void Indexed_Heap<P, C, D>::update(const key_t k, const P& p)
+{
+  const auto i = m_pos[k];
+  at(i).first = p;
+  if (!sift_up(i)) {
+    sift_down(i);
+  }
+}
+
+template <typename P, typename C, unsigned D>
+template <typename S>
+inline S& Indexed_Heap<P, C, D>::save_bits(S& os) const
+{
+  const size_t num_keys = m_pos.size();
+  os << bits(num_keys) << bits(m_size);
+  for (pos_t i = static_cast<pos_t>(0); i < m_size; ++i) {
+    os << bits(at(i).first) << bits(at(i).second);
+  }
+  return os;
+}
+
+template <typename P, typename C, unsigned D>
+template <typename S>
+inline S& Indexed_Heap<P, C, D>::load_bits(S& is)
+{
+  size_t num_keys = 0ul;
+  pos_t n = static_cast<pos_t>(0);
+  is >> bits(num_keys) >> bits(n);
+  reset(num_keys);
+  for (pos_t i = static_cast<pos_t>(0); i < n; ++i) {
+    priority_t p {};
+    key_t k {};
+    is >> bits(p) >> bits(k);
+    // The entries are already in the heap order
+    push_back(p, k);
+  }
+  return is;
+}
+
+template <typename P, typename C, unsigned D>
+inline size_t Indexed_Heap<P, C, D>::slot(const pos_t i)
+{
+  return static_cast<size_t>(i) + D - 1u;
+}
+
+template <typename P, typename C, unsigned D>
+inline typename Indexed_Heap<P, C, D>::entry_t&
+Indexed_Heap<P, C, D>::at(const pos_t i)
+{
+  return m_nodes[slot(i)];
+}
+
+template <typename P, typename C, unsigned D>
+inline const typename Indexed_Heap<P, C, D>::entry_t&
+Indexed_Heap<P, C, D>::at(const pos_t i) const
+{
+  return m_nodes[slot(i)];
+}
+
+template <typename P, typename C, unsigned D>
+inline bool Indexed_Heap<P, C, D>::sift_up(pos_t i)
+{
+  const pos_t i0 = i;
+  entry_t e = at(i);
+
+  while (i > static_cast<pos_t>(0)) {
+    const pos_t parent = (i - 1) / static_cast<pos_t>(D);
+    if (!m_cmp(e, at(parent))) break;
+    at(i) = at(parent);
+    m_pos[at(i).second] = i;
+    i = parent;
+  }
+  if (i != i0) {
+    at(i) = e;
+    m_pos[e.second] = i;
+  }
+  return (i != i0);
+}
+
+template <typename P, typename C, unsigned D>
+inline void Indexed_Heap<P, C, D>::sift_down(pos_t i)
+{
+  const pos_t i0 = i;
+  entry_t e = at(i);
+
+  while (true) {
+    const pos_t first = i * static_cast<pos_t>(D) + 1;
+    if (first >= m_size) break;
+    const pos_t last = std::min(first + static_cast<pos_t>(D), m_size);
+
+    pos_t best = first;
+    for (pos_t c = first + 1; c < last; ++c) {
+      if (m_cmp(at(c), at(best))) best = c;
+    }
+    if (!m_cmp(at(best), e)) break;
+    at(i) = at(best);
+    m_pos[at(i).second] = i;
+    i = best;
+  }
+  if (i != i0) {
+    at(i) = e;
+    m_pos[e.second] = i;
+  }
+}
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_SIM_METHODS_INDEXED_HEAP_HPP__
@@ -8,9 +8,17 @@
  *                                                                            *
  ******************************************************************************/
 
+#include <algorithm> // std::min
+#include <cstdint>
+#include <cstdio> // std::rename
+#include <fstream>
+#include <iterator>
 #include <limits>
 #include <utility> // std::forward
 #include "sim_methods/sim_method.hpp"
+#include "utils/state_io.hpp"
+#include "utils/streamvec.hpp"
+#include "utils/timer.hpp"
 
 namespace wcs {
 /** \addtogroup wcs_reaction_network
@@ -22,7 +30,13 @@ Sim_Method::Sim_Method(const std::shared_ptr<wcs::Network>& net_ptr) try
   m_max_time(static_cast<sim_time_t>(0)),
   m_sim_iter(static_cast<sim_iter_t>(0u)),
   m_sim_time(static_cast<sim_time_t>(0)),
-  m_recording(false)
+  m_recording(false),
+  m_profiling(false),
+  m_ckpt_iter_interval(static_cast<sim_iter_t>(0u)),
+  m_ckpt_wall_interval(0.0),
+  m_ckpt_next_iter(std::numeric_limits<sim_iter_t>::max()),
+  m_ckpt_next_poll(std::numeric_limits<sim_iter_t>::max()),
+  m_ckpt_last_wall(0.0)
 {
   if (!m_net_ptr) {
     WCS_THROW("Invalid pointer to the reaction network.");
@@ -48,6 +62,14 @@ catch (const std::exception& e) {
 Sim_Method::~Sim_Method() {}
 
 
+void Sim_Method::set_async_recording(const unsigned num_buffers)
+{
+  if (!m_trajectory) {
+    WCS_THROW("Tracing/sampling has not been enabled.");
+  }
+  m_trajectory->set_async(num_buffers);
+}
+
 void Sim_Method::unset_recording()
 {
   m_recording = false;
@@ -60,11 +82,27 @@ void Sim_Method::initialize_recording(const std::shared_ptr<wcs::Network>& net_p
   }
 }
 
+void Sim_Method::set_profiling()
+{
+  m_profiling = true;
+  m_firing_counts.assign(m_net_ptr->get_num_reactions(),
+                         static_cast<firing_count_t>(0u));
+}
+
+const std::vector<Sim_Method::firing_count_t>&
+Sim_Method::get_firing_counts() const
+{
+  return m_firing_counts;
+}
+
 void Sim_Method::record(const v_desc_t rv)
 {
   if (m_recording) {
     m_trajectory->record_step(m_sim_time, rv);
   }
+  if (m_profiling) {
+    m_firing_counts[m_net_ptr->reaction_d2i(rv)] ++;
+  }
 }
 
 void Sim_Method::record(const sim_time_t t, const v_desc_t rv)
@@ -72,6 +110,9 @@ void Sim_Method::record(const sim_time_t t, const v_desc_t rv)
   if (m_recording) {
     m_trajectory->record_step(t, rv);
   }
+  if (m_profiling) {
+    m_firing_counts[m_net_ptr->reaction_d2i(rv)] ++;
+  }
 }
 
 void Sim_Method::record(cnt_updates_t&& u)
@@ -110,6 +151,190 @@ void Sim_Method::finalize_recording() {
   }
 }
 
+/// Identifies a checkpoint file, which reads "WCSCKPT" in little endian
+static constexpr uint64_t ckpt_magic = 0x0054504b43534357ull;
+/// Version of the checkpoint layout
+static constexpr uint32_t ckpt_version = 1u;
+/// While checkpointing by the wall-clock time, read the clock this often
+static constexpr sim_iter_t ckpt_wall_poll_stride = 1024u;
+
+void Sim_Method::set_checkpointing(const std::string& ckpt_file,
+                                   const sim_iter_t iter_interval,
+                                   const double wall_interval)
+{
+  m_ckpt_file = ckpt_file;
+  m_ckpt_iter_interval = iter_interval;
+  m_ckpt_wall_interval = wall_interval;
+
+  if (m_ckpt_file.empty()) {
+    m_ckpt_iter_interval = static_cast<sim_iter_t>(0u);
+    m_ckpt_wall_interval = 0.0;
+  }
+  if (m_recording && !m_trajectory->is_checkpointable() &&
+      ((m_ckpt_iter_interval > 0u) || (m_ckpt_wall_interval > 0.0))) {
+    WCS_THROW("The trajectory being recorded cannot be checkpointed.");
+  }
+  m_ckpt_next_iter = m_sim_iter + m_ckpt_iter_interval;
+  m_ckpt_last_wall = get_time();
+  schedule_checkpoint_poll();
+}
+
+void Sim_Method::schedule_checkpoint_poll()
+{
+  m_ckpt_next_poll = std::numeric_limits<sim_iter_t>::max();
+  if (m_ckpt_iter_interval > 0u) {
+    m_ckpt_next_poll = m_ckpt_next_iter;
+  }
+  if (m_ckpt_wall_interval > 0.0) {
+    m_ckpt_next_poll = std::min(m_ckpt_next_poll,
+                                m_sim_iter + ckpt_wall_poll_stride);
+  }
+}
+
+void Sim_Method::poll_checkpoint()
+{
+  const bool iter_due = (m_ckpt_iter_interval > 0u) &&
+                        (m_sim_iter >= m_ckpt_next_iter);
+  const bool wall_due = (m_ckpt_wall_interval > 0.0) &&
+                        ((get_time() - m_ckpt_last_wall) >= m_ckpt_wall_interval);
+
+  if (iter_due || wall_due) {
+    save_checkpoint(m_ckpt_file);
+    m_ckpt_next_iter = m_sim_iter + m_ckpt_iter_interval;
+    m_ckpt_last_wall = get_time();
+  }
+  schedule_checkpoint_poll();
+}
+
+/**
+ * The checkpoint consists of the simulation time and iteration, the species
+ * counts, the reaction rates, the state of the trajectory recorder if any, and
+ * the state of the method. The rates are saved as they are rather than to be
+ * recomputed from the counts, as a method may keep a rate that is stale.
+ */
+void Sim_Method::save_checkpoint(const std::string& ckpt_file)
+{
+ #if defined(WCS_HAS_ROSS)
+  WCS_THROW("Checkpointing is not supported with ROSS.");
+ #else
+  std::vector<char> buffer;
+  {
+    wcs::ostreamvec<char> ostrmbuf(buffer);
+    std::ostream os(&ostrmbuf);
+
+    os << bits(ckpt_magic) << bits(ckpt_version)
+       << bits(m_sim_iter) << bits(m_sim_time)
+       << bits(m_net_ptr->species_counts())
+       << bits(m_net_ptr->reaction_rates())
+       << bits(m_recording);
+
+    if (m_recording) {
+      m_trajectory->save_checkpoint(os);
+    }
+    save_method_state(os);
+
+    if (!os) {
+      WCS_THROW("Failed to serialize the checkpoint.");
+    }
+  }
+
+  // Write into a temporary file first not to lose the last checkpoint in case
+  // the job gets killed while writing.
+  const std::string tmp_file = ckpt_file + ".tmp";
+  {
+    std::ofstream ofs(tmp_file, std::ios::binary | std::ios::trunc);
+    ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    ofs.close();
+    if (!ofs) {
+      WCS_THROW("Failed to write the checkpoint " + tmp_file);
+    }
+  }
+  if (std::rename(tmp_file.c_str(), ckpt_file.c_str()) != 0) {
+    WCS_THROW("Failed to rename " + tmp_file + " to " + ckpt_file);
+  }
+ #endif // defined(WCS_HAS_ROSS)
+}
+
+void Sim_Method::load_checkpoint(const std::string& ckpt_file)
+{
+ #if defined(WCS_HAS_ROSS)
+  WCS_THROW("Checkpointing is not supported with ROSS.");
+ #else
+  std::ifstream ifs(ckpt_file, std::ios::binary);
+  if (!ifs) {
+    WCS_THROW("Failed to open the checkpoint " + ckpt_file);
+  }
+  const std::vector<char> buffer((std::istreambuf_iterator<char>(ifs)),
+                                 std::istreambuf_iterator<char>());
+  wcs::istreamvec<char> istrmbuf(buffer);
+  std::istream is(&istrmbuf);
+
+  uint64_t magic = 0ull;
+  uint32_t version = 0u;
+  is >> bits(magic) >> bits(version);
+  if (!is || (magic != ckpt_magic)) {
+    WCS_THROW(ckpt_file + " is not a checkpoint.");
+  }
+  if (version != ckpt_version) {
+    WCS_THROW("Unsupported checkpoint version " + std::to_string(version));
+  }
+
+  std::vector<species_cnt_t> counts;
+  std::vector<reaction_rate_t> rates;
+  bool recording = false;
+  is >> bits(m_sim_iter) >> bits(m_sim_time)
+     >> bits(counts) >> bits(rates) >> bits(recording);
+
+  if (!is || (rates.size() != m_net_ptr->get_num_reactions())) {
+    WCS_THROW("The checkpoint does not match the reaction network.");
+  }
+  if (recording != m_recording) {
+    WCS_THROW("The checkpoint was taken with a different recording option.");
+  }
+
+  m_net_ptr->reset_species_counts(counts);
+  for (v_idx_t i = 0u; i < static_cast<v_idx_t>(rates.size()); ++i) {
+    m_net_ptr->set_reaction_rate(m_net_ptr->reaction_i2d(i), rates[i]);
+  }
+
+  if (m_recording) {
+    m_trajectory->load_checkpoint(is);
+  }
+  load_method_state(is);
+
+  if (!is) {
+    WCS_THROW("The checkpoint " + ckpt_file + " is truncated.");
+  }
+  m_ckpt_next_iter = m_sim_iter + m_ckpt_iter_interval;
+  schedule_checkpoint_poll();
+ #endif // defined(WCS_HAS_ROSS)
+}
+
+void Sim_Method::save_method_state(std::ostream& os) const
+{
+  WCS_THROW("This method does not support checkpointing.");
+}
+
+void Sim_Method::load_method_state(std::istream& is)
+{
+  WCS_THROW("This method does not support checkpointing.");
+}
+
+void Sim_Method::save_state_tag(std::ostream& os, const std::string& tag)
+{
+  const std::vector<char> str(tag.cbegin(), tag.cend());
+  os << bits(str);
+}
+
+void Sim_Method::check_state_tag(std::istream& is, const std::string& tag)
+{
+  std::vector<char> str;
+  is >> bits(str);
+  if (!is || (std::string(str.cbegin(), str.cend()) != tag)) {
+    WCS_THROW("The checkpoint is not of " + tag);
+  }
+}
+
 /**
  * Execute the chosen reaction.
  * In other words, update the species population involved in the reaction.
@@ -118,14 +343,17 @@ void Sim_Method::finalize_recording() {
  * The former can be used to undo the reaction if needed. The latter is used
  * to update the propensity of the reactions affected by the changes in species
  * counts.
+ * Both the species updates and the list of affected reactions are looked up
+ * from the tables that the network precomputes at initialization.
  */
 bool Sim_Method::fire_reaction(Sim_State_Change& digest)
 {
-  using s_prop_t = wcs::Species;
-
-  // Reactions do not change the connectivity, but only change the property
-  // data, which are allocated outside of BGL graph, but only linked to it.
+  // Species counts are kept in a dense array of the network, which the
+  // precomputed update table of each reaction indexes directly. The graph is
+  // only needed for the labels in the error messages.
+ #if !defined(NDEBUG)
   const wcs::Network::graph_t& g = m_net_ptr->graph();
+ #endif // !defined(NDEBUG)
   // The vertex descriptor of the reaction to undo
   const auto& rd_firing = digest.m_reaction_fired;
  #ifdef ENABLE_SPECIES_UPDATE_TRACKING
@@ -133,222 +361,82 @@ bool Sim_Method::fire_reaction(Sim_State_Change& digest)
   auto& updating_species = digest.m_species_updated;
   updating_species.clear();
  #endif // ENABLE_SPECIES_UPDATE_TRACKING
-  auto& reactions_affected = digest.m_reactions_affected;
 
-  reactions_affected.clear();
-
- #if defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
-  const auto pid = m_net_ptr->get_partition_id();
- #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
+  // The list of affected reactions is static, and already excludes those
+  // not local to the current partition when running partitions.
+  digest.m_reactions_affected = m_net_ptr->get_affected_reactions(rd_firing);
 
   // ========================= reactant species ================================
+  const auto reactants = m_net_ptr->get_reactant_updates(rd_firing);
  #if defined(_OPENMP) && defined(WCS_OMP_REACTION_REACTANTS) // ----------------
-  using e_desc_t = wcs::Network::e_desc_t;
-  using ie_iter_t = boost::graph_traits<Network::graph_t>::in_edge_iterator;
-  ie_iter_t iei, iei_end;
-
-  boost::tie(iei, iei_end) = boost::in_edges(rd_firing, g);
-  const std::vector<e_desc_t> inedges(iei, iei_end);
-  const size_t nie = inedges.size();
+  const auto nr = static_cast<size_t>(reactants.size());
 
   #pragma omp parallel for //schedule(dynamic)
-  for (size_t i = 0u; i < nie; ++i)
+  for (size_t i = 0u; i < nr; ++i)
   {
-    const auto& ei_in = inedges[i];
-    const auto vd_updating = boost::source(ei_in, g);
-    const auto& sv_updating = g[vd_updating];
-    if constexpr (wcs::Vertex::_num_vertex_types_  > 3) {
-      // in case that there are other type of vertices than species or reaction
-      if (sv_updating.get_type() != wcs::Vertex::_species_) continue;
-    }
-
-    auto& sp_updating = sv_updating.property<s_prop_t>();
-    const auto stoichio = g[ei_in].get_stoichiometry_ratio();
-    if (stoichio == static_cast<stoic_t>(0)) {
-      continue;
-    }
+    const auto& u = reactants[i];
+ #else // defined(_OPENMP) && defined(WCS_OMP_REACTION_REACTANTS) // -----------
+  for (const auto& u : reactants)
+  {
+ #endif // defined(_OPENMP) && defined(WCS_OMP_REACTION_REACTANTS) // ----------
+    const auto stoichio = u.second;
   #ifdef NDEBUG
-    sp_updating.dec_count(stoichio);
+    m_net_ptr->dec_species_count(u.first, stoichio);
   #else
     // This really should not happen because whether the reaction is feasible is
     // checked before computing reaction time or propensity.
-    if (!sp_updating.dec_count(stoichio)) { // State update
-      std::string err = "Not enough reactants of " + sv_updating.get_label()
-                      + "[" + std::to_string(sp_updating.get_count())
+    if (!m_net_ptr->dec_species_count(u.first, stoichio)) { // State update
+      std::string err = "Not enough reactants of "
+                      + g[m_net_ptr->species_i2d(u.first)].get_label()
+                      + "[" + std::to_string(m_net_ptr->species_count(u.first))
                       + "] for reaction " + g[rd_firing].get_label();
       WCS_THROW(err);
-      //return false; // TODO: graceful termination
     }
   #endif
   #ifdef ENABLE_SPECIES_UPDATE_TRACKING
     #pragma omp critical
     {
-      updating_species.emplace_back(std::make_pair(vd_updating, -stoichio));
+      updating_species.emplace_back(
+        std::make_pair(m_net_ptr->species_i2d(u.first), -stoichio));
     }
   #endif // ENABLE_SPECIES_UPDATE_TRACKING
-
-    for (const auto vi_affected :
-         boost::make_iterator_range(boost::out_edges(vd_updating, g)))
-    {
-      const auto rd_affected = boost::target(vi_affected, g);
-      if (rd_affected == rd_firing) continue;
-     #if defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
-      if (m_net_ptr->graph()[rd_affected].get_partition() != pid) continue;
-     #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
-      #pragma omp critical
-      {
-        reactions_affected.insert(rd_affected);
-      }
-    }
   }
- #else // defined(_OPENMP) && defined(WCS_OMP_REACTION_REACTANTS) // -----------
-  for (const auto ei_in :
-       boost::make_iterator_range(boost::in_edges(rd_firing, g)))
-  {
-    const auto vd_updating = boost::source(ei_in, g);
-    const auto& sv_updating = g[vd_updating];
-    if constexpr (wcs::Vertex::_num_vertex_types_  > 3) {
-      // in case that there are other type of vertices than species or reaction
-      if (sv_updating.get_type() != wcs::Vertex::_species_) continue;
-    }
-
-    auto& sp_updating = sv_updating.property<s_prop_t>();
-    const auto stoichio = g[ei_in].get_stoichiometry_ratio();
-    if (stoichio == static_cast<stoic_t>(0)) {
-      continue;
-    }
-  #ifdef NDEBUG
-    sp_updating.dec_count(stoichio);
-  #else
-    // This really should not happen because whether the reaction is feasible is
-    // checked before computing reaction time or propensity.
-    if (!sp_updating.dec_count(stoichio)) { // State update
-      std::string err = "Not enough reactants of " + sv_updating.get_label()
-                      + "[" + std::to_string(sp_updating.get_count())
-                      + "] for reaction " + g[rd_firing].get_label();
-      //m_net_ptr->print();
-      WCS_THROW(err);
-      return false;
-    }
-  #endif
-  #ifdef ENABLE_SPECIES_UPDATE_TRACKING
-    updating_species.emplace_back(std::make_pair(vd_updating, -stoichio));
-  #endif // ENABLE_SPECIES_UPDATE_TRACKING
-
-    for (const auto vi_affected :
-         boost::make_iterator_range(boost::out_edges(vd_updating, g)))
-    {
-      const auto rd_affected = boost::target(vi_affected, g);
-      if (rd_affected == rd_firing) continue;
-     #if defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
-      if (m_net_ptr->graph()[rd_affected].get_partition() != pid) continue;
-     #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
-      reactions_affected.insert(rd_affected);
-    }
-  }
- #endif // defined(_OPENMP) && defined(WCS_OMP_REACTION_REACTANTS) // ----------
 
   // ========================== product species ================================
+  const auto products = m_net_ptr->get_product_updates(rd_firing);
  #if defined(_OPENMP) && defined(WCS_OMP_REACTION_PRODUCTS) // -----------------
-  using oe_iter_t = boost::graph_traits<Network::graph_t>::out_edge_iterator;
-  oe_iter_t oei, oei_end;
-  boost::tie(oei, oei_end) = boost::out_edges(rd_firing, g);
-  const std::vector<e_desc_t> outedges(oei, oei_end);
-  const size_t noe = outedges.size();
+  const auto np = static_cast<size_t>(products.size());
 
   #pragma omp parallel for //schedule(dynamic)
-  for (size_t i = 0u; i < noe; ++i)
+  for (size_t i = 0u; i < np; ++i)
   {
-    const auto& ei_out = outedges[i];
-    const auto vd_updating = boost::target(ei_out, g);
-    const auto& sv_updating = g[vd_updating];
-    if constexpr (wcs::Vertex::_num_vertex_types_  > 3) {
-      // in case that there are other type of vertices than species or reaction
-      if (sv_updating.get_type() != wcs::Vertex::_species_) continue;
-    }
-
-    auto& sp_updating = sv_updating.property<s_prop_t>();
-    const auto stoichio = g[ei_out].get_stoichiometry_ratio();
-    if (stoichio == static_cast<stoic_t>(0)) {
-      continue;
-    }
-  #ifdef NDEBUG
-    sp_updating.inc_count(stoichio);
-  #else
-    if (!sp_updating.inc_count(stoichio)) { // State update
-      std::string err = "Can not produce more of " + sv_updating.get_label()
-                      + "[" + std::to_string(sp_updating.get_count())
-                      + "] by reaction " + g[rd_firing].get_label();
-      WCS_THROW(err);
-      //return false; // TODO: graceful termination
-    }
-  #endif
-  #ifdef ENABLE_SPECIES_UPDATE_TRACKING
-    #pragma omp critical
-    {
-      updating_species.emplace_back(std::make_pair(vd_updating, stoichio));
-    }
-  #endif // ENABLE_SPECIES_UPDATE_TRACKING
-
-    for (const auto vi_affected :
-         boost::make_iterator_range(boost::out_edges(vd_updating, g)))
-    {
-      const auto rd_affected = boost::target(vi_affected, g);
-      if (rd_affected == rd_firing) continue;
-     #if defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
-      if (m_net_ptr->graph()[rd_affected].get_partition() != pid) continue;
-     #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
-      #pragma omp critical
-      {
-        reactions_affected.insert(rd_affected);
-      }
-    }
-  }
+    const auto& u = products[i];
  #else // defined(_OPENMP) && defined(WCS_OMP_REACTION_PRODUCTS) // ------------
-  for (const auto ei_out :
-       boost::make_iterator_range(boost::out_edges(rd_firing, g)))
+  for (const auto& u : products)
   {
-    const auto vd_updating = boost::target(ei_out, g);
-    const auto& sv_updating = g[vd_updating];
-    if constexpr (wcs::Vertex::_num_vertex_types_  > 3) {
-      // in case that there are other type of vertices than species or reaction
-      if (sv_updating.get_type() != wcs::Vertex::_species_) continue;
-    }
-
-    auto& sp_updating = sv_updating.property<s_prop_t>();
-    const auto stoichio = g[ei_out].get_stoichiometry_ratio();
-    if (stoichio == static_cast<stoic_t>(0)) {
-      continue;
-    }
+ #endif // defined(_OPENMP) && defined(WCS_OMP_REACTION_PRODUCTS) // -----------
+    const auto stoichio = u.second;
   #ifdef NDEBUG
-    sp_updating.inc_count(stoichio);
+    m_net_ptr->inc_species_count(u.first, stoichio);
   #else
-    if (!sp_updating.inc_count(stoichio)) { // State update
-      std::string err = "Can not produce more of " + sv_updating.get_label()
-                      + "[" + std::to_string(sp_updating.get_count())
+    if (!m_net_ptr->inc_species_count(u.first, stoichio)) { // State update
+      std::string err = "Can not produce more of "
+                      + g[m_net_ptr->species_i2d(u.first)].get_label()
+                      + "[" + std::to_string(m_net_ptr->species_count(u.first))
                       + "] by reaction " + g[rd_firing].get_label()
                       + ". To enable 64-bit counter, rebuild using the cmake "
                       + "option '-DWCS_64BIT_CNT=ON'.";
       WCS_THROW(err);
-      return false;
     }
   #endif
   #ifdef ENABLE_SPECIES_UPDATE_TRACKING
-    updating_species.emplace_back(std::make_pair(vd_updating, stoichio));
-  #endif // ENABLE_SPECIES_UPDATE_TRACKING
-
-    for (const auto vi_affected :
-         boost::make_iterator_range(boost::out_edges(vd_updating, g)))
+    #pragma omp critical
     {
-      const auto rd_affected = boost::target(vi_affected, g);
-      if (rd_affected == rd_firing) continue;
-     #if defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
-      if (m_net_ptr->graph()[rd_affected].get_partition() != pid) continue;
-     #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
-      reactions_affected.insert(rd_affected);
+      updating_species.emplace_back(
+        std::make_pair(m_net_ptr->species_i2d(u.first), stoichio));
     }
+  #endif // ENABLE_SPECIES_UPDATE_TRACKING
   }
- #endif // defined(_OPENMP) && defined(WCS_OMP_REACTION_PRODUCTS) // -----------
 
   return true;
 }
@@ -388,35 +476,21 @@ void Sim_Method::undo_species_updates(const cnt_updates_t& updates) const
  */
 bool Sim_Method::undo_reaction(const Sim_Method::v_desc_t& rd_undo) const
 {
-  using s_prop_t = wcs::Species;
-
-  // Reactions do not change the connectivity, but only change the property
-  // data, which are allocated outside of BGL graph, but only linked to it.
+ #if !defined(NDEBUG)
   const wcs::Network::graph_t& g = m_net_ptr->graph();
+ #endif // !defined(NDEBUG)
 
   // reactant species
-  for (const auto ei_in :
-       boost::make_iterator_range(boost::in_edges(rd_undo, g)))
+  for (const auto& u : m_net_ptr->get_reactant_updates(rd_undo))
   {
-    const auto vd_reverting = boost::source(ei_in, g);
-    const auto& sv_reverting = g[vd_reverting];
-    if constexpr (wcs::Vertex::_num_vertex_types_  > 3) {
-      // in case that there are other type of vertices than species or reaction
-      if (sv_reverting.get_type() != wcs::Vertex::_species_) continue;
-    }
-
-    auto& sp_reverting = sv_reverting.property<s_prop_t>();
-    const auto stoichio = g[ei_in].get_stoichiometry_ratio();
-    if (stoichio == static_cast<stoic_t>(0)) {
-      continue;
-    }
+    const auto stoichio = u.second;
   #ifdef NDEBUG
-    sp_reverting.inc_count(stoichio);
+    m_net_ptr->inc_species_count(u.first, stoichio);
   #else
-    if (!sp_reverting.inc_count(stoichio)) { // State update
+    if (!m_net_ptr->inc_species_count(u.first, stoichio)) { // State update
       std::string err = "Unable to undo the decrement of reactant "
-                      + sv_reverting.get_label()
-                      + "[" + std::to_string(sp_reverting.get_count())
+                      + g[m_net_ptr->species_i2d(u.first)].get_label()
+                      + "[" + std::to_string(m_net_ptr->species_count(u.first))
                       + "] for reaction " + g[rd_undo].get_label();
       WCS_THROW(err);
       return false;
@@ -425,28 +499,16 @@ bool Sim_Method::undo_reaction(const Sim_Method::v_desc_t& rd_undo) const
   }
 
   // product species
-  for (const auto ei_out :
-       boost::make_iterator_range(boost::out_edges(rd_undo, g)))
+  for (const auto& u : m_net_ptr->get_product_updates(rd_undo))
   {
-    const auto vd_reverting = boost::target(ei_out, g);
-    const auto& sv_reverting = g[vd_reverting];
-    if constexpr (wcs::Vertex::_num_vertex_types_  > 3) {
-      // in case that there are other type of vertices than species or reaction
-      if (sv_reverting.get_type() != wcs::Vertex::_species_) continue;
-    }
-
-    auto& sp_reverting = sv_reverting.property<s_prop_t>();
-    const auto stoichio = g[ei_out].get_stoichiometry_ratio();
-    if (stoichio == static_cast<stoic_t>(0)) {
-      continue;
-    }
+    const auto stoichio = u.second;
   #ifdef NDEBUG
-    sp_reverting.dec_count(stoichio);
+    m_net_ptr->dec_species_count(u.first, stoichio);
   #else
-    if (!sp_reverting.dec_count(stoichio)) { // State update
+    if (!m_net_ptr->dec_species_count(u.first, stoichio)) { // State update
       std::string err = "Unable to undo the production of "
-                      + sv_reverting.get_label()
-                      + "[" + std::to_string(sp_reverting.get_count())
+                      + g[m_net_ptr->species_i2d(u.first)].get_label()
+                      + "[" + std::to_string(m_net_ptr->species_count(u.first))
                       + "] by reaction " + g[rd_undo].get_label();
       WCS_THROW(err);
       return false;
@@ -20,6 +20,7 @@
 #include <cmath>
 #include <limits>
 #include <unordered_map>
+#include <vector>
 #include <memory> // unique_ptr
 #include "sim_methods/sim_state_change.hpp"
 #include "utils/rngen.hpp"
@@ -44,6 +45,9 @@ public:
 
   enum result_t {Success, Empty, Inactive};
 
+  /// Type for the number of times a reaction fired
+  using firing_count_t = uint64_t;
+
   Sim_Method(const std::shared_ptr<wcs::Network>& net_ptr);
   Sim_Method(Sim_Method&& other) = default;
   Sim_Method& operator=(Sim_Method&& other) = default;
@@ -70,12 +74,28 @@ public:
                     const std::string outfile = "",
                     const unsigned frag_size = default_frag_size);
 
+  /**
+   * Write the trajectory fragments in the background using the given number
+   * of buffers, or synchronously with 0. Call after enabling tracing/sampling.
+   */
+  void set_async_recording(const unsigned num_buffers);
+
   /// Disable trajectory recording (tracing/sampling)
   void unset_recording();
 
   /// Record the initial state of simulation for tracing/sampling
   void initialize_recording(const std::shared_ptr<wcs::Network>& net_ptr);
 
+  /**
+   * Count how many times each reaction fires, which is used to build the
+   * activity profile of the network for partitioning. Firings are counted
+   * where they are recorded, i.e., at commit time with ROSS.
+   */
+  void set_profiling();
+  bool is_profiling() const { return m_profiling; }
+  /// Return the number of firings of each reaction in the order of the index
+  const std::vector<firing_count_t>& get_firing_counts() const;
+
   /// Record the state at current step
   void record(const v_desc_t rv);
 
@@ -120,6 +140,27 @@ public:
   /// Finalize the internal trajectory recorder
   void finalize_recording();
 
+  /**
+   * Save a checkpoint into the given file every given number of iterations
+   * and/or seconds of wall-clock time. An interval of 0 disables the trigger.
+   * Call after `init()`, and after `load_checkpoint()` when resuming.
+   */
+  void set_checkpointing(const std::string& ckpt_file,
+                         const sim_iter_t iter_interval,
+                         const double wall_interval);
+  /**
+   * Save the full state of the simulation into the given file. The file is
+   * replaced only after the new checkpoint is completely written.
+   */
+  void save_checkpoint(const std::string& ckpt_file);
+  /**
+   * Restore the state saved by `save_checkpoint()`. Call after `init()` with
+   * the same network, method and recording options as those of the run that
+   * was checkpointed. Then, `run()` continues with the same sequence of
+   * events as the uninterrupted run.
+   */
+  void load_checkpoint(const std::string& ckpt_file);
+
   virtual std::pair<sim_iter_t, sim_time_t> run() = 0;
 
   bool fire_reaction(Sim_State_Change& digest);
@@ -129,6 +170,24 @@ public:
  #endif // ENABLE_SPECIES_UPDATE_TRACKING
   bool undo_reaction(const Sim_Method::v_desc_t& rd_undo) const;
 
+  /// Take a checkpoint if due. This is called by `run()` in between events.
+  void checkpoint_if_due();
+  /// Check the triggers of checkpointing, and take one if due
+  void poll_checkpoint();
+  /// Set the iteration at which to check the triggers next
+  void schedule_checkpoint_poll();
+  /**
+   * Save/load the state specific to the method, which with the network state
+   * allows continuing the exact sequence of events. By default, these throw
+   * as checkpointing is not supported.
+   */
+  virtual void save_method_state(std::ostream& os) const;
+  virtual void load_method_state(std::istream& is);
+  /// Write the name identifying the layout of the method state
+  static void save_state_tag(std::ostream& os, const std::string& tag);
+  /// Check the name of the layout of the method state against the given one
+  static void check_state_tag(std::istream& is, const std::string& tag);
+
   sim_iter_t get_max_iter() const;
   sim_time_t get_max_time() const;
 
@@ -153,12 +212,31 @@ protected:
 
   std::unique_ptr<Trajectory> m_trajectory; ///< Trajectory recorder
 
+  bool m_profiling; ///< Whether to count the firings of each reaction
+  /// Number of firings of each reaction by the reaction index
+  std::vector<firing_count_t> m_firing_counts;
+
+  /// File to save checkpoints into, which is empty if disabled
+  std::string m_ckpt_file;
+  sim_iter_t m_ckpt_iter_interval; ///< Checkpoint interval in iterations
+  double m_ckpt_wall_interval; ///< Checkpoint interval in wall-clock seconds
+  sim_iter_t m_ckpt_next_iter; ///< Iteration due for the next checkpoint
+  sim_iter_t m_ckpt_next_poll; ///< Iteration to check the triggers next
+  double m_ckpt_last_wall; ///< Wall-clock time of the last checkpoint
+
  #if defined(_OPENMP)
   int m_num_threads;
  #endif // defined(_OPENMP)
 };
 
 
+inline void Sim_Method::checkpoint_if_due()
+{
+  if (m_sim_iter >= m_ckpt_next_poll) {
+    poll_checkpoint();
+  }
+}
+
 template <typename T>
 void Sim_Method::set_tracing(const std::string outfile,
                              const unsigned frag_size)
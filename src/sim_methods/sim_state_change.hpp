@@ -27,8 +27,9 @@ struct Sim_State_Change {
   /** Type for keeping track of species updates to facilitate undoing
    *  reaction processing.  */
   /** Type for the list of reactions that share any of the species with the
-   *  firing reaction */
-  using affected_reactions_t = std::set<v_desc_t>;
+   *  firing reaction. This is a view into the static dependency graph kept
+   *  by the network. */
+  using affected_reactions_t = wcs::Network::affected_reactions_t;
   using reaction_times_t = std::vector<std::pair<v_desc_t, sim_time_t> >;
   using revent_t = std::pair<sim_time_t, v_desc_t>;
 
@@ -58,6 +59,12 @@ struct Sim_State_Change {
   /// Serialized RNG states
   std::vector<char> m_rng_state;
 
+  /**
+   *  The number of values drawn from the RNG by the event. This rolls back
+   *  a reversible generator without saving its state in m_rng_state.
+   */
+  size_t m_rng_draws = 0ul;
+
   Sim_State_Change(const revent_t& firing)
   : m_sim_time(firing.first), m_reaction_fired(firing.second) {}
 
@@ -72,9 +79,10 @@ struct Sim_State_Change {
    #ifdef ENABLE_SPECIES_UPDATE_TRACKING
     m_species_updated.clear();
    #endif // ENABLE_SPECIES_UPDATE_TRACKING
-    m_reactions_affected.clear();
+    m_reactions_affected = affected_reactions_t();
     m_reaction_times.clear();
     m_rng_state.clear();
+    m_rng_draws = 0ul;
   }
 };
 
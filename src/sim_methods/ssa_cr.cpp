@@ -0,0 +1,458 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <cmath> // log, frexp, ldexp
+#include "sim_methods/ssa_cr.hpp"
+#include "utils/exception.hpp"
+#include "utils/seed.hpp"
+
+#if defined(WCS_HAS_CEREAL)
+#include "utils/state_io_cereal.hpp"
+#endif // WCS_HAS_CEREAL
+
+namespace wcs {
+/** \addtogroup wcs_reaction_network
+ *  @{ */
+
+SSA_CR::SSA_CR(const std::shared_ptr<wcs::Network>& net_ptr)
+: Sim_Method(net_ptr),
+  m_bin_min(m_no_bin),
+  m_bin_max(m_no_bin),
+  m_total(static_cast<reaction_rate_t>(0.0))
+{}
+
+SSA_CR::~SSA_CR() {}
+
+/// Allow access to the internal random number generator for events
+SSA_CR::rng_t& SSA_CR::rgen_e() {
+  return m_rgen_evt;
+}
+
+/// Allow access to the internal random number generator for event times
+SSA_CR::rng_t& SSA_CR::rgen_t() {
+  return m_rgen_tm;
+}
+
+SSA_CR::bin_idx_t SSA_CR::get_bin_idx(const reaction_rate_t rate)
+{
+  if (BOOST_UNLIKELY(!std::isfinite(rate))) {
+    WCS_THROW("Invalid reaction rate: " + std::to_string(rate));
+  }
+  // rate = frac * 2^exp where frac is in [0.5, 1)
+  bin_exp_t exp = 0;
+  std::frexp(rate, &exp);
+  return static_cast<bin_idx_t>(exp - m_exp_min);
+}
+
+reaction_rate_t SSA_CR::get_bin_ubound(const bin_idx_t bin_idx)
+{
+  return std::ldexp(static_cast<reaction_rate_t>(1.0),
+                    static_cast<bin_exp_t>(bin_idx) + m_exp_min);
+}
+
+void SSA_CR::insert_reaction(const v_desc_t vd, const reaction_rate_t rate)
+{
+  if (rate <= static_cast<reaction_rate_t>(0.0)) {
+    m_pindices[vd] = std::make_pair(m_no_bin, 0ul);
+    return;
+  }
+
+  const auto bin_idx = get_bin_idx(rate);
+  auto& bin = m_bins[bin_idx];
+  m_pindices[vd] = std::make_pair(bin_idx, bin.m_reactions.size());
+  bin.m_reactions.emplace_back(priority_t(rate, vd));
+  bin.m_sum += rate;
+
+  // The range of bins in use only grows, such that an insertion or a removal
+  // does not require searching for the new boundary.
+  if ((m_bin_min == m_no_bin) || (bin_idx < m_bin_min)) {
+    m_bin_min = bin_idx;
+  }
+  if ((m_bin_max == m_no_bin) || (bin_idx > m_bin_max)) {
+    m_bin_max = bin_idx;
+  }
+}
+
+void SSA_CR::remove_reaction(const v_desc_t vd)
+{
+  auto& pos = m_pindices.at(vd);
+  const auto bin_idx = pos.first;
+  if (bin_idx == m_no_bin) {
+    return;
+  }
+  auto& bin = m_bins[bin_idx];
+  auto& reactions = bin.m_reactions;
+  const auto offset = pos.second;
+
+  bin.m_sum -= reactions[offset].first;
+
+  // Fill the hole with the last one in the bin
+  if (offset + 1ul != reactions.size()) {
+    reactions[offset] = reactions.back();
+    m_pindices.at(reactions[offset].second).second = offset;
+  }
+  reactions.pop_back();
+
+  if (reactions.empty()) {
+    // Clear the round-off error accumulated over the updates
+    bin.m_sum = static_cast<reaction_rate_t>(0.0);
+  }
+  pos.first = m_no_bin;
+}
+
+void SSA_CR::update_propensity(const v_desc_t vd, const reaction_rate_t rate)
+{
+  const auto& pos = m_pindices.at(vd);
+  const bool active = (rate > static_cast<reaction_rate_t>(0.0));
+
+  if ((pos.first != m_no_bin) && active && (pos.first == get_bin_idx(rate))) {
+    // Remain in the same bin. Only adjust the propensity and the bin sum.
+    auto& bin = m_bins[pos.first];
+    auto& p = bin.m_reactions[pos.second];
+    bin.m_sum += rate - p.first;
+    p.first = rate;
+    return;
+  }
+
+  remove_reaction(vd);
+  insert_reaction(vd, rate);
+}
+
+void SSA_CR::update_total_propensity()
+{
+  m_total = static_cast<reaction_rate_t>(0.0);
+  if (m_bin_min == m_no_bin) {
+    return;
+  }
+  for (bin_idx_t i = m_bin_min; i <= m_bin_max; ++i) {
+    m_total += m_bins[i].m_sum;
+  }
+}
+
+/**
+ * Initialize the propensity bins by placing every reaction into the bin
+ * corresponding to its propensity.
+ */
+void SSA_CR::build_propensity_bins()
+{
+  m_bins.clear();
+  m_bins.resize(static_cast<size_t>(m_exp_max - m_exp_min + 1),
+                bin_t{static_cast<reaction_rate_t>(0.0), {}});
+  m_pindices.clear();
+  m_pindices.reserve(m_net_ptr->get_num_reactions()+1);
+  m_bin_min = m_no_bin;
+  m_bin_max = m_no_bin;
+
+  for (const auto& vd : m_net_ptr->reaction_list())
+  {
+    insert_reaction(vd, m_net_ptr->get_reaction_rate(vd));
+  }
+  update_total_propensity();
+}
+
+/**
+ * Randomly determine which reaction to fire. First, select a bin with the
+ * probability proportional to the bin sum via linear search starting from
+ * the bin of the largest propensities. Then, select a reaction within the bin
+ * by rejection sampling using the upper bound of the propensities in the bin.
+ */
+SSA_CR::v_desc_t SSA_CR::choose_reaction()
+{
+  auto rn = static_cast<reaction_rate_t>(m_rgen_evt() * m_total);
+
+  bin_idx_t bin_idx = m_bin_max;
+  for (; bin_idx > m_bin_min; --bin_idx) {
+    const auto sum = m_bins[bin_idx].m_sum;
+    if (rn < sum) break;
+    rn -= sum;
+  }
+  // Guard against the round-off error leading to an empty bin
+  while (m_bins[bin_idx].m_reactions.empty()) {
+    if (bin_idx == m_bin_max) {
+      WCS_THROW("Failed to choose a reaction to fire");
+    }
+    ++ bin_idx;
+  }
+
+  const auto& reactions = m_bins[bin_idx].m_reactions;
+  const auto ubound = get_bin_ubound(bin_idx);
+  const auto num = static_cast<reaction_rate_t>(reactions.size());
+
+  while (true) {
+    // The integral part of a uniform random number scaled by the number of
+    // reactions in the bin selects a reaction, and the fractional part serves
+    // as the random number for the acceptance test.
+    const auto r = static_cast<reaction_rate_t>(m_rgen_evt() * num);
+    const auto i = static_cast<size_t>(r);
+    if (BOOST_UNLIKELY(i >= reactions.size())) {
+      continue;
+    }
+    const auto& p = reactions[i];
+    if ((r - static_cast<reaction_rate_t>(i)) * ubound < p.first) {
+      return p.second;
+    }
+  }
+}
+
+/// Randomly determine the time period until the next reaction
+sim_time_t SSA_CR::get_reaction_time()
+{
+  return ((m_total <= static_cast<reaction_rate_t>(0))?
+            wcs::Network::get_etime_ulimit() :
+            -static_cast<reaction_rate_t>(log(m_rgen_tm())/m_total));
+}
+
+/**
+ * Recompute the reaction rates of those affected which are linked with
+ * updating species, and move them to the bins corresponding to the new rates.
+ */
+void SSA_CR::update_reactions(const v_desc_t vd_fired,
+  const Sim_Method::affected_reactions_t& affected_reactions,
+  bool check_reaction)
+{
+  constexpr auto zero_rate = static_cast<reaction_rate_t>(0.0);
+
+  if (check_reaction && !m_net_ptr->check_reaction(vd_fired)) {
+    update_propensity(vd_fired, zero_rate);
+  } else {
+    // update the propensity of the fired reaction
+    update_propensity(vd_fired, m_net_ptr->set_reaction_rate(vd_fired));
+  }
+
+  // update the propensity of the rest of affected reactions
+  for (const auto& vd : affected_reactions) {
+    // For reverse computation, this could have been restored from memory
+    // instead of computation.
+    if (check_reaction && !m_net_ptr->check_reaction(vd)) {
+      update_propensity(vd, zero_rate);
+    } else {
+      update_propensity(vd, m_net_ptr->set_reaction_rate(vd));
+    }
+  }
+
+  update_total_propensity();
+}
+
+
+void SSA_CR::init(const sim_iter_t max_iter,
+                  const double max_time,
+                  const unsigned rng_seed)
+{
+  if (!m_net_ptr) {
+    WCS_THROW("Invalid pointer to the reaction network.");
+  }
+
+  m_max_time = max_time;
+  m_max_iter = max_iter;
+  m_sim_time = static_cast<sim_time_t>(0);
+  m_sim_iter = static_cast<sim_iter_t>(0u);
+
+  { // initialize the random number generator
+    if (rng_seed == 0u) {
+      m_rgen_evt.set_seed();
+      m_rgen_tm.set_seed();
+    } else {
+      seed_seq_param_t common_param_e
+        = make_seed_seq_input(1, rng_seed, std::string("SSA_CR"));
+      seed_seq_param_t common_param_t
+        = make_seed_seq_input(2, rng_seed, std::string("SSA_CR"));
+
+      std::vector<seed_seq_param_t> unique_params;
+      const size_t num_procs = 1ul;
+      const size_t my_rank = 0ul;
+
+      // make sure to avoid generating any duplicate seed sequence
+      gen_unique_seed_seq_params<rng_t::get_state_size()>(
+          num_procs, common_param_e, unique_params);
+      m_rgen_evt.use_seed_seq(unique_params[my_rank]);
+
+      // make sure to avoid generating any duplicate seed sequence
+      gen_unique_seed_seq_params<rng_t::get_state_size()>(
+          num_procs, common_param_t, unique_params);
+      m_rgen_tm.use_seed_seq(unique_params[my_rank]);
+    }
+
+    m_rgen_evt.param(typename rng_t::param_type(0.0, 1.0));
+    m_rgen_tm.param(typename rng_t::param_type(0.0, 1.0));
+  }
+
+  Sim_Method::initialize_recording(m_net_ptr);
+
+  build_propensity_bins(); // prepare internal bins
+ #if defined(WCS_HAS_ROSS)
+  m_digests.emplace_back();
+  m_digests.back().m_sim_time = m_sim_time;
+ #endif // defined(WCS_HAS_ROSS)
+}
+
+
+void SSA_CR::save_rgen_state(Sim_State_Change& digest)
+{
+  const size_t rng_state_size = m_rgen_evt.engine_byte_size()
+                              + m_rgen_tm.engine_byte_size();
+  digest.m_rng_state.clear();
+  digest.m_rng_state.reserve(rng_state_size);
+  wcs::ostreamvec<char> ostrmbuf(digest.m_rng_state);
+  std::ostream os(&ostrmbuf);
+
+ #if defined(WCS_HAS_CEREAL)
+  cereal::BinaryOutputArchive oarchive(os);
+  oarchive(m_rgen_evt.engine(), m_rgen_tm.engine());
+ #else
+  m_rgen_evt.save_engine_bits(os);
+  m_rgen_tm.save_engine_bits(os);
+ #endif // defined(WCS_HAS_CEREAL)
+}
+
+
+void SSA_CR::load_rgen_state(const Sim_State_Change& digest)
+{
+  wcs::istreamvec<char> istrmbuf(digest.m_rng_state);
+  std::istream is(&istrmbuf);
+
+ #if defined(WCS_HAS_CEREAL)
+  cereal::BinaryInputArchive iarchive(is);
+  iarchive(m_rgen_evt.engine(), m_rgen_tm.engine());
+ #else
+  m_rgen_evt.load_engine_bits(is);
+  m_rgen_tm.load_engine_bits(is);
+ #endif // defined(WCS_HAS_CEREAL)
+}
+
+
+Sim_Method::result_t SSA_CR::schedule(sim_time_t& next_time)
+{
+  if (BOOST_UNLIKELY(m_pindices.empty())) { // no reaction possible
+    std::cerr << "No reaction exists." << std::endl;
+    return Empty;
+  }
+
+  // Determine when the next reaction to occur
+  const auto dt = get_reaction_time();
+  next_time = m_sim_time + dt;
+
+  if (BOOST_UNLIKELY((dt >= wcs::Network::get_etime_ulimit()) ||
+                     (next_time > m_max_time))) {
+    std::cerr << "No more reaction can fire." << std::endl;
+    return Inactive;
+  }
+
+  return Success;
+}
+
+
+bool SSA_CR::forward(const sim_time_t t)
+{
+  if (BOOST_UNLIKELY((m_sim_iter >= m_max_iter) || (t > m_max_time))) {
+    return false; // do not continue simulation
+  }
+  ++ m_sim_iter;
+  m_sim_time = t;
+
+ #if defined(WCS_HAS_ROSS)
+  m_digests.emplace_back();
+  auto& digest = m_digests.back();
+  // Backup RNG state before calling choose_reaction()
+  save_rgen_state(digest);
+ #else
+  Sim_State_Change digest;
+ #endif // defined(WCS_HAS_ROSS)
+
+  // Determine the reaction to occur at this time
+  const auto vd_fired = choose_reaction();
+
+  digest.m_sim_time = t;
+  digest.m_reaction_fired = vd_fired;
+
+  // Execute the reaction, updating species counts
+  Sim_Method::fire_reaction(digest);
+
+  // Update the propensities of those reactions fired and affected
+  update_reactions(vd_fired, digest.m_reactions_affected, true);
+
+ #if !defined(WCS_HAS_ROSS)
+  // With ROSS, tracing and sampling are moved to process at commit time
+  record(vd_fired);
+ #endif // defined(WCS_HAS_ROSS)
+
+  return true;
+}
+
+
+#if defined(WCS_HAS_ROSS)
+void SSA_CR::backward(sim_time_t& t)
+{
+  // State of the last event to undo
+  Sim_State_Change& digest = m_digests.back();
+  // The BGL vertex descriptor of the the reaction to undo
+  const auto& rd_fired = digest.m_reaction_fired;
+
+  // Undo the species update done by the reaction fired
+  undo_reaction(rd_fired);
+  // Undo the propensity updates done for the reactions affected
+  update_reactions(rd_fired, digest.m_reactions_affected, false);
+
+  // Restore the schedule
+  t = digest.m_sim_time;
+  // Restore the RNG state
+  load_rgen_state(digest);
+  // Free the state of the last event
+  m_digests.pop_back();
+
+  // Restore the current simulation time and iteration
+  if (BOOST_UNLIKELY(m_digests.empty() ||
+     (m_sim_iter == static_cast<sim_iter_t>(0)))) {
+    WCS_THROW("Not able to schedule any reaction event!");
+  } else {
+    m_sim_time = m_digests.back().m_sim_time;
+    m_sim_iter --;
+  }
+}
+
+
+void SSA_CR::record_first_n(const sim_iter_t num)
+{
+  if (m_digests.size() < 1ul) return;
+  sim_iter_t i = static_cast<sim_iter_t>(0u);
+
+  digest_list_t::iterator it = m_digests.begin();
+
+  for (++it; it != m_digests.end(); ++it) {
+    if (i >= num) break;
+    record(it->m_sim_time, it->m_reaction_fired);
+    i ++;
+  }
+  m_digests.erase(m_digests.begin(), --it);
+}
+#endif // defined(WCS_HAS_ROSS)
+
+
+std::pair<sim_iter_t, sim_time_t> SSA_CR::run()
+{
+  sim_time_t t = static_cast<sim_time_t>(0);
+
+  if (schedule(t) != Success) {
+    WCS_THROW("Not able to schedule any reaction event!");
+  }
+
+  while (BOOST_LIKELY(forward(t))) {
+    if (BOOST_UNLIKELY(schedule(t) != Success)) {
+      break;
+    }
+  }
+ #if defined(WCS_HAS_ROSS)
+  record_first_n(m_sim_iter);
+ #endif // defined(WCS_HAS_ROSS)
+
+  return std::make_pair(m_sim_iter, m_sim_time);
+}
+
+/**@}*/
+} // end of namespace wcs
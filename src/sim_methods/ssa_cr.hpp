@@ -0,0 +1,160 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef __WCS_SIM_METHODS_SSA_CR_HPP__
+#define __WCS_SIM_METHODS_SSA_CR_HPP__
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include "sim_methods/sim_method.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_sim_methods
+ *  @{ */
+
+/**
+ *  Composition-rejection SSA method (Slepoy, Thompson and Plimpton, 2008).
+ *  Reactions are grouped into bins by the binary exponent of their propensity
+ *  such that every propensity in the bin of exponent `e` falls within
+ *  [2^(e-1), 2^e). A bin is chosen by a linear search over the bin sums, of
+ *  which there are only as many as the dynamic range of the propensities in
+ *  powers of two. Then, a reaction within the bin is chosen by rejection
+ *  sampling, which accepts with the probability of at least one half.
+ *  Updating the propensity of a reaction only moves it between bins, which
+ *  costs O(1) regardless of the size of the network.
+ */
+class SSA_CR : public Sim_Method {
+public:
+  using rng_t = wcs::RNGen<std::uniform_real_distribution, double>;
+  using v_desc_t = Sim_Method::v_desc_t;
+  using priority_t = std::pair<reaction_rate_t, v_desc_t>;
+  /// Type of the binary exponent of a propensity, which identifies a bin
+  using bin_exp_t = int;
+  /// Type of the index of a bin in the bin list
+  using bin_idx_t = int;
+
+  /// Group of reactions of which the propensities are of the same exponent
+  struct bin_t {
+    /// Sum of the propensities of the reactions in the bin
+    reaction_rate_t m_sum;
+    /// Propensity and the vertex descriptor of each reaction in the bin
+    std::vector<priority_t> m_reactions;
+  };
+
+  /// Position of a reaction in the bin list as the bin index and the offset
+  using bin_pos_t = std::pair<bin_idx_t, size_t>;
+  using bin_list_t = std::vector<bin_t>;
+
+  SSA_CR(const std::shared_ptr<wcs::Network>& net_ptr);
+  SSA_CR(SSA_CR&& other) = default;
+  SSA_CR& operator=(SSA_CR&& other) = default;
+  ~SSA_CR() override;
+
+  /// Initialize propensity bins
+  void init(const unsigned max_iter,
+            const double max_time,
+            const unsigned rng_seed) override;
+
+  /**
+   * Determines when the next reaction to occur.
+   * When successful, this function returns Sim_Method::Success. Otherwise,
+   * it returns a failure code.
+   */
+  Sim_Method::result_t schedule(sim_time_t& t);
+  /**
+   * Determine which reaction to fire and execute it at the given time.
+   * Check the simulation termination condition at the beginning. If it is not
+   * to be terminated yet, proceed and return true. Otherwise, stop immediately
+   * and return false.
+   */
+  bool forward(const sim_time_t t);
+  /// Main loop of SSA
+  std::pair<unsigned, sim_time_t> run() override;
+
+ #if defined(WCS_HAS_ROSS)
+  void backward(sim_time_t& t);
+
+  /** Record as many states as the given number of iterations from the
+   *  beginning of the digest list */
+  void record_first_n(const sim_iter_t num) override;
+ #endif // defined(WCS_HAS_ROSS)
+
+  rng_t& rgen_e();
+  rng_t& rgen_t();
+
+protected:
+  /// Return the index of the bin that a reaction of the given rate belongs to
+  static bin_idx_t get_bin_idx(const reaction_rate_t rate);
+  /// Return the upper bound of the propensities in the given bin
+  static reaction_rate_t get_bin_ubound(const bin_idx_t bin_idx);
+
+  void build_propensity_bins();
+  /// Place a reaction with the given rate into the corresponding bin
+  void insert_reaction(const v_desc_t vd, const reaction_rate_t rate);
+  /// Remove a reaction from the bin that it currently belongs to
+  void remove_reaction(const v_desc_t vd);
+  /// Reflect the new rate of a reaction by moving it between bins if needed
+  void update_propensity(const v_desc_t vd, const reaction_rate_t rate);
+  /// Compute the total propensity over the range of bins in use
+  void update_total_propensity();
+
+  v_desc_t choose_reaction();
+  sim_time_t get_reaction_time();
+  void update_reactions(const v_desc_t vd_fired,
+                        const Sim_Method::affected_reactions_t& affected,
+                        const bool check_reaction);
+
+  void save_rgen_state(Sim_State_Change& digest);
+  void load_rgen_state(const Sim_State_Change& digest);
+
+protected:
+  /**
+   * Bins for every binary exponent that a propensity of the
+   * reaction_rate_t type can take including the subnormal range.
+   */
+  bin_list_t m_bins;
+  /// The smallest index of the bins that have been used
+  bin_idx_t m_bin_min;
+  /// The largest index of the bins that have been used
+  bin_idx_t m_bin_max;
+  /// Total propensity of reactions
+  reaction_rate_t m_total;
+
+  rng_t m_rgen_evt; ///< RNG for events
+  rng_t m_rgen_tm; ///< RNG for event times
+  /// map from vertex descriptor to the position in the bins
+  std::unordered_map<v_desc_t, bin_pos_t> m_pindices;
+
+  /// The smallest binary exponent of a positive reaction_rate_t value
+  static constexpr bin_exp_t m_exp_min
+    = std::numeric_limits<reaction_rate_t>::min_exponent
+    - std::numeric_limits<reaction_rate_t>::digits + 1;
+  /// The largest binary exponent of a finite reaction_rate_t value
+  static constexpr bin_exp_t m_exp_max
+    = std::numeric_limits<reaction_rate_t>::max_exponent;
+  /// The bin index of reactions not active (i.e., of zero propensity)
+  static constexpr bin_idx_t m_no_bin = static_cast<bin_idx_t>(-1);
+
+ #if defined(WCS_HAS_ROSS)
+  using digest_list_t = std::list<Sim_State_Change>;
+  digest_list_t m_digests;
+ #endif // defined(WCS_HAS_ROSS)
+};
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_SIM_METHODS_SSA_CR_HPP__
@@ -23,7 +23,11 @@ namespace wcs {
  *  @{ */
 
 SSA_Direct::SSA_Direct(const std::shared_ptr<wcs::Network>& net_ptr)
-: Sim_Method(net_ptr) {}
+: Sim_Method(net_ptr)
+#if defined(WCS_DIRECT_SUM_TREE)
+, m_num_leaves(0ul)
+#endif // defined(WCS_DIRECT_SUM_TREE)
+{}
 
 SSA_Direct::~SSA_Direct() {}
 
@@ -45,6 +49,134 @@ SSA_Direct::rng_t& SSA_Direct::rgen_t() {
   return m_rgen_tm;
 }
 
+#if defined(WCS_DIRECT_SUM_TREE)
+void SSA_Direct::build_sum_tree()
+{
+  constexpr auto zero_rate = static_cast<reaction_rate_t>(0.0);
+  const size_t n = m_propensity.size();
+
+  m_num_leaves = 1ul;
+  while (m_num_leaves < n) {
+    m_num_leaves <<= 1;
+  }
+  m_sum_tree.assign(2ul * m_num_leaves, zero_rate);
+
+  for (size_t i = 0ul; i < n; ++i) {
+    m_sum_tree[m_num_leaves + i] = m_propensity[i].first;
+  }
+  for (size_t k = m_num_leaves - 1ul; k > 0ul; --k) {
+    m_sum_tree[k] = m_sum_tree[2ul*k] + m_sum_tree[2ul*k + 1ul];
+  }
+}
+
+void SSA_Direct::update_sum_tree(const size_t pidx)
+{
+  size_t k = m_num_leaves + pidx;
+  m_sum_tree[k] = m_propensity[pidx].first;
+  // Recompute the partial sums from the children rather than adding the
+  // difference, such that no round-off error accumulates over updates.
+  for (k >>= 1; k > 0ul; k >>= 1) {
+    m_sum_tree[k] = m_sum_tree[2ul*k] + m_sum_tree[2ul*k + 1ul];
+  }
+}
+
+/**
+ * Initialize the reaction propensity list by filling it with the propesity of
+ * every reaction in the order of the reaction list, and build the sum tree.
+ */
+void SSA_Direct::build_propensity_list()
+{
+  m_propensity.clear();
+  m_pindices.clear();
+  const size_t num_reactions = m_net_ptr->get_num_reactions()+1;
+  m_propensity.reserve(num_reactions);
+  m_pindices.reserve(num_reactions);
+
+  size_t i = 0ul;
+  for (const auto& vd : m_net_ptr->reaction_list())
+  {
+    const auto rate = m_net_ptr->get_reaction_rate(vd);
+    m_propensity.emplace_back(priority_t(rate, vd));
+    m_pindices.insert(std::make_pair(vd, i++));
+  }
+
+  build_sum_tree();
+}
+
+/// Randomly determine which reaction to fire by descending the sum tree.
+SSA_Direct::priority_t& SSA_Direct::choose_reaction()
+{
+  constexpr auto zero_rate = static_cast<reaction_rate_t>(0.0);
+  auto rn = static_cast<reaction_rate_t>(m_rgen_evt() * m_sum_tree[1]);
+
+  size_t k = 1ul;
+  while (k < m_num_leaves) {
+    const auto left = m_sum_tree[2ul*k];
+    // Avoid descending into a subtree of zero propensity which could happen
+    // due to the round-off error when rn is close to the sum of the node.
+    if ((rn < left) || (m_sum_tree[2ul*k + 1ul] <= zero_rate)) {
+      k = 2ul*k;
+    } else {
+      rn -= left;
+      k = 2ul*k + 1ul;
+    }
+  }
+
+  const size_t pidx = k - m_num_leaves;
+  if (pidx >= m_propensity.size()) {
+    WCS_THROW("Failed to choose a reaction to fire");
+  }
+  return m_propensity[pidx];
+}
+
+/// Randomly determine the time period until the next reaction
+sim_time_t SSA_Direct::get_reaction_time()
+{
+  // total propensity
+  const reaction_rate_t r = m_propensity.empty()?
+                              static_cast<reaction_rate_t>(0) :
+                              m_sum_tree[1];
+  return ((r <= static_cast<reaction_rate_t>(0))?
+            wcs::Network::get_etime_ulimit() :
+            -static_cast<reaction_rate_t>(log(m_rgen_tm())/r));
+}
+
+/**
+ * Recompute the reaction rates of those affected which are linked with
+ * updating species. Also, update the sum tree along the path from each of
+ * the updated propensities to the root.
+ */
+void SSA_Direct::update_reactions(priority_t& fired,
+  const Sim_Method::affected_reactions_t& affected_reactions,
+  bool check_reaction)
+{
+  constexpr auto zero_rate = static_cast<reaction_rate_t>(0.0);
+
+  const auto vd_fired = fired.second;
+  if (check_reaction && !m_net_ptr->check_reaction(vd_fired)) {
+    fired.first = zero_rate;
+  } else {
+    // update the propensity of the fired reaction
+    fired.first = m_net_ptr->set_reaction_rate(vd_fired);
+  }
+  update_sum_tree(m_pindices.at(vd_fired));
+
+  // update the propensity of the rest of affected reactions
+  for (const auto& vd : affected_reactions) {
+    const size_t pidx = m_pindices.at(vd);
+    // For reverse computation, this could have been restored from memory
+    // instead of computation.
+
+    if (check_reaction && !m_net_ptr->check_reaction(vd)) {
+      (m_propensity.at(pidx)).first = zero_rate;
+    } else {
+      (m_propensity.at(pidx)).first = m_net_ptr->set_reaction_rate(vd);
+    }
+    update_sum_tree(pidx);
+  }
+}
+
+#else // defined(WCS_DIRECT_SUM_TREE)
 /**
  * Initialize the reaction propensity list by filling it with the propesity of
  * every reaction and sorting.
@@ -116,7 +248,6 @@ void SSA_Direct::update_reactions(priority_t& fired,
   const Sim_Method::affected_reactions_t& affected_reactions,
   bool check_reaction)
 {
-  using r_prop_t = wcs::Reaction<v_desc_t>;
   constexpr auto zero_rate = static_cast<reaction_rate_t>(0.0);
 
   const auto vd_fired = fired.second;
@@ -148,18 +279,14 @@ void SSA_Direct::update_reactions(priority_t& fired,
   reaction_rate_t sum = (pidx_min > 0ul)?
                         (m_propensity.at(pidx_min-1)).first : zero_rate;
 
-  const wcs::Network::graph_t& g = m_net_ptr->graph();
-
   // update the cumulative propensity
   for (size_t i = pidx_min; i < m_propensity.size(); ++ i) {
     auto& prop = m_propensity.at(i);
-    const auto vd = prop.second;
-    const auto& rv = g[vd]; // reaction vertex
-    const auto& rp = rv.property<r_prop_t>(); // detailed vertex property data
-    sum += rp.get_rate(); // cumulative reaction propensity
+    sum += m_net_ptr->get_reaction_rate(prop.second); // cumulative propensity
     prop.first = sum;
   }
 }
+#endif // defined(WCS_DIRECT_SUM_TREE)
 
 
 void SSA_Direct::init(const sim_iter_t max_iter,
@@ -216,8 +343,8 @@ void SSA_Direct::init(const sim_iter_t max_iter,
 
 void SSA_Direct::save_rgen_state(Sim_State_Change& digest)
 {
-  constexpr size_t rng_state_size = sizeof(m_rgen_evt.engine())
-                                  + sizeof(m_rgen_tm.engine());
+  const size_t rng_state_size = m_rgen_evt.engine_byte_size()
+                              + m_rgen_tm.engine_byte_size();
   digest.m_rng_state.clear();
   digest.m_rng_state.reserve(rng_state_size);
   wcs::ostreamvec<char> ostrmbuf(digest.m_rng_state);
@@ -227,7 +354,8 @@ void SSA_Direct::save_rgen_state(Sim_State_Change& digest)
   cereal::BinaryOutputArchive oarchive(os);
   oarchive(m_rgen_evt.engine(), m_rgen_tm.engine());
  #else
-  os << bits(m_rgen_evt.engine()) << bits(m_rgen_tm.engine());
+  m_rgen_evt.save_engine_bits(os);
+  m_rgen_tm.save_engine_bits(os);
  #endif // defined(WCS_HAS_CEREAL)
 }
 
@@ -241,11 +369,75 @@ void SSA_Direct::load_rgen_state(const Sim_State_Change& digest)
   cereal::BinaryInputArchive iarchive(is);
   iarchive(m_rgen_evt.engine(), m_rgen_tm.engine());
  #else
-  is >> bits(m_rgen_evt.engine()) >> bits(m_rgen_tm.engine());
+  m_rgen_evt.load_engine_bits(is);
+  m_rgen_tm.load_engine_bits(is);
  #endif // defined(WCS_HAS_CEREAL)
 }
 
 
+/**
+ * The propensity list is saved in its current order, as it is not necessarily
+ * sorted by the current propensities, which determines the reaction chosen
+ * for a given random number.
+ */
+void SSA_Direct::save_method_state(std::ostream& os) const
+{
+ #if defined(WCS_DIRECT_SUM_TREE)
+  save_state_tag(os, "SSA_Direct/sum_tree");
+ #else
+  save_state_tag(os, "SSA_Direct");
+ #endif // defined(WCS_DIRECT_SUM_TREE)
+
+  std::vector<reaction_rate_t> rates;
+  std::vector<v_idx_t> ridx;
+  rates.reserve(m_propensity.size());
+  ridx.reserve(m_propensity.size());
+  for (const auto& p : m_propensity) {
+    rates.push_back(p.first);
+    ridx.push_back(m_net_ptr->reaction_d2i(p.second));
+  }
+  os << bits(rates) << bits(ridx);
+
+  m_rgen_evt.save_bits(os);
+  m_rgen_tm.save_bits(os);
+}
+
+
+void SSA_Direct::load_method_state(std::istream& is)
+{
+ #if defined(WCS_DIRECT_SUM_TREE)
+  check_state_tag(is, "SSA_Direct/sum_tree");
+ #else
+  check_state_tag(is, "SSA_Direct");
+ #endif // defined(WCS_DIRECT_SUM_TREE)
+
+  std::vector<reaction_rate_t> rates;
+  std::vector<v_idx_t> ridx;
+  is >> bits(rates) >> bits(ridx);
+  if (!is || (rates.size() != ridx.size()) ||
+      (ridx.size() != m_net_ptr->get_num_reactions())) {
+    WCS_THROW("Invalid propensity list in the checkpoint.");
+  }
+
+  m_propensity.clear();
+  m_pindices.clear();
+  m_pindices.reserve(ridx.size());
+  for (size_t i = 0ul; i < ridx.size(); ++i) {
+    const auto vd = m_net_ptr->reaction_i2d(ridx[i]);
+    m_propensity.emplace_back(priority_t(rates[i], vd));
+    m_pindices.insert(std::make_pair(vd, i));
+  }
+ #if defined(WCS_DIRECT_SUM_TREE)
+  // Every node is the sum of its children at all times. Thus, rebuilding from
+  // the leaves reproduces the tree exactly.
+  build_sum_tree();
+ #endif // defined(WCS_DIRECT_SUM_TREE)
+
+  m_rgen_evt.load_bits(is);
+  m_rgen_tm.load_bits(is);
+}
+
+
 Sim_Method::result_t SSA_Direct::schedule(sim_time_t& next_time)
 {
   if (BOOST_UNLIKELY(m_propensity.empty())) { // no reaction possible
@@ -363,6 +555,7 @@ std::pair<sim_iter_t, sim_time_t> SSA_Direct::run()
   }
 
   while (BOOST_LIKELY(forward(t))) {
+    checkpoint_if_due();
     if (BOOST_UNLIKELY(schedule(t) != Success)) {
       break;
     }
@@ -36,6 +36,13 @@ namespace wcs {
  *  This reverses the order to minimize the potential numerical error caused
  *  by adding a small propensity to a large cumulative propensity when
  *  searching a value from the largest propensity to the smallest propensity.
+ *
+ *  When built with WCS_DIRECT_SUM_TREE, the propensity list instead keeps the
+ *  individual propensities in the order of the reaction list, and a complete
+ *  binary tree of partial sums is maintained on top of it. Selecting a
+ *  reaction descends the tree and updating a propensity touches the nodes on
+ *  the path from the leaf to the root, which makes both O(log n) instead of
+ *  rewriting the cumulative propensities past the lowest index updated.
  */
 class SSA_Direct : public Sim_Method {
 public:
@@ -86,6 +93,12 @@ public:
 
 protected:
   void build_propensity_list();
+ #if defined(WCS_DIRECT_SUM_TREE)
+  /// Build the sum tree on top of the propensity list
+  void build_sum_tree();
+  /// Reflect the propensity at the given index of the list to the sum tree
+  void update_sum_tree(const size_t pidx);
+ #endif // defined(WCS_DIRECT_SUM_TREE)
   priority_t& choose_reaction();
   sim_time_t get_reaction_time();
   void update_reactions(priority_t& fired,
@@ -95,9 +108,27 @@ protected:
   void save_rgen_state(Sim_State_Change& digest);
   void load_rgen_state(const Sim_State_Change& digest);
 
+  /// Save the propensities and the state of the generators
+  void save_method_state(std::ostream& os) const override;
+  void load_method_state(std::istream& is) override;
+
 protected:
+ #if defined(WCS_DIRECT_SUM_TREE)
+  /// Propensity of reactions events
+  propensisty_list_t m_propensity;
+  /**
+   * Complete binary tree of partial sums of propensities stored in an array.
+   * The root is at index 1, and the children of node `k` are at `2k` and
+   * `2k+1`. The leaves start from the index m_num_leaves, and the i-th leaf
+   * corresponds to the i-th entry of the propensity list.
+   */
+  std::vector<reaction_rate_t> m_sum_tree;
+  /// The number of leaves of the sum tree, which is a power of two
+  size_t m_num_leaves;
+ #else
   /// Cumulative propensity of reactions events
   propensisty_list_t m_propensity;
+ #endif // defined(WCS_DIRECT_SUM_TREE)
   rng_t m_rgen_evt; ///< RNG for events
   rng_t m_rgen_tm; ///< RNG for event times
   /// map from vertex descriptor to propensity
@@ -12,55 +12,39 @@
 #include <string>
 #include "sim_methods/ssa_nrm.hpp"
 #include "utils/exception.hpp"
-#include "iheap.h"
 
 #if defined(WCS_HAS_CEREAL)
 #include "utils/state_io_cereal.hpp"
 #endif // WCS_HAS_CEREAL
 
-/**
- * Due to performance, using lambdas instead of std::function or member function.
- * For each key, the indexer returns a mutable reference to the corresponding
- * entry in the in-heap index table.
- * less_reaction compares if the reaction of the first argument is likely to be
- * less frequent than that of the second one.
- * less_priority compares if the priority of the first argument is less than
- * that of the second one/
- */
-#define lambdas_for_indexed_heap \
-  auto indexer = [this](const v_desc_t& key) -> heap_idx_t& { \
-    auto it = this->m_idx_table.find(key); \
-    if (it == this->m_idx_table.end()) { \
-      WCS_THROW("The key (reaction vertex descriptor) does not exist."); \
-    } \
-    return it->second; \
-  }; \
-  \
-  auto less_reaction = [this] \
-    (const v_desc_t& r1, const v_desc_t& r2) -> bool \
-  { \
-    const auto rate1 = this->m_net_ptr->get_reaction_rate(r1); \
-    const auto rate2 = this->m_net_ptr->get_reaction_rate(r2); \
-    return (rate1 < rate2) || ((rate1 == rate2) && (r1 > r2)); \
-  }; \
-  \
-  auto less_priority = [&less_reaction] \
-       (const priority_t& p1, const priority_t& p2) -> bool \
-  { \
-    return (p1.first > p2.first) || \
-           ((p1.first == p2.first) && less_reaction(p1.second, p2.second)); \
-  };
-  // The previous comparator had (p1.first >= p2.first) only.
-  // When comparing the result against the past commits, This needs to be
-  // consistent
-
-
 namespace wcs {
 /** \addtogroup wcs_reaction_network
  *  @{ */
 
+bool SSA_NRM::earlier_event::operator()(
+  const std::pair<sim_time_t, v_idx_t>& e1,
+  const std::pair<sim_time_t, v_idx_t>& e2) const
+{
+  if (e1.first != e2.first) {
+    return (e1.first < e2.first);
+  }
+  // The previous comparator had (p1.first >= p2.first) only.
+  // When comparing the result against the past commits, This needs to be
+  // consistent
+  const auto rate1 = m_net_ptr->reaction_rate(e1.second);
+  const auto rate2 = m_net_ptr->reaction_rate(e2.second);
+  return (rate1 > rate2) ||
+         ((rate1 == rate2) && (m_net_ptr->reaction_i2d(e1.second) <
+                               m_net_ptr->reaction_i2d(e2.second)));
+}
+
 SSA_NRM::SSA_NRM(const std::shared_ptr<wcs::Network>& net_ptr)
-: Sim_Method(net_ptr) {}
+: Sim_Method(net_ptr),
+  m_heap(earlier_event(net_ptr.get()))
+ #if defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
+  , m_local_reactions(nullptr)
+ #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
+{}
 
 SSA_NRM::~SSA_NRM() {}
 
@@ -78,39 +62,45 @@ SSA_NRM::rng_t& SSA_NRM::rgen() {
  */
 void SSA_NRM::build_heap()
 {
-  lambdas_for_indexed_heap
-
   // For each reaction, check if the reaction condition is met:
   // i.e., a sufficient number of reactants
 
-  m_idx_table.clear();
-  m_heap.clear();
-  m_heap.reserve(m_net_ptr->get_num_reactions()+10);
+  m_heap.set_compare(earlier_event(m_net_ptr.get()));
+  m_heap.reset(m_net_ptr->get_num_reactions());
   constexpr sim_time_t unsigned_max
     = static_cast<sim_time_t>(std::numeric_limits<unsigned>::max());
 
   const bool is_partitioned
     = (m_net_ptr->get_partition_id() != unassigned_partition);
 
+ #if defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
+  const Network::reaction_list_t& reaction_list
+    = (m_local_reactions? *m_local_reactions :
+       is_partitioned? m_net_ptr->my_reaction_list()
+                     : m_net_ptr->reaction_list());
+ #else
   const Network::reaction_list_t& reaction_list
     = (is_partitioned? m_net_ptr->my_reaction_list()
                      : m_net_ptr->reaction_list());
+ #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
 
   for (size_t i = 0u; i < reaction_list.size(); ++i) {
     const auto& vd = reaction_list[i];
 
+    const auto ridx = m_net_ptr->reaction_d2i(vd);
+
     if (!m_net_ptr->check_reaction(vd)) {
-      m_heap.emplace_back(priority_t(wcs::Network::get_etime_ulimit(), vd));
+      m_heap.push_back(wcs::Network::get_etime_ulimit(), ridx);
     } else {
       const auto rate = m_net_ptr->get_reaction_rate(vd); // reaction rate
       const auto rn = unsigned_max/m_rgen.pull(); // inverse of a uniform RN U(0,1)
       const auto t = log(rn)/rate;
-      m_heap.emplace_back(priority_t(t, vd));
+      m_heap.push_back(t, ridx);
     }
-    m_idx_table[vd] = static_cast<heap_idx_t>(i); // position in the heap
   }
 
-  iheap::make(m_heap.begin(), m_heap.end(), indexer, less_priority);
+  m_heap.make();
+  m_updates.reserve(m_net_ptr->get_num_reactions());
 
   if (m_heap.empty()) {
     std::string errmsg;
@@ -139,13 +129,10 @@ SSA_NRM::priority_t SSA_NRM::choose_reaction() const
     return std::make_pair(wcs::Network::get_etime_ulimit(), v_desc_t{});
   }
  #endif
-  // lambdas_for_indexed_heap
-  // iheap::pop(m_heap.begin(), m_heap.end(), indexer, less_priority);
-  // auto p = m_heap.back();
-  // m_heap.pop_back();
   // Instead of removing it and reinserting after the update,
   // leave it in the heap so as to update in place.
-  return m_heap.front();
+  const auto& top = m_heap.top();
+  return priority_t(top.first, m_net_ptr->reaction_i2d(top.second));
 }
 
 bool SSA_NRM::is_empty() const
@@ -155,7 +142,7 @@ bool SSA_NRM::is_empty() const
 
 sim_time_t SSA_NRM::get_reaction_time()
 {
-  return m_heap.front().first;
+  return m_heap.top().first;
 }
 
 wcs::sim_time_t SSA_NRM::recompute_reaction_time(const v_desc_t& vd)
@@ -190,7 +177,6 @@ wcs::sim_time_t SSA_NRM::recompute_reaction_time(const v_desc_t& vd)
 wcs::sim_time_t SSA_NRM::adjust_reaction_time(const v_desc_t& vd,
                                               wcs::sim_time_t rt)
 {
-  using r_prop_t = wcs::Reaction<v_desc_t>;
   constexpr sim_time_t unsigned_max
     = static_cast<sim_time_t>(std::numeric_limits<unsigned>::max());
 
@@ -198,9 +184,7 @@ wcs::sim_time_t SSA_NRM::adjust_reaction_time(const v_desc_t& vd,
     return wcs::Network::get_etime_ulimit();
   }
 
-  const auto& rv_affected = m_net_ptr->graph()[vd];
-  auto& rp_affected = rv_affected.property<r_prop_t>();
-  const auto rate_old = rp_affected.get_rate();
+  const auto rate_old = m_net_ptr->get_reaction_rate(vd);
   const auto rate_new = m_net_ptr->set_reaction_rate(vd);
 
   if (rate_new <= static_cast<reaction_rate_t>(0)) {
@@ -220,7 +204,7 @@ wcs::sim_time_t SSA_NRM::adjust_reaction_time(const v_desc_t& vd,
   return rt;
 }
 
-#if defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
+#if (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
 /**
  * This works similarly as the other version of update_reactions().
  * The only difference is that this is for updating local reactions
@@ -236,39 +220,38 @@ void SSA_NRM::update_reactions(const sim_time_t t_fired,
   //const auto pid = m_net_ptr->get_partition_id();
  #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
 
-  lambdas_for_indexed_heap
+  // The list of affected reactions is a random-accessible flat array
+  const auto num_affected = static_cast<size_t>(affected.size());
+  m_updates.resize(num_affected);
+ #if defined(WCS_HAS_ROSS)
+  affected_rtimes.resize(num_affected);
+ #endif // defined(WCS_HAS_ROSS)
 
+  // Compute the new reaction times first, and then apply those to the heap
+  // all at once, which avoids serializing each heap update.
  #if defined(_OPENMP) && defined(WCS_OMP_REACTION_UPDATES)
-  const std::vector<v_desc_t> r_affected(affected.begin(), affected.end());
   #pragma omp parallel for
-  for (size_t i = 0ul; i < r_affected.size(); i++)
+ #endif // defined(_OPENMP) && defined(WCS_OMP_REACTION_UPDATES)
+  for (size_t i = 0ul; i < num_affected; i++)
   {
-    const v_desc_t& r = r_affected[i];
+    const v_desc_t& r = affected[i];
     // This check is redundant as it is already done by fire_reaction
     // if (m_net_ptr->graph()[r].get_partition() != pid) continue;
-
-    const auto t = m_heap[indexer(r)].first; // reaction time
+    const auto ridx = m_net_ptr->reaction_d2i(r);
+    const auto t = m_heap.priority(ridx); // reaction time
 
     const auto dt = adjust_reaction_time(r, t - t_fired);
-    #pragma omp critical
-    {
-      iheap::update(m_heap.begin(), m_heap.end(), indexer,
-                    r, t_fired + dt, less_priority);
-    }
-  }
- #else // defined(_OPENMP)
-  for (const auto& r: affected) {
-    // This check is redundant as it is already done by fire_reaction
-    // if (m_net_ptr->graph()[r].get_partition() != pid) continue;
-    const auto t = m_heap[indexer(r)].first; // reaction time
+    m_updates[i] = std::make_pair(ridx, t_fired + dt);
 
-    const auto dt = adjust_reaction_time(r, t - t_fired);
-    iheap::update(m_heap.begin(), m_heap.end(), indexer,
-                  r, t_fired + dt, less_priority);
+   #if defined(WCS_HAS_ROSS)
+    // Record the reaction time before update
+    affected_rtimes[i] = std::make_pair(r, t);
+   #endif // defined(WCS_HAS_ROSS)
   }
- #endif // defined(_OPENMP)
+
+  apply_heap_updates();
 }
-#endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
+#endif // (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
 
 /**
  * Recompute the reaction rates of those affected which are linked with
@@ -289,65 +272,58 @@ void SSA_NRM::update_reactions(
   // Note that this not inside of the inner loop
   const auto dt_fired = recompute_reaction_time(r_fired);
 
-  lambdas_for_indexed_heap
-
-  iheap::update(m_heap.begin(), m_heap.end(), indexer,
-                r_fired, t_fired + dt_fired, less_priority);
+  m_heap.update(m_net_ptr->reaction_d2i(r_fired), t_fired + dt_fired);
 
  #if defined(WCS_HAS_ROSS)
   affected_rtimes.emplace_back(std::make_pair(r_fired, t_fired));
  #endif // defined(WCS_HAS_ROSS)
 
+  // The list of affected reactions is a random-accessible flat array
+  const auto num_affected = static_cast<size_t>(affected.size());
+  m_updates.resize(num_affected);
+ #if defined(WCS_HAS_ROSS)
+  affected_rtimes.resize(num_affected + 1u);
+ #endif // defined(WCS_HAS_ROSS)
+
+  // Compute the new reaction times first, and then apply those to the heap
+  // all at once, which avoids serializing each heap update.
  #if defined(_OPENMP) && defined(WCS_OMP_REACTION_UPDATES)
-  const std::vector<v_desc_t> r_affected(affected.begin(), affected.end());
   #pragma omp parallel for
-  for (size_t i = 0ul; i < r_affected.size(); i++)
+ #endif // defined(_OPENMP) && defined(WCS_OMP_REACTION_UPDATES)
+  for (size_t i = 0ul; i < num_affected; i++)
   {
-    const v_desc_t& r = r_affected[i];
-    const auto t = m_heap[indexer(r)].first; // reaction time
+    const v_desc_t& r = affected[i];
+    const auto ridx = m_net_ptr->reaction_d2i(r);
+    const auto t = m_heap.priority(ridx); // reaction time
 
     const auto dt = adjust_reaction_time(r, t - t_fired);
-    #pragma omp critical
-    {
-      iheap::update(m_heap.begin(), m_heap.end(), indexer,
-                    r, t_fired + dt, less_priority);
-    }
+    m_updates[i] = std::make_pair(ridx, t_fired + dt);
 
+   #if defined(WCS_HAS_ROSS)
     // Record the reaction time before update
-    #if defined(WCS_HAS_ROSS)
-    #pragma omp critical
-    {
-      affected_rtimes.push_back(std::make_pair(r, t));
-    }
-    #endif // defined(WCS_HAS_ROSS)
+    affected_rtimes[i + 1u] = std::make_pair(r, t);
+   #endif // defined(WCS_HAS_ROSS)
   }
- #else // defined(_OPENMP)
-  for (const auto& r: affected) {
-    const auto t = m_heap[indexer(r)].first; // reaction time
 
-    const auto dt = adjust_reaction_time(r, t - t_fired);
-    iheap::update(m_heap.begin(), m_heap.end(), indexer,
-                  r, t_fired + dt, less_priority);
+  apply_heap_updates();
+}
 
-   #if defined(WCS_HAS_ROSS)
-    // Record the reaction time before update
-    affected_rtimes.push_back(std::make_pair(r, t));
-   #endif // defined(WCS_HAS_ROSS)
+void SSA_NRM::apply_heap_updates()
+{
+  for (const auto& u : m_updates) {
+    m_heap.update(u.first, u.second);
   }
- #endif // defined(_OPENMP)
 }
 
 void SSA_NRM::revert_reaction_updates(
-       const SSA_NRM::reaction_times_t& affected)
+       const Digest_Pool::rtime_t* affected, const size_t num_affected)
 {
-  lambdas_for_indexed_heap
-
-  for (auto& r: affected) {
+  for (size_t i = 0ul; i < num_affected; ++i) {
+    const auto& r = affected[i];
     // Instead of recomputing the reaction rate, it could have been resotred
     // from the state saved if it was saved.
     m_net_ptr->set_reaction_rate(r.first);
-    iheap::update(m_heap.begin(), m_heap.end(), indexer,
-                  r.first, r.second, less_priority);
+    m_heap.update(m_net_ptr->reaction_d2i(r.first), r.second);
   }
 }
 
@@ -391,8 +367,8 @@ void SSA_NRM::init(const sim_iter_t max_iter,
 
   build_heap(); // prepare internal priority queue
  #if defined(WCS_HAS_ROSS)
-  m_digests.emplace_back();
-  m_digests.back().m_sim_time = m_sim_time;
+  m_digests.reset(0ul);
+  m_digests.push(m_sim_time);
  #endif // defined(WCS_HAS_ROSS)
 }
 
@@ -413,9 +389,9 @@ void SSA_NRM::save_rgen_state(Sim_State_Change& digest) const
 }
 
 
-void SSA_NRM::load_rgen_state(const Sim_State_Change& digest)
+void SSA_NRM::load_rgen_state(const char* state, const size_t size)
 {
-  wcs::istreamvec<char> istrmbuf(digest.m_rng_state);
+  wcs::istreambuff<char> istrmbuf(state, size);
   std::istream is(&istrmbuf);
 
  #if defined(WCS_HAS_CEREAL)
@@ -456,6 +432,11 @@ bool SSA_NRM::advance_time_and_iter(const sim_time_t t_new)
   m_sim_time = t_new;
   return true;
 }
+
+void SSA_NRM::set_local_reactions(const Network::reaction_list_t* reactions)
+{
+  m_local_reactions = reactions;
+}
 #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
 
 bool SSA_NRM::forward(const revent_t firing)
@@ -469,12 +450,19 @@ bool SSA_NRM::forward(const revent_t firing)
   m_sim_time = t;
 
  #if defined(WCS_HAS_ROSS)
-  m_digests.emplace_back(firing);
-  auto& digest = m_digests.back();
-
-  // Backup RNG state
-  save_rgen_state(digest);
+  auto& digest = m_digest;
   // Time of this reaction
+  digest.m_sim_time = firing.first;
+  digest.m_reaction_fired = firing.second;
+
+  // Backup RNG state. A reversible generator only needs the number of values
+  // drawn by this event, which is counted below.
+  [[maybe_unused]] rng_t::draw_count_t draws_before = 0u;
+  if constexpr (rng_t::is_reversible) {
+    draws_before = m_rgen.num_draws();
+  } else {
+    save_rgen_state(digest);
+  }
  #else
   Sim_State_Change digest(firing);
  #endif // defined(WCS_HAS_ROSS)
@@ -486,7 +474,13 @@ bool SSA_NRM::forward(const revent_t firing)
   // update the propensities and times of those reactions fired and affected
   update_reactions(firing, digest.m_reactions_affected, digest.m_reaction_times);
 
- #if !defined(WCS_HAS_ROSS)
+ #if defined(WCS_HAS_ROSS)
+  if constexpr (rng_t::is_reversible) {
+    digest.m_rng_draws
+      = static_cast<size_t>(m_rgen.num_draws() - draws_before);
+  }
+  m_digests.push(digest);
+ #else
   // With ROSS, tracing and sampling are moved to process at commit time
   record(firing.second);
  #endif // defined(WCS_HAS_ROSS)
@@ -499,19 +493,23 @@ bool SSA_NRM::forward(const revent_t firing)
 void SSA_NRM::backward(revent_t& firing)
 {
   // State of the last event to undo
-  Sim_State_Change& digest = m_digests.back();
+  const Digest_Pool::record_t& digest = m_digests.back();
   // The BGL vertex descriptor of the the reaction to undo
   const auto& rd_fired = digest.m_reaction_fired;
 
   // Undo the species update done by the reaction fired
   undo_reaction(rd_fired);
   // Undo the propensity updates done for the reactions affected
-  revert_reaction_updates(digest.m_reaction_times);
+  revert_reaction_updates(m_digests.reaction_times(digest), digest.m_num_times);
 
   // Restore the schedule
   firing = std::make_pair(digest.m_sim_time, digest.m_reaction_fired);
   // Restore the RNG state
-  load_rgen_state(digest);
+  if constexpr (rng_t::is_reversible) {
+    m_rgen.rewind(digest.m_rng_draws);
+  } else {
+    load_rgen_state(m_digests.rng_state(digest), digest.m_rng_size);
+  }
   // Free the state of the last event
   m_digests.pop_back();
 
@@ -529,16 +527,84 @@ void SSA_NRM::backward(revent_t& firing)
 }
 
 
+void SSA_NRM::forward_update(const sim_time_t t, const v_idx_t sidx,
+                             const stoic_t delta,
+                             const Sim_Method::affected_reactions_t& affected)
+{
+  m_sim_time = t;
+
+  auto& digest = m_digest;
+  digest.m_sim_time = t;
+  digest.m_reaction_fired = v_desc_t{};
+
+  [[maybe_unused]] rng_t::draw_count_t draws_before = 0u;
+  if constexpr (rng_t::is_reversible) {
+    draws_before = m_rgen.num_draws();
+  } else {
+    save_rgen_state(digest);
+  }
+
+  const bool ok = (delta >= 0)?
+    m_net_ptr->inc_species_count(sidx, static_cast<species_cnt_t>(delta)) :
+    m_net_ptr->dec_species_count(sidx, static_cast<species_cnt_t>(-delta));
+  if (BOOST_UNLIKELY(!ok)) {
+    WCS_THROW("Invalid update of species " + std::to_string(sidx) + " by " +
+              std::to_string(delta));
+  }
+  // This recomputes the rates of the reactions affected
+  update_reactions(t, affected, digest.m_reaction_times);
+
+  if constexpr (rng_t::is_reversible) {
+    digest.m_rng_draws
+      = static_cast<size_t>(m_rgen.num_draws() - draws_before);
+  }
+  m_digests.push(digest, false);
+}
+
+
+void SSA_NRM::backward_update(const v_idx_t sidx, const stoic_t delta)
+{
+  const Digest_Pool::record_t& digest = m_digests.back();
+
+  // Undo the species update before recomputing the rates of the reactions
+  if (delta >= 0) {
+    m_net_ptr->dec_species_count(sidx, static_cast<species_cnt_t>(delta));
+  } else {
+    m_net_ptr->inc_species_count(sidx, static_cast<species_cnt_t>(-delta));
+  }
+  revert_reaction_updates(m_digests.reaction_times(digest), digest.m_num_times);
+
+  if constexpr (rng_t::is_reversible) {
+    m_rgen.rewind(digest.m_rng_draws);
+  } else {
+    load_rgen_state(m_digests.rng_state(digest), digest.m_rng_size);
+  }
+  m_digests.pop_back();
+
+  #ifndef NDEBUG
+  if (BOOST_UNLIKELY(m_digests.empty())) {
+    WCS_THROW("No event to rollback!");
+  } else
+  #endif
+  {
+    m_sim_time = m_digests.back().m_sim_time;
+  }
+}
+
+
 void SSA_NRM::commit_des()
 {
-  if (m_recording) {
-   #ifndef NDEBUG
-    if (m_digests.size() < 2ul) {
-      WCS_THROW("No digest to commit!");
-      return;
-    }
-   #endif
-    m_digests.pop_front();
+ #ifndef NDEBUG
+  if (m_digests.size() < 2ul) {
+    WCS_THROW("No digest to commit!");
+    return;
+  }
+ #endif
+  // The digest of the event committed becomes the front, which keeps the
+  // time to restore when every event after it is rolled back. The digest
+  // that was at the front is reclaimed without freeing any memory.
+  m_digests.pop_front();
+  if ((m_recording || m_profiling) && m_digests.front().m_fired) {
     const auto& digest = m_digests.front();
     record(digest.m_sim_time, digest.m_reaction_fired);
   }
@@ -549,19 +615,45 @@ void SSA_NRM::record_first_n(const sim_iter_t num)
 {
   if (m_digests.size() < 1ul) return;
   sim_iter_t i = static_cast<sim_iter_t>(0u);
+  size_t j = 1ul;
 
-  digest_list_t::iterator it = m_digests.begin();
-
-  for (++it; it != m_digests.end(); ++it) {
+  for (; j < m_digests.size(); ++j) {
     if (i >= num) break;
-    record(it->m_sim_time, it->m_reaction_fired);
+    const auto& digest = m_digests[j];
+    // Species updates from other partitions do not count as iterations
+    if (!digest.m_fired) continue;
+    record(digest.m_sim_time, digest.m_reaction_fired);
     i ++;
   }
-  m_digests.erase(m_digests.begin(), --it);
+  // Keep the digest of the last event processed at the front
+  m_digests.pop_front(j - 1ul);
 }
 #endif // defined(WCS_HAS_ROSS)
 
 
+/**
+ * The heap is saved in the order of its nodes such that the reactions of
+ * equal times come out in the same order after restoring.
+ */
+void SSA_NRM::save_method_state(std::ostream& os) const
+{
+  save_state_tag(os, "SSA_NRM/" + std::to_string(priority_queue_t::arity));
+  m_heap.save_bits(os);
+  m_rgen.save_bits(os);
+}
+
+void SSA_NRM::load_method_state(std::istream& is)
+{
+  check_state_tag(is, "SSA_NRM/" + std::to_string(priority_queue_t::arity));
+  // The heap built by init() holds as many reactions as the one saved
+  const size_t num_events = m_heap.size();
+  m_heap.load_bits(is);
+  if (!is || (m_heap.size() != num_events)) {
+    WCS_THROW("Invalid reaction heap in the checkpoint.");
+  }
+  m_rgen.load_bits(is);
+}
+
 std::pair<sim_iter_t, sim_time_t> SSA_NRM::run()
 {
   revent_t next_reaction;
@@ -571,6 +663,7 @@ std::pair<sim_iter_t, sim_time_t> SSA_NRM::run()
   }
 
   while (BOOST_LIKELY(forward(next_reaction))) {
+    checkpoint_if_due();
     if (BOOST_UNLIKELY(schedule(next_reaction) != Success)) {
       break;
     }
@@ -19,8 +19,14 @@
 
 #include <cmath>
 #include <limits>
-#include <unordered_map>
+#include <vector>
 #include "sim_methods/sim_method.hpp"
+#include "sim_methods/indexed_heap.hpp"
+#include "sim_methods/digest_pool.hpp"
+
+#if !defined(WCS_NRM_HEAP_ARITY)
+#define WCS_NRM_HEAP_ARITY 4
+#endif
 
 namespace wcs {
 /** \addtogroup wcs_sim_methods
@@ -31,8 +37,23 @@ public:
   using rng_t = wcs::RNGen<std::uniform_int_distribution, unsigned>;
   using v_desc_t = Sim_Method::v_desc_t;
   using priority_t = std::pair<wcs::sim_time_t, v_desc_t>;
-  /// Type of heap structure
-  using priority_queue_t = std::vector<priority_t>;
+
+  /**
+   * Compare two reaction events in the heap keyed by the reaction index.
+   * An event comes earlier if its time is earlier. Ties are broken in favor
+   * of the reaction of the higher rate and then of the smaller vertex
+   * descriptor.
+   */
+  struct earlier_event {
+    earlier_event(const wcs::Network* net_ptr = nullptr) : m_net_ptr(net_ptr) {}
+    bool operator()(const std::pair<sim_time_t, v_idx_t>& e1,
+                    const std::pair<sim_time_t, v_idx_t>& e2) const;
+    const wcs::Network* m_net_ptr;
+  };
+
+  /// Type of heap structure keyed by the dense reaction index
+  using priority_queue_t
+    = Indexed_Heap<sim_time_t, earlier_event, WCS_NRM_HEAP_ARITY>;
   /// Type of the pair of BGL vertex descriptor for reaction and the its time
   using reaction_times_t = Sim_State_Change::reaction_times_t;
 
@@ -65,6 +86,18 @@ public:
  #if defined(WCS_HAS_ROSS)
   void backward(revent_t& evt);
   void commit_des();
+
+  /**
+   * Apply the change in the count of a species made at time t by a reaction
+   * fired in another partition, and update the local reactions affected,
+   * which are given by the caller. Unlike forward(), this does not count as
+   * an iteration, and is not recorded in the trajectory.
+   */
+  void forward_update(const sim_time_t t, const v_idx_t sidx,
+                      const stoic_t delta,
+                      const Sim_Method::affected_reactions_t& affected);
+  /// Undo the latest species update by forward_update()
+  void backward_update(const v_idx_t sidx, const stoic_t delta);
    
   /** Record as many states as the given number of iterations from the
    *  beginning of the digest list */
@@ -82,10 +115,19 @@ public:
  #if defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
   /// Used in parallel mode with partitioned network
   bool advance_time_and_iter(const sim_time_t t_new);
+  /**
+   * Schedule only the given reactions, which belong to the partition of this
+   * object when a single network is shared among the partitions. Otherwise,
+   * the reactions local to the partition of the network are scheduled. This
+   * must be called before init(), and the list must outlive this object.
+   */
+  void set_local_reactions(const Network::reaction_list_t* reactions);
+ #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
+ #if (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
   void update_reactions(const sim_time_t t_fired,
                         const Sim_Method::affected_reactions_t& affected,
                         reaction_times_t& affected_rtimes);
- #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
+ #endif // (defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)) || defined(WCS_HAS_ROSS)
 
   void update_reactions(const priority_t& fired,
                         const Sim_Method::affected_reactions_t& affected,
@@ -96,24 +138,46 @@ protected:
   sim_time_t get_reaction_time();
   wcs::sim_time_t recompute_reaction_time(const v_desc_t& vd);
   wcs::sim_time_t adjust_reaction_time(const v_desc_t& vd, wcs::sim_time_t rt);
-  void revert_reaction_updates(const reaction_times_t& affected);
+  void revert_reaction_updates(const Digest_Pool::rtime_t* affected,
+                               const size_t num_affected);
 
   void save_rgen_state(Sim_State_Change& digest) const;
-  void load_rgen_state(const Sim_State_Change& digest);
+  void load_rgen_state(const char* state, const size_t size);
+
+  /// Save the heap of the reaction times and the state of the generator
+  void save_method_state(std::ostream& os) const override;
+  void load_method_state(std::istream& is) override;
 
 protected:
-  /** In-heap index table maintains where in the heap each item can be found.
-      The position in the heap is identified by an index of type idx_t. */
-  using heap_idx_t = int; // the type used in iheap
-  using in_heap_index_table_t = std::unordered_map<v_desc_t, heap_idx_t>;
+  /// Apply the batch of the new reaction times in m_updates to the heap
+  void apply_heap_updates();
 
-  in_heap_index_table_t m_idx_table;
+protected:
+  /**
+   * Heap of the reaction times. The position of each reaction in the heap is
+   * tracked by the reaction index within the heap.
+   */
   priority_queue_t m_heap;
+  /**
+   * Buffer of the new times of the reactions affected by the last event,
+   * which are computed first and then applied to the heap all at once.
+   */
+  std::vector<std::pair<v_idx_t, sim_time_t>> m_updates;
   rng_t m_rgen;
 
+ #if defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
+  /// Reactions to schedule out of the shared network, if not null
+  const Network::reaction_list_t* m_local_reactions;
+ #endif // defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
+
  #if defined(WCS_HAS_ROSS)
-  using digest_list_t = std::list<Sim_State_Change>;
-  digest_list_t m_digests;
+  /// Digests of the events not committed yet
+  Digest_Pool m_digests;
+  /**
+   * Digest of the current event, which is reused across events to avoid
+   * reallocating its buffers, and is copied into the pool at the end.
+   */
+  Sim_State_Change m_digest;
  #endif // defined(WCS_HAS_ROSS)
 };
 
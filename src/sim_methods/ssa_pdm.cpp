@@ -0,0 +1,487 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <algorithm> // max, find_if
+#include <array>
+#include <cmath> // log, abs
+#include "sim_methods/ssa_pdm.hpp"
+#include "utils/exception.hpp"
+#include "utils/seed.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_reaction_network
+ *  @{ */
+
+namespace {
+
+/// Whether the rate evaluated matches the one expected up to round-off
+inline bool matches(const reaction_rate_t evaluated,
+                    const reaction_rate_t expected)
+{
+  constexpr auto rel_tol = static_cast<reaction_rate_t>(1e-9);
+  const auto mag = std::max(std::abs(evaluated), std::abs(expected));
+  return (std::abs(evaluated - expected) <= rel_tol * mag);
+}
+
+} // end of anonymous namespace
+
+constexpr v_idx_t SSA_PDM::no_species;
+
+SSA_PDM::SSA_PDM(const std::shared_ptr<wcs::Network>& net_ptr)
+: Sim_Method(net_ptr),
+  m_num_groups(static_cast<v_idx_t>(0u)),
+  m_a0(static_cast<reaction_rate_t>(0.0)),
+  m_resum_period(static_cast<sim_iter_t>(1u)),
+  m_iter_since_resum(static_cast<sim_iter_t>(0u)),
+  m_resum_threshold(static_cast<reaction_rate_t>(0.0))
+{}
+
+SSA_PDM::~SSA_PDM() {}
+
+/// Allow access to the internal random number generator for events
+SSA_PDM::rng_t& SSA_PDM::rgen_e() {
+  return m_rgen_evt;
+}
+
+/// Allow access to the internal random number generator for event times
+SSA_PDM::rng_t& SSA_PDM::rgen_t() {
+  return m_rgen_tm;
+}
+
+/**
+ * A reaction is elementary if it takes at most two reactant molecules, and its
+ * rate formula depends on exactly the reactant species, evaluating to
+ * - `c` for a zeroth order reaction,
+ * - `c*[A]` for a first order reaction A -> ...,
+ * - `c*[A]*[B]` for a second order reaction A + B -> ..., and
+ * - `[A]*(a*[A] + b)` for a second order reaction A + A -> ..., which includes
+ *   the combinatorial form `c*[A]*([A]-1)/2` as well as `c*[A]*[A]`.
+ * The formula is evaluated at a number of probing points to find the
+ * coefficients and to check if it follows one of the forms above.
+ */
+SSA_PDM::factor_t SSA_PDM::factorize(const v_desc_t rd) const
+{
+  const wcs::Network::graph_t& g = m_net_ptr->graph();
+  auto& rprop = g[rd].property<wcs::Network::r_prop_t>();
+  const auto& inputs = rprop.get_rate_inputs();
+  const std::string err = "PDM requires every reaction to be elementary, "
+                          "but the reaction " + g[rd].get_label();
+
+  // The reactant species and the total number of reactant molecules
+  std::vector<wcs::Network::species_update_t> reactants;
+  stoic_t order = static_cast<stoic_t>(0);
+  for (const auto& u : m_net_ptr->get_reactant_updates(rd)) {
+    if (u.second > static_cast<stoic_t>(0)) {
+      reactants.emplace_back(u);
+      order += u.second;
+    }
+  }
+  if (order > static_cast<stoic_t>(2)) {
+    WCS_THROW(err + " takes " + std::to_string(order) + " reactant molecules.");
+  }
+
+  // Map each rate input to the reactant of which the count it takes
+  std::vector<size_t> input_map(inputs.size());
+  for (size_t i = 0ul; i < inputs.size(); ++i) {
+    const auto sidx = m_net_ptr->species_d2i(inputs[i].first);
+    const auto it = std::find_if(reactants.cbegin(), reactants.cend(),
+                      [sidx](const auto& u) { return (u.first == sidx); });
+    if (it == reactants.cend()) {
+      WCS_THROW(err + " has a rate depending on " + g[inputs[i].first].get_label()
+                + " which is not a reactant.");
+    }
+    input_map[i] = static_cast<size_t>(it - reactants.cbegin());
+  }
+  if (inputs.size() != reactants.size()) {
+    WCS_THROW(err + " has a rate that does not depend on every reactant.");
+  }
+
+  using counts_t = std::array<reaction_rate_t, 2>;
+  auto rate = [&](const counts_t& n) {
+    std::vector<reaction_rate_t> params(inputs.size());
+    for (size_t i = 0ul; i < inputs.size(); ++i) {
+      params[i] = n[input_map[i]];
+    }
+    return rprop.calc_rate(std::move(params));
+  };
+  auto check = [&](const std::vector<counts_t>& probes, const auto& expected) {
+    for (const auto& n : probes) {
+      if (!matches(rate(n), expected(n))) {
+        WCS_THROW(err + " does not follow the mass-action kinetics.");
+      }
+    }
+  };
+
+  constexpr auto zero = static_cast<reaction_rate_t>(0.0);
+  factor_t f;
+  f.dep = no_species;
+  f.min_cnt = static_cast<species_cnt_t>(0);
+  f.coef = zero;
+
+  if (reactants.empty()) {
+    f.group = m_num_groups - 1u;
+    f.cons = rate({zero, zero});
+  } else if ((reactants.size() == 1ul) && (order == 1)) {
+    const auto c = rate({1.0, zero});
+    check({{0.0, 0.0}, {2.0, 0.0}, {3.0, 0.0}, {10.0, 0.0}, {1000.0, 0.0}},
+          [c](const counts_t& n) { return c*n[0]; });
+    f.group = reactants[0].first;
+    f.cons = c;
+  } else if (reactants.size() == 2ul) {
+    const auto c = rate({1.0, 1.0});
+    check({{0.0, 1.0}, {1.0, 0.0}, {2.0, 3.0}, {3.0, 2.0}, {10.0, 7.0},
+           {1000.0, 13.0}},
+          [c](const counts_t& n) { return c*n[0]*n[1]; });
+    // Group by the species of the lower index for the order to be stable
+    const bool first_lower = (reactants[0].first < reactants[1].first);
+    f.group = reactants[first_lower? 0 : 1].first;
+    f.dep = reactants[first_lower? 1 : 0].first;
+    f.coef = c;
+    f.cons = zero;
+  } else { // A + A -> ...
+    // The rate at the count of one does not matter as the reaction needs two
+    const auto p2 = rate({2.0, zero})/2.0;
+    const auto p3 = rate({3.0, zero})/3.0;
+    const auto a = p3 - p2;
+    const auto b = p2 - 2.0*a;
+    if (a < zero) {
+      WCS_THROW(err + " does not follow the mass-action kinetics.");
+    }
+    check({{0.0, 0.0}, {4.0, 0.0}, {10.0, 0.0}, {1000.0, 0.0}},
+          [a, b](const counts_t& n) { return n[0]*(a*n[0] + b); });
+    f.group = reactants[0].first;
+    f.dep = reactants[0].first;
+    f.min_cnt = static_cast<species_cnt_t>(2);
+    f.coef = a;
+    f.cons = b;
+  }
+
+  return f;
+}
+
+/**
+ * Factorize the propensity of every reaction, and lay out the partial
+ * propensities contiguously by the group. Also, build the table of the
+ * partial propensities depending on each species.
+ */
+void SSA_PDM::build_partial_propensities()
+{
+  const auto& reactions = m_net_ptr->reaction_list();
+  const auto num_reactions = reactions.size();
+  const auto num_species = m_net_ptr->get_num_species();
+  m_num_groups = static_cast<v_idx_t>(num_species + 1u);
+
+  std::vector<factor_t> factors;
+  factors.reserve(num_reactions);
+  for (const auto& rd : reactions) {
+    factors.emplace_back(factorize(rd));
+    // Restore the rate that probing has overwritten
+    m_net_ptr->set_reaction_rate(rd);
+  }
+
+  m_group_offsets.assign(m_num_groups + 1u, 0ul);
+  for (const auto& f : factors) {
+    m_group_offsets[f.group + 1u] ++;
+  }
+  for (v_idx_t g = 0u; g < m_num_groups; ++g) {
+    m_group_offsets[g + 1u] += m_group_offsets[g];
+  }
+
+  std::vector<size_t> pos(m_group_offsets.cbegin(),
+                          m_group_offsets.cend() - 1);
+  m_factors.resize(num_reactions);
+  m_reactions.resize(num_reactions);
+  for (size_t i = 0ul; i < num_reactions; ++i) {
+    const auto p = pos[factors[i].group] ++;
+    m_factors[p] = factors[i];
+    m_reactions[p] = static_cast<v_idx_t>(i);
+  }
+
+  m_dep_offsets.assign(num_species + 1u, 0ul);
+  for (const auto& f : m_factors) {
+    if (f.dep != no_species) {
+      m_dep_offsets[f.dep + 1u] ++;
+    }
+  }
+  for (size_t i = 0ul; i < num_species; ++i) {
+    m_dep_offsets[i + 1u] += m_dep_offsets[i];
+  }
+  pos.assign(m_dep_offsets.cbegin(), m_dep_offsets.cend() - 1);
+  m_dep_partials.resize(m_dep_offsets.back());
+  for (size_t p = 0ul; p < num_reactions; ++p) {
+    if (m_factors[p].dep != no_species) {
+      m_dep_partials[pos[m_factors[p].dep] ++] = p;
+    }
+  }
+
+  m_partial.resize(num_reactions);
+  for (size_t p = 0ul; p < num_reactions; ++p) {
+    m_partial[p] = calc_partial(p);
+  }
+  m_lambda.assign(m_num_groups, static_cast<reaction_rate_t>(0.0));
+  m_sigma.assign(m_num_groups, static_cast<reaction_rate_t>(0.0));
+
+  m_resum_period = static_cast<sim_iter_t>(
+                     std::max(num_reactions, static_cast<size_t>(m_num_groups)));
+  sum_propensities();
+}
+
+void SSA_PDM::sum_propensities()
+{
+  m_a0 = static_cast<reaction_rate_t>(0.0);
+  for (v_idx_t g = 0u; g < m_num_groups; ++g) {
+    auto lambda = static_cast<reaction_rate_t>(0.0);
+    for (auto p = m_group_offsets[g]; p < m_group_offsets[g + 1u]; ++p) {
+      lambda += m_partial[p];
+    }
+    m_lambda[g] = lambda;
+    m_sigma[g] = group_count(g) * lambda;
+    m_a0 += m_sigma[g];
+  }
+  m_iter_since_resum = static_cast<sim_iter_t>(0u);
+  m_resum_threshold = m_a0 * static_cast<reaction_rate_t>(1e-8);
+}
+
+inline reaction_rate_t SSA_PDM::calc_partial(const size_t pos) const
+{
+  const auto& f = m_factors[pos];
+  if (f.dep == no_species) {
+    return f.cons;
+  }
+  const auto n = m_net_ptr->species_count(f.dep);
+  return ((n < f.min_cnt)? static_cast<reaction_rate_t>(0.0) :
+                           (f.coef * static_cast<reaction_rate_t>(n) + f.cons));
+}
+
+inline reaction_rate_t SSA_PDM::group_count(const v_idx_t g) const
+{
+  return ((g + 1u == m_num_groups)? static_cast<reaction_rate_t>(1.0) :
+            static_cast<reaction_rate_t>(m_net_ptr->species_count(g)));
+}
+
+inline void SSA_PDM::update_group(const v_idx_t g)
+{
+  const auto sigma = group_count(g) * m_lambda[g];
+  m_a0 += sigma - m_sigma[g];
+  m_sigma[g] = sigma;
+}
+
+/**
+ * Recompute the partial propensities that depend on the count of the given
+ * species, and the totals of the groups that they belong to as well as that
+ * of the group of the species itself. As everything is recomputed from the
+ * current count, calling this for a species more than once is harmless.
+ */
+void SSA_PDM::update_species(const v_idx_t sidx)
+{
+  for (auto i = m_dep_offsets[sidx]; i < m_dep_offsets[sidx + 1u]; ++i) {
+    const auto p = m_dep_partials[i];
+    const auto partial = calc_partial(p);
+    const auto g = m_factors[p].group;
+    m_lambda[g] += partial - m_partial[p];
+    m_partial[p] = partial;
+    update_group(g);
+  }
+  update_group(sidx);
+}
+
+void SSA_PDM::update_reactions(const v_desc_t rd_fired)
+{
+  for (const auto& u : m_net_ptr->get_reactant_updates(rd_fired)) {
+    update_species(u.first);
+  }
+  for (const auto& u : m_net_ptr->get_product_updates(rd_fired)) {
+    update_species(u.first);
+  }
+  if (++m_iter_since_resum >= m_resum_period) {
+    sum_propensities();
+  }
+}
+
+/**
+ * Find the group by a linear search over the group totals, and then the
+ * reaction within the group by a linear search over the partial propensities
+ * scaled by the group count. Entries of zero propensity are never chosen even
+ * when the random number falls at the end of the range due to round-off.
+ */
+v_idx_t SSA_PDM::choose_reaction()
+{
+  constexpr auto zero_rate = static_cast<reaction_rate_t>(0.0);
+
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    auto rn = static_cast<reaction_rate_t>(m_rgen_evt() * m_a0);
+
+    v_idx_t g = 0u;
+    v_idx_t g_last = m_num_groups;
+    for (; g < m_num_groups; ++g) {
+      if (m_sigma[g] <= zero_rate) continue;
+      g_last = g;
+      if (rn < m_sigma[g]) break;
+      rn -= m_sigma[g];
+    }
+    if (g == m_num_groups) {
+      g = g_last;
+    }
+
+    if (BOOST_LIKELY(g < m_num_groups)) {
+      rn /= group_count(g);
+      size_t p = m_group_offsets[g];
+      size_t p_last = m_group_offsets[g + 1u];
+      for (; p < m_group_offsets[g + 1u]; ++p) {
+        if (m_partial[p] <= zero_rate) continue;
+        p_last = p;
+        if (rn < m_partial[p]) break;
+        rn -= m_partial[p];
+      }
+      if (p == m_group_offsets[g + 1u]) {
+        p = p_last;
+      }
+      if (BOOST_LIKELY(p < m_group_offsets[g + 1u])) {
+        return m_reactions[p];
+      }
+    }
+    // The totals have drifted from the partial propensities. Recompute them.
+    sum_propensities();
+  }
+
+  WCS_THROW("Not able to choose any reaction to fire!");
+  return static_cast<v_idx_t>(0u);
+}
+
+sim_time_t SSA_PDM::get_reaction_time()
+{
+  return ((m_a0 <= static_cast<reaction_rate_t>(0))?
+            wcs::Network::get_etime_ulimit() :
+            -static_cast<reaction_rate_t>(log(m_rgen_tm())/m_a0));
+}
+
+Sim_Method::result_t SSA_PDM::schedule(sim_time_t& next_time)
+{
+  if (BOOST_UNLIKELY(m_partial.empty())) { // no reaction possible
+    std::cerr << "No reaction exists." << std::endl;
+    return Empty;
+  }
+
+  if (BOOST_UNLIKELY(m_a0 <= m_resum_threshold)) {
+    sum_propensities();
+  }
+
+  // Determine when the next reaction to occur
+  const auto dt = get_reaction_time();
+  next_time = m_sim_time + dt;
+
+  if (BOOST_UNLIKELY((dt >= wcs::Network::get_etime_ulimit()) ||
+                     (next_time > m_max_time))) {
+    std::cerr << "No more reaction can fire." << std::endl;
+    return Inactive;
+  }
+
+  return Success;
+}
+
+bool SSA_PDM::forward(const sim_time_t t)
+{
+  if (BOOST_UNLIKELY((m_sim_iter >= m_max_iter) || (t > m_max_time))) {
+    return false; // do not continue simulation
+  }
+  ++ m_sim_iter;
+  m_sim_time = t;
+
+  Sim_State_Change digest;
+
+  // Determine the reaction to occur at this time
+  digest.m_sim_time = t;
+  digest.m_reaction_fired = m_net_ptr->reaction_list()[choose_reaction()];
+
+  // Execute the reaction, updating species counts
+  Sim_Method::fire_reaction(digest);
+
+  // Update the partial propensities depending on the species updated
+  update_reactions(digest.m_reaction_fired);
+
+  record(digest.m_reaction_fired);
+
+  return true;
+}
+
+void SSA_PDM::init(const sim_iter_t max_iter,
+                   const double max_time,
+                   const unsigned rng_seed)
+{
+  if (!m_net_ptr) {
+    WCS_THROW("Invalid pointer to the reaction network.");
+  }
+
+  m_max_time = max_time;
+  m_max_iter = max_iter;
+  m_sim_time = static_cast<sim_time_t>(0);
+  m_sim_iter = static_cast<sim_iter_t>(0u);
+
+  { // initialize the random number generator
+    if (rng_seed == 0u) {
+      m_rgen_evt.set_seed();
+      m_rgen_tm.set_seed();
+    } else {
+      seed_seq_param_t common_param_e
+        = make_seed_seq_input(1, rng_seed, std::string("SSA_PDM"));
+      seed_seq_param_t common_param_t
+        = make_seed_seq_input(2, rng_seed, std::string("SSA_PDM"));
+
+      std::vector<seed_seq_param_t> unique_params;
+      const size_t num_procs = 1ul;
+      const size_t my_rank = 0ul;
+
+      // make sure to avoid generating any duplicate seed sequence
+      gen_unique_seed_seq_params<rng_t::get_state_size()>(
+          num_procs, common_param_e, unique_params);
+      m_rgen_evt.use_seed_seq(unique_params[my_rank]);
+
+      // make sure to avoid generating any duplicate seed sequence
+      gen_unique_seed_seq_params<rng_t::get_state_size()>(
+          num_procs, common_param_t, unique_params);
+      m_rgen_tm.use_seed_seq(unique_params[my_rank]);
+    }
+
+    m_rgen_evt.param(typename rng_t::param_type(0.0, 1.0));
+    m_rgen_tm.param(typename rng_t::param_type(0.0, 1.0));
+  }
+
+  Sim_Method::initialize_recording(m_net_ptr);
+
+  build_partial_propensities();
+}
+
+
+#if defined(WCS_HAS_ROSS)
+void SSA_PDM::record_first_n(const sim_iter_t num)
+{
+}
+#endif // defined(WCS_HAS_ROSS)
+
+
+std::pair<sim_iter_t, sim_time_t> SSA_PDM::run()
+{
+  sim_time_t t = static_cast<sim_time_t>(0);
+
+  if (schedule(t) != Success) {
+    WCS_THROW("Not able to schedule any reaction event!");
+  }
+
+  while (BOOST_LIKELY(forward(t))) {
+    if (BOOST_UNLIKELY(schedule(t) != Success)) {
+      break;
+    }
+  }
+
+  return std::make_pair(m_sim_iter, m_sim_time);
+}
+
+/**@}*/
+} // end of namespace wcs
@@ -0,0 +1,187 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef __WCS_SIM_METHODS_SSA_PDM_HPP__
+#define __WCS_SIM_METHODS_SSA_PDM_HPP__
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <limits>
+#include <string>
+#include <vector>
+#include "sim_methods/sim_method.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_sim_methods
+ *  @{ */
+
+/**
+ *  Partial-propensity direct method (PDM) of Ramaswamy, Gonzalez-Segredo and
+ *  Sbalzarini (J. Chem. Phys. 130, 244104, 2009) for networks of elementary
+ *  reactions, i.e., the reactions of which the rate follows the mass-action
+ *  kinetics with at most two reactant molecules.
+ *
+ *  The propensity of such a reaction factors into the count of one of its
+ *  reactants and a partial propensity that depends on the count of the other
+ *  reactant, if any. Reactions are grouped by the former species, and the
+ *  partial propensities of each group are kept in a contiguous array along
+ *  with their sum. A reaction is chosen by first finding the group by a
+ *  linear search over the group totals, and then the reaction within the
+ *  group. When a reaction fires, only the group totals of the species of
+ *  which the count has changed, and the partial propensities that depend on
+ *  those species are updated. Thus, the cost of an update is bounded by the
+ *  number of species touched rather than the number of reactions affected.
+ *
+ *  Whether every reaction in the network is elementary is checked at
+ *  initialization by evaluating its rate formula at a number of probing
+ *  points. If any is not, initialization fails.
+ *
+ *  The propensities are maintained only within this method. The reaction
+ *  rates stored in the network are not updated during the simulation.
+ */
+class SSA_PDM : public Sim_Method {
+public:
+  using rng_t = wcs::RNGen<std::uniform_real_distribution, double>;
+  using v_desc_t = Sim_Method::v_desc_t;
+
+  SSA_PDM(const std::shared_ptr<wcs::Network>& net_ptr);
+  SSA_PDM(SSA_PDM&& other) = default;
+  SSA_PDM& operator=(SSA_PDM&& other) = default;
+  ~SSA_PDM() override;
+
+  /// Check the network and build the partial propensity structure
+  void init(const unsigned max_iter,
+            const double max_time,
+            const unsigned rng_seed) override;
+
+  /**
+   * Determines when the next reaction to occur.
+   * When successful, this function returns Sim_Method::Success. Otherwise,
+   * it returns a failure code.
+   */
+  Sim_Method::result_t schedule(sim_time_t& t);
+  /**
+   * Determine which reaction to fire and execute it at the given time.
+   * Check the simulation termination condition at the beginning. If it is not
+   * to be terminated yet, proceed and return true. Otherwise, stop immediately
+   * and return false.
+   */
+  bool forward(const sim_time_t t);
+  /// Main loop of PDM
+  std::pair<unsigned, sim_time_t> run() override;
+
+ #if defined(WCS_HAS_ROSS)
+  /// PDM does not support rollback, and the states are recorded as they occur
+  void record_first_n(const sim_iter_t num) override;
+ #endif // defined(WCS_HAS_ROSS)
+
+  rng_t& rgen_e();
+  rng_t& rgen_t();
+
+protected:
+  /// Marks a partial propensity that does not depend on any species count
+  static constexpr v_idx_t no_species = std::numeric_limits<v_idx_t>::max();
+
+  /**
+   * Factorization of the propensity of an elementary reaction. The propensity
+   * is the count of the species of the group times the partial propensity
+   * `coef * n + cons` where `n` is the count of the dependent species. The
+   * partial propensity is zero if `n` is less than `min_cnt`. The count of the
+   * group of the zeroth order reactions is always one.
+   */
+  struct factor_t {
+    v_idx_t group;
+    v_idx_t dep;
+    species_cnt_t min_cnt;
+    reaction_rate_t coef;
+    reaction_rate_t cons;
+  };
+
+  /**
+   * Find the factorization of the propensity of the given reaction. Throw
+   * with the reason if the reaction is not elementary.
+   */
+  factor_t factorize(const v_desc_t rd) const;
+  /// Build the partial propensity structure
+  void build_partial_propensities();
+  /// Recompute the group totals and the total propensity from scratch
+  void sum_propensities();
+
+  /// Compute the partial propensity at the given position
+  reaction_rate_t calc_partial(const size_t pos) const;
+  /// Return the count of the species of the given group
+  reaction_rate_t group_count(const v_idx_t g) const;
+  /// Recompute the total propensity of the given group
+  void update_group(const v_idx_t g);
+  /// Update the partial propensities depending on the given species
+  void update_species(const v_idx_t sidx);
+
+  /// Randomly determine which reaction to fire
+  v_idx_t choose_reaction();
+  sim_time_t get_reaction_time();
+  /// Update the propensities after the given reaction fired
+  void update_reactions(const v_desc_t rd_fired);
+
+protected:
+  rng_t m_rgen_evt; ///< RNG for events
+  rng_t m_rgen_tm; ///< RNG for event times
+
+  /// The number of groups, which is the number of species plus one
+  v_idx_t m_num_groups;
+  /**
+   * Offsets into the arrays of partial propensities by the group index. The
+   * partial propensities of the g-th group are in
+   * [m_group_offsets[g], m_group_offsets[g+1]). The last group is that of the
+   * zeroth order reactions.
+   */
+  std::vector<size_t> m_group_offsets;
+  /// Partial propensities concatenated by the group
+  std::vector<reaction_rate_t> m_partial;
+  /// Factorization of the propensity of each reaction in the order of m_partial
+  std::vector<factor_t> m_factors;
+  /// The reaction index of each partial propensity
+  std::vector<v_idx_t> m_reactions;
+
+  /// Sum of the partial propensities of each group
+  std::vector<reaction_rate_t> m_lambda;
+  /// Total propensity of each group, i.e., the group count times m_lambda
+  std::vector<reaction_rate_t> m_sigma;
+  /// Total propensity of all the reactions
+  reaction_rate_t m_a0;
+
+  /**
+   * Offsets into m_dep_partials by the species index. The positions of the
+   * partial propensities depending on the i-th species are in
+   * [m_dep_offsets[i], m_dep_offsets[i+1]).
+   */
+  std::vector<size_t> m_dep_offsets;
+  std::vector<size_t> m_dep_partials;
+
+  /**
+   * The sums are updated by adding differences. Recompute them from scratch
+   * once in this many iterations to keep the round-off error from building up.
+   */
+  sim_iter_t m_resum_period;
+  /// The number of iterations since the sums were recomputed from scratch
+  sim_iter_t m_iter_since_resum;
+  /**
+   * Recompute the sums from scratch as well when the total propensity drops
+   * below this, as most of its significant digits may have been cancelled.
+   */
+  reaction_rate_t m_resum_threshold;
+};
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_SIM_METHODS_SSA_PDM_HPP__
@@ -8,8 +8,9 @@
  *                                                                            *
  ******************************************************************************/
 
-#include <algorithm> // upper_bound
+#include <algorithm> // upper_bound, stable_sort
 #include <cmath> // log
+#include <numeric> // iota, accumulate
 #include "sim_methods/ssa_sod.hpp"
 #include "utils/exception.hpp"
 #include "utils/seed.hpp"
@@ -23,7 +24,14 @@ namespace wcs {
  *  @{ */
 
 SSA_SOD::SSA_SOD(const std::shared_ptr<wcs::Network>& net_ptr)
-: Sim_Method(net_ptr) {}
+: Sim_Method(net_ptr)
+#if defined(WCS_SOD_SORTING_DIRECT)
+, m_a0(static_cast<reaction_rate_t>(0.0)),
+  m_resum_period(static_cast<sim_iter_t>(1u)),
+  m_iter_since_resum(static_cast<sim_iter_t>(0u)),
+  m_resum_threshold(static_cast<reaction_rate_t>(0.0))
+#endif // defined(WCS_SOD_SORTING_DIRECT)
+{}
 
 SSA_SOD::~SSA_SOD() {}
 
@@ -37,6 +45,120 @@ SSA_SOD::rng_t& SSA_SOD::rgen_t() {
   return m_rgen_tm;
 }
 
+#if defined(WCS_SOD_SORTING_DIRECT)
+/**
+ * Initialize the reaction propensity list by filling it with the propesity of
+ * every reaction in the descending order, which is the initial search order.
+ */
+void SSA_SOD::build_propensity_list()
+{
+  const auto& reactions = m_net_ptr->reaction_list();
+  const size_t num_reactions = reactions.size();
+
+  std::vector<size_t> order(num_reactions);
+  std::iota(order.begin(), order.end(), 0ul);
+  std::stable_sort(order.begin(), order.end(),
+    [&](const size_t i, const size_t j) {
+      return (m_net_ptr->reaction_rate(i) > m_net_ptr->reaction_rate(j));
+    });
+
+  m_propensity.resize(num_reactions);
+  m_order.resize(num_reactions);
+  m_pos.resize(num_reactions);
+
+  for (size_t p = 0ul; p < num_reactions; ++p) {
+    const auto ridx = order[p];
+    m_propensity[p] = m_net_ptr->reaction_rate(ridx);
+    m_order[p] = reactions[ridx];
+    m_pos[ridx] = p;
+  }
+
+  m_resum_period = static_cast<sim_iter_t>(std::max(num_reactions, 1ul));
+  sum_propensities();
+}
+
+void SSA_SOD::sum_propensities()
+{
+  m_a0 = std::accumulate(m_propensity.cbegin(), m_propensity.cend(),
+                         static_cast<reaction_rate_t>(0.0));
+  m_iter_since_resum = static_cast<sim_iter_t>(0u);
+  m_resum_threshold = m_a0 * static_cast<reaction_rate_t>(1e-8);
+}
+
+/**
+ * Randomly determine which reaction to fire by a linear search in the current
+ * order. An entry of zero propensity is never chosen even when the random
+ * number falls at the end of the range due to round-off.
+ */
+size_t SSA_SOD::choose_reaction()
+{
+  constexpr auto zero_rate = static_cast<reaction_rate_t>(0.0);
+  auto rn = static_cast<reaction_rate_t>(m_rgen_evt() * m_a0);
+
+  const size_t n = m_propensity.size();
+  size_t last = n;
+  for (size_t p = 0ul; p < n; ++p) {
+    const auto rate = m_propensity[p];
+    if (rate <= zero_rate) continue;
+    if (rn < rate) return p;
+    rn -= rate;
+    last = p;
+  }
+  if (last == n) {
+    WCS_THROW("Failed to choose a reaction to fire");
+  }
+  return last;
+}
+
+void SSA_SOD::move_forward(const size_t pos)
+{
+  if (pos == 0ul) {
+    return;
+  }
+  const auto prev = pos - 1ul;
+  std::swap(m_propensity[prev], m_propensity[pos]);
+  std::swap(m_order[prev], m_order[pos]);
+  m_pos[m_net_ptr->reaction_d2i(m_order[prev])] = prev;
+  m_pos[m_net_ptr->reaction_d2i(m_order[pos])] = pos;
+}
+
+/// Randomly determine the time period until the next reaction
+sim_time_t SSA_SOD::get_reaction_time()
+{
+  return ((m_a0 <= static_cast<reaction_rate_t>(0))?
+            wcs::Network::get_etime_ulimit() :
+            -static_cast<reaction_rate_t>(log(m_rgen_tm())/m_a0));
+}
+
+/**
+ * Recompute the reaction rates of those affected which are linked with
+ * updating species. Each update only changes the entry of the reaction and
+ * the total propensity.
+ */
+void SSA_SOD::update_reactions(const SSA_SOD::v_desc_t& vd_fired,
+  const Sim_Method::affected_reactions_t& affected_reactions,
+  bool check_reaction)
+{
+  constexpr auto zero_rate = static_cast<reaction_rate_t>(0.0);
+
+  auto update = [&](const v_desc_t& vd) {
+    const auto new_rate = (check_reaction && !m_net_ptr->check_reaction(vd))?
+                           zero_rate : m_net_ptr->set_reaction_rate(vd);
+    auto& rate = m_propensity[m_pos[m_net_ptr->reaction_d2i(vd)]];
+    m_a0 += new_rate - rate;
+    rate = new_rate;
+  };
+
+  update(vd_fired);
+  for (const auto& vd : affected_reactions) {
+    update(vd);
+  }
+
+  if (++m_iter_since_resum >= m_resum_period) {
+    sum_propensities();
+  }
+}
+#else
 /**
  * Initialize the reaction propensity list by filling it with the propesity of
  * every reaction and sorting.
@@ -124,9 +246,9 @@ void SSA_SOD::update_reactions(const SSA_SOD::v_desc_t& vd_fired,
   auto it_rvd = idx_rvd.find(vd_fired);
   bool ok = idx_rvd.replace(it_rvd, priority_t{new_rate, zero_rate, vd_fired});
 
-  affected_reactions_t::const_iterator it_aff = affected_reactions.cbegin();
+  auto it_aff = affected_reactions.begin();
   // update the propensity of the rest of affected reactions
-  for (; ok && (it_aff != affected_reactions.cend()); ++it_aff) {
+  for (; ok && (it_aff != affected_reactions.end()); ++it_aff) {
     const auto& vd = *it_aff;
     const auto new_rate = (check_reaction && !m_net_ptr->check_reaction(vd))?
                            zero_rate : m_net_ptr->set_reaction_rate(vd);
@@ -155,6 +277,7 @@ void SSA_SOD::update_reactions(const SSA_SOD::v_desc_t& vd_fired,
     WCS_THROW("Failed to update reactions.");
   }
 }
+#endif // defined(WCS_SOD_SORTING_DIRECT)
 
 
 void SSA_SOD::init(const sim_iter_t max_iter,
@@ -211,8 +334,8 @@ void SSA_SOD::init(const sim_iter_t max_iter,
 
 void SSA_SOD::save_rgen_state(Sim_State_Change& digest) const
 {
-  constexpr size_t rng_state_size = sizeof(m_rgen_evt.engine())
-                                  + sizeof(m_rgen_tm.engine());
+  const size_t rng_state_size = m_rgen_evt.engine_byte_size()
+                              + m_rgen_tm.engine_byte_size();
   digest.m_rng_state.clear();
   digest.m_rng_state.reserve(rng_state_size);
   wcs::ostreamvec<char> ostrmbuf(digest.m_rng_state);
@@ -222,7 +345,8 @@ void SSA_SOD::save_rgen_state(Sim_State_Change& digest) const
   cereal::BinaryOutputArchive oarchive(os);
   oarchive(m_rgen_evt.engine(), m_rgen_tm.engine());
  #else
-  os << bits(m_rgen_evt.engine()) << bits(m_rgen_tm.engine());
+  m_rgen_evt.save_engine_bits(os);
+  m_rgen_tm.save_engine_bits(os);
  #endif // defined(WCS_HAS_CEREAL)
 }
 
@@ -236,17 +360,119 @@ void SSA_SOD::load_rgen_state(const Sim_State_Change& digest)
   cereal::BinaryInputArchive iarchive(is);
   iarchive(m_rgen_evt.engine(), m_rgen_tm.engine());
  #else
-  is >> bits(m_rgen_evt.engine()) >> bits(m_rgen_tm.engine());
+  m_rgen_evt.load_engine_bits(is);
+  m_rgen_tm.load_engine_bits(is);
  #endif // defined(WCS_HAS_CEREAL)
 }
 
 
+#if defined(WCS_SOD_SORTING_DIRECT)
+/**
+ * The propensities are saved in the current search order along with the
+ * total, which is maintained incrementally in between resummations.
+ */
+void SSA_SOD::save_method_state(std::ostream& os) const
+{
+  save_state_tag(os, "SSA_SOD/sorting_direct");
+
+  std::vector<v_idx_t> ridx;
+  ridx.reserve(m_order.size());
+  for (const auto& vd : m_order) {
+    ridx.push_back(m_net_ptr->reaction_d2i(vd));
+  }
+  os << bits(m_propensity) << bits(ridx) << bits(m_a0)
+     << bits(m_iter_since_resum) << bits(m_resum_threshold);
+
+  m_rgen_evt.save_bits(os);
+  m_rgen_tm.save_bits(os);
+}
+
+
+void SSA_SOD::load_method_state(std::istream& is)
+{
+  check_state_tag(is, "SSA_SOD/sorting_direct");
+
+  std::vector<v_idx_t> ridx;
+  is >> bits(m_propensity) >> bits(ridx) >> bits(m_a0)
+     >> bits(m_iter_since_resum) >> bits(m_resum_threshold);
+  if (!is || (m_propensity.size() != ridx.size()) ||
+      (ridx.size() != m_net_ptr->get_num_reactions())) {
+    WCS_THROW("Invalid propensity list in the checkpoint.");
+  }
+
+  m_order.resize(ridx.size());
+  m_pos.resize(ridx.size());
+  for (size_t p = 0ul; p < ridx.size(); ++p) {
+    m_order[p] = m_net_ptr->reaction_i2d(ridx[p]);
+    m_pos.at(ridx[p]) = p;
+  }
+
+  m_rgen_evt.load_bits(is);
+  m_rgen_tm.load_bits(is);
+}
+#else
+/**
+ * The cumulative propensities are saved as they are, since those are updated
+ * incrementally and may differ from the sums recomputed in the last bits.
+ */
+void SSA_SOD::save_method_state(std::ostream& os) const
+{
+  save_state_tag(os, "SSA_SOD");
+
+  std::vector<reaction_rate_t> rates;
+  std::vector<reaction_rate_t> curates;
+  std::vector<v_idx_t> ridx;
+  rates.reserve(m_propensity.size());
+  curates.reserve(m_propensity.size());
+  ridx.reserve(m_propensity.size());
+  for (const auto& p : m_propensity.get<tag_rate>()) {
+    rates.push_back(p.m_rate);
+    curates.push_back(p.m_curate);
+    ridx.push_back(m_net_ptr->reaction_d2i(p.m_rvd));
+  }
+  os << bits(rates) << bits(curates) << bits(ridx);
+
+  m_rgen_evt.save_bits(os);
+  m_rgen_tm.save_bits(os);
+}
+
+
+void SSA_SOD::load_method_state(std::istream& is)
+{
+  check_state_tag(is, "SSA_SOD");
+
+  std::vector<reaction_rate_t> rates;
+  std::vector<reaction_rate_t> curates;
+  std::vector<v_idx_t> ridx;
+  is >> bits(rates) >> bits(curates) >> bits(ridx);
+  if (!is || (rates.size() != ridx.size()) || (curates.size() != ridx.size()) ||
+      (ridx.size() != m_net_ptr->get_num_reactions())) {
+    WCS_THROW("Invalid propensity list in the checkpoint.");
+  }
+
+  m_propensity.clear();
+  for (size_t i = 0ul; i < ridx.size(); ++i) {
+    m_propensity.emplace(priority_t{rates[i], curates[i],
+                                    m_net_ptr->reaction_i2d(ridx[i])});
+  }
+
+  m_rgen_evt.load_bits(is);
+  m_rgen_tm.load_bits(is);
+}
+#endif // defined(WCS_SOD_SORTING_DIRECT)
+
+
 Sim_Method::result_t SSA_SOD::schedule(sim_time_t& next_time)
 {
   if (BOOST_UNLIKELY(m_propensity.empty())) { // no reaction possible
     std::cerr << "No reaction exists." << std::endl;
     return Empty;
   }
+ #if defined(WCS_SOD_SORTING_DIRECT)
+  if (BOOST_UNLIKELY(m_a0 <= m_resum_threshold)) {
+    sum_propensities();
+  }
+ #endif // defined(WCS_SOD_SORTING_DIRECT)
 
   // Determine the time when the next reaction to occur
   const auto dt = get_reaction_time();
@@ -280,10 +506,13 @@ bool SSA_SOD::forward(const sim_time_t t)
  #endif // defined(WCS_HAS_ROSS)
 
   // Determine the reaction to occur at this time
-  auto firing = choose_reaction();
-
+ #if defined(WCS_SOD_SORTING_DIRECT)
+  const auto pos = choose_reaction();
+  digest.m_reaction_fired = m_order[pos];
+ #else
+  digest.m_reaction_fired = choose_reaction().m_rvd;
+ #endif // defined(WCS_SOD_SORTING_DIRECT)
   digest.m_sim_time = t;
-  digest.m_reaction_fired = firing.m_rvd;
 
   // Execute the reaction, updating species counts
   Sim_Method::fire_reaction(digest);
@@ -291,9 +520,17 @@ bool SSA_SOD::forward(const sim_time_t t)
   // Update the propensities of those reactions fired and affected
   update_reactions(digest.m_reaction_fired, digest.m_reactions_affected, true);
 
+ #if defined(WCS_SOD_SORTING_DIRECT)
+  // Let the reaction fired be found earlier next time
+  move_forward(pos);
+ #if defined(WCS_HAS_ROSS)
+  digest.m_moved = (pos > 0ul);
+ #endif // defined(WCS_HAS_ROSS)
+ #endif // defined(WCS_SOD_SORTING_DIRECT)
+
  #if !defined(WCS_HAS_ROSS)
   // With ROSS, tracing and sampling are moved to process at commit time
-  record(firing.m_rvd);
+  record(digest.m_reaction_fired);
  #endif // defined(WCS_HAS_ROSS)
 
   return true;
@@ -304,7 +541,7 @@ bool SSA_SOD::forward(const sim_time_t t)
 void SSA_SOD::backward(sim_time_t& t)
 {
   // State of the last event to undo
-  Sim_State_Change& digest = m_digests.back();
+  auto& digest = m_digests.back();
   // The BGL vertex descriptor of the the reaction to undo
   const auto& rd_fired = digest.m_reaction_fired;
 
@@ -312,6 +549,12 @@ void SSA_SOD::backward(sim_time_t& t)
   undo_reaction(rd_fired);
   // Undo the propensity updates done for the reactions affected
   update_reactions(rd_fired, digest.m_reactions_affected, false);
+ #if defined(WCS_SOD_SORTING_DIRECT)
+  // Move the reaction back to where it was in the search order
+  if (digest.m_moved) {
+    move_forward(m_pos[m_net_ptr->reaction_d2i(rd_fired)] + 1ul);
+  }
+ #endif // defined(WCS_SOD_SORTING_DIRECT)
 
   // Restore the time
   t = digest.m_sim_time;
@@ -357,6 +600,7 @@ std::pair<sim_iter_t, sim_time_t> SSA_SOD::run()
   }
 
   while (BOOST_LIKELY(forward(t))) {
+    checkpoint_if_due();
     if (BOOST_UNLIKELY(schedule(t) != Success)) {
       break;
     }
@@ -19,6 +19,7 @@
 
 #include <cmath>
 #include <limits>
+#include <vector>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
@@ -34,6 +35,16 @@ namespace wcs {
  * Sorted optimized direct method.
  * This method takes advantage of a dependency graph similarly to the optimized
  * direct method, and it maintains the propensity list in sorted order.
+ *
+ * When built with WCS_SOD_SORTING_DIRECT, this instead implements the sorting
+ * direct method of McCollum et al. (Comput. Biol. Chem. 30, 39-49, 2006).
+ * The propensities are kept in a flat array in the order of the linear search
+ * for the reaction to fire. Initially, the order is by the descending
+ * propensity. Each time a reaction fires, it swaps its position with the one
+ * immediately in front of it. Thus, frequently firing reactions gradually
+ * move toward the front, and the search ends early on average when a few
+ * reactions account for most of the events. Updating a propensity only
+ * touches its own entry and the total.
  */
 class SSA_SOD : public Sim_Method {
 public:
@@ -124,7 +135,16 @@ public:
 
 protected:
   void build_propensity_list();
+ #if defined(WCS_SOD_SORTING_DIRECT)
+  /// Return the position of the reaction to fire in the search order
+  size_t choose_reaction();
+  /// Swap the reaction at the given position with the one in front of it
+  void move_forward(const size_t pos);
+  /// Recompute the total propensity from scratch
+  void sum_propensities();
+ #else
   priority_t choose_reaction();
+ #endif // defined(WCS_SOD_SORTING_DIRECT)
   sim_time_t get_reaction_time();
   void update_reactions(const v_desc_t& rd_fired,
                         const Sim_Method::affected_reactions_t& affected,
@@ -133,14 +153,45 @@ protected:
   void save_rgen_state(Sim_State_Change& digest) const;
   void load_rgen_state(const Sim_State_Change& digest);
 
+  /// Save the propensities and the state of the generators
+  void save_method_state(std::ostream& os) const override;
+  void load_method_state(std::istream& is) override;
+
 protected:
+ #if defined(WCS_SOD_SORTING_DIRECT)
+  /// Propensities of reactions in the search order
+  std::vector<reaction_rate_t> m_propensity;
+  /// The reaction at each position of the search order
+  std::vector<v_desc_t> m_order;
+  /// The position of each reaction in the search order by the reaction index
+  std::vector<size_t> m_pos;
+  /// Total propensity
+  reaction_rate_t m_a0;
+  /**
+   * The total is updated by adding differences. Recompute it from scratch
+   * once in this many iterations, or when it drops below m_resum_threshold,
+   * to keep the round-off error from building up.
+   */
+  sim_iter_t m_resum_period;
+  sim_iter_t m_iter_since_resum;
+  reaction_rate_t m_resum_threshold;
+ #else
   /// Cumulative propensity of reactions events
   propensity_list_t m_propensity;
+ #endif // defined(WCS_SOD_SORTING_DIRECT)
   rng_t m_rgen_evt; ///< RNG for events
   rng_t m_rgen_tm; ///< RNG for event times
 
  #if defined(WCS_HAS_ROSS)
+ #if defined(WCS_SOD_SORTING_DIRECT)
+  struct digest_t : public Sim_State_Change {
+    /// Whether the reaction fired has moved forward in the search order
+    bool m_moved = false;
+  };
+  using digest_list_t = std::list<digest_t>;
+ #else
   using digest_list_t = std::list<Sim_State_Change>;
+ #endif // defined(WCS_SOD_SORTING_DIRECT)
   digest_list_t m_digests;
  #endif // defined(WCS_HAS_ROSS)
 };
@@ -0,0 +1,563 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <algorithm> // max, min, remove_if
+#include <cmath> // log, abs, isfinite
+#include <numeric> // accumulate
+#include <random> // poisson_distribution
+#include "sim_methods/ssa_tau.hpp"
+#include "utils/exception.hpp"
+#include "utils/seed.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_reaction_network
+ *  @{ */
+
+SSA_Tau::SSA_Tau(const std::shared_ptr<wcs::Network>& net_ptr)
+: Sim_Method(net_ptr),
+  m_epsilon(0.03),
+  m_n_critical(static_cast<firing_cnt_t>(10u)),
+  m_ssa_factor(10.0),
+  m_num_ssa_steps(static_cast<sim_iter_t>(100u)),
+  m_ssa_steps_left(static_cast<sim_iter_t>(0u))
+{}
+
+SSA_Tau::~SSA_Tau() {}
+
+void SSA_Tau::set_epsilon(const double eps)
+{
+  if ((eps <= 0.0) || (eps >= 1.0)) {
+    WCS_THROW("The error control parameter of tau-leaping must be in (0, 1).");
+  }
+  m_epsilon = eps;
+}
+
+double SSA_Tau::get_epsilon() const
+{
+  return m_epsilon;
+}
+
+/// Allow access to the internal random number generator for events
+SSA_Tau::rng_t& SSA_Tau::rgen_e() {
+  return m_rgen_evt;
+}
+
+/// Allow access to the internal random number generator for event times
+SSA_Tau::rng_t& SSA_Tau::rgen_t() {
+  return m_rgen_tm;
+}
+
+/**
+ * Build the table of the net changes of species counts by each reaction, and
+ * find the highest order reaction consuming each species, of which the order
+ * is the total number of reactant molecules.
+ */
+void SSA_Tau::build_leap_tables()
+{
+  const auto& reactions = m_net_ptr->reaction_list();
+  const auto num_reactions = reactions.size();
+  const auto num_species = m_net_ptr->get_num_species();
+
+  m_hor.assign(num_species, 0);
+  m_hor_stoic.assign(num_species, static_cast<stoic_t>(0));
+  m_change_offsets.clear();
+  m_change_offsets.reserve(num_reactions + 1u);
+  m_change_offsets.push_back(0ul);
+  m_net_changes.clear();
+
+  for (const auto& rd : reactions) {
+    const auto begin = m_net_changes.size();
+    auto add_change = [&] (const v_idx_t sidx, const stoic_t c) {
+      for (auto i = begin; i < m_net_changes.size(); ++i) {
+        if (m_net_changes[i].first == sidx) {
+          m_net_changes[i].second += c;
+          return;
+        }
+      }
+      m_net_changes.emplace_back(sidx, c);
+    };
+
+    int order = 0;
+    const auto reactants = m_net_ptr->get_reactant_updates(rd);
+    for (const auto& u : reactants) {
+      order += static_cast<int>(u.second);
+      add_change(u.first, -u.second);
+    }
+    for (const auto& u : m_net_ptr->get_product_updates(rd)) {
+      add_change(u.first, u.second);
+    }
+    // Drop the species of which the count does not change (e.g., catalysts)
+    m_net_changes.erase(
+      std::remove_if(m_net_changes.begin() + begin, m_net_changes.end(),
+                     [] (const net_change_t& c) { return c.second == 0; }),
+      m_net_changes.end());
+    m_change_offsets.push_back(m_net_changes.size());
+
+    for (const auto& u : reactants) {
+      auto& hor = m_hor[u.first];
+      auto& hor_stoic = m_hor_stoic[u.first];
+      if ((order > hor) || ((order == hor) && (u.second > hor_stoic))) {
+        hor = order;
+        hor_stoic = u.second;
+      }
+    }
+  }
+
+  m_critical.assign(num_reactions, false);
+  m_firings.assign(num_reactions, static_cast<firing_cnt_t>(0u));
+  m_dirty.assign(num_reactions, false);
+  m_dirty_list.clear();
+  m_dirty_list.reserve(num_reactions);
+  m_delta.assign(num_species, static_cast<cnt_delta_t>(0));
+  m_mu.assign(num_species, static_cast<reaction_rate_t>(0.0));
+  m_sigma2.assign(num_species, static_cast<reaction_rate_t>(0.0));
+}
+
+reaction_rate_t SSA_Tau::get_total_propensity() const
+{
+  const auto& rates = m_net_ptr->reaction_rates();
+  return std::accumulate(rates.cbegin(), rates.cend(),
+                         static_cast<reaction_rate_t>(0.0));
+}
+
+reaction_rate_t SSA_Tau::find_critical_reactions()
+{
+  const auto& rates = m_net_ptr->reaction_rates();
+  const auto& counts = m_net_ptr->species_counts();
+  const auto num_reactions = rates.size();
+  auto a0_critical = static_cast<reaction_rate_t>(0.0);
+
+  for (size_t j = 0ul; j < num_reactions; ++j) {
+    bool critical = false;
+    if (rates[j] > static_cast<reaction_rate_t>(0.0)) {
+      for (auto i = m_change_offsets[j]; i < m_change_offsets[j+1]; ++i) {
+        const auto& c = m_net_changes[i];
+        if (c.second >= 0) continue;
+        const auto num_firings = static_cast<firing_cnt_t>(counts[c.first])
+                               / static_cast<firing_cnt_t>(-c.second);
+        if (num_firings < m_n_critical) {
+          critical = true;
+          break;
+        }
+      }
+    }
+    m_critical[j] = critical;
+    if (critical) {
+      a0_critical += rates[j];
+    }
+  }
+  return a0_critical;
+}
+
+reaction_rate_t SSA_Tau::get_hor_factor(const int hor, const stoic_t stoic,
+                                        const species_cnt_t x)
+{
+  const auto n = static_cast<reaction_rate_t>(x);
+  switch (hor) {
+    case 1:
+      return 1.0;
+    case 2:
+      if ((stoic >= 2) && (x > 1u)) {
+        return 2.0 + 1.0/(n - 1.0);
+      }
+      return 2.0;
+    case 3:
+      if ((stoic == 2) && (x > 1u)) {
+        return 1.5*(2.0 + 1.0/(n - 1.0));
+      }
+      if ((stoic >= 3) && (x > 2u)) {
+        return 3.0 + 1.0/(n - 1.0) + 2.0/(n - 2.0);
+      }
+      return 3.0;
+    default:
+      return static_cast<reaction_rate_t>(hor);
+  }
+}
+
+/**
+ * Select the largest step size such that the expected change and the
+ * standard deviation of the change in the count of every reactant species by
+ * non-critical reactions are bounded by max(epsilon * x / g, 1).
+ */
+sim_time_t SSA_Tau::select_tau()
+{
+  const auto& rates = m_net_ptr->reaction_rates();
+  const auto& counts = m_net_ptr->species_counts();
+  const auto num_reactions = rates.size();
+  const auto num_species = counts.size();
+
+  std::fill(m_mu.begin(), m_mu.end(), static_cast<reaction_rate_t>(0.0));
+  std::fill(m_sigma2.begin(), m_sigma2.end(),
+            static_cast<reaction_rate_t>(0.0));
+
+  for (size_t j = 0ul; j < num_reactions; ++j) {
+    const auto a = rates[j];
+    if (m_critical[j] || (a <= static_cast<reaction_rate_t>(0.0))) continue;
+    for (auto i = m_change_offsets[j]; i < m_change_offsets[j+1]; ++i) {
+      const auto& c = m_net_changes[i];
+      const auto v = static_cast<reaction_rate_t>(c.second);
+      m_mu[c.first] += v * a;
+      m_sigma2[c.first] += v * v * a;
+    }
+  }
+
+  auto tau = std::numeric_limits<sim_time_t>::infinity();
+
+  for (size_t i = 0ul; i < num_species; ++i) {
+    if (m_hor[i] == 0) continue; // not a reactant of any reaction
+    const auto mu = std::abs(m_mu[i]);
+    const auto sigma2 = m_sigma2[i];
+    const auto x = counts[i];
+    const auto g = get_hor_factor(m_hor[i], m_hor_stoic[i], x);
+    const auto bound
+      = std::max(m_epsilon * static_cast<reaction_rate_t>(x) / g, 1.0);
+
+    if (mu > static_cast<reaction_rate_t>(0.0)) {
+      tau = std::min(tau, bound / mu);
+    }
+    if (sigma2 > static_cast<reaction_rate_t>(0.0)) {
+      tau = std::min(tau, bound * bound / sigma2);
+    }
+  }
+
+  return tau;
+}
+
+v_idx_t SSA_Tau::choose_reaction(const reaction_rate_t a0,
+                                          const bool critical_only)
+{
+  const auto& rates = m_net_ptr->reaction_rates();
+  const auto num_reactions = static_cast<v_idx_t>(rates.size());
+  auto rn = static_cast<reaction_rate_t>(m_rgen_evt() * a0);
+  auto chosen = num_reactions;
+
+  for (v_idx_t j = 0u; j < num_reactions; ++j) {
+    if ((rates[j] <= static_cast<reaction_rate_t>(0.0)) ||
+        (critical_only && !m_critical[j])) {
+      continue;
+    }
+    chosen = j;
+    if (rn < rates[j]) break;
+    rn -= rates[j];
+  }
+  // In case of the round-off error, the last eligible one is chosen
+  if (chosen == num_reactions) {
+    WCS_THROW("Failed to choose a reaction to fire");
+  }
+  return chosen;
+}
+
+bool SSA_Tau::leap(const sim_time_t tau, const reaction_rate_t a0_critical,
+                   const bool fire_critical)
+{
+  const auto& rates = m_net_ptr->reaction_rates();
+  const auto& counts = m_net_ptr->species_counts();
+  const auto num_reactions = static_cast<v_idx_t>(rates.size());
+  const auto num_species = counts.size();
+  const auto max_count = Species::get_max_count();
+  // Any mean number of firings larger than this would certainly overflow
+  const auto max_mean = std::min(static_cast<double>(max_count), 1e15);
+
+  const v_idx_t critical = (fire_critical?
+                            choose_reaction(a0_critical, true) : num_reactions);
+
+  std::fill(m_delta.begin(), m_delta.end(), static_cast<cnt_delta_t>(0));
+
+  for (v_idx_t j = 0u; j < num_reactions; ++j) {
+    auto& k = m_firings[j];
+    k = static_cast<firing_cnt_t>(0u);
+
+    if (rates[j] <= static_cast<reaction_rate_t>(0.0)) {
+      continue;
+    } else if (m_critical[j]) {
+      if (j != critical) continue;
+      k = static_cast<firing_cnt_t>(1u);
+    } else {
+      const double mean = rates[j] * tau;
+      if (BOOST_UNLIKELY(mean > max_mean)) {
+        return false;
+      }
+      std::poisson_distribution<firing_cnt_t> poisson(mean);
+      k = m_rgen_leap.draw(poisson);
+      if (k == static_cast<firing_cnt_t>(0u)) continue;
+    }
+
+    for (auto i = m_change_offsets[j]; i < m_change_offsets[j+1]; ++i) {
+      const auto& c = m_net_changes[i];
+      m_delta[c.first] += static_cast<cnt_delta_t>(c.second)
+                        * static_cast<cnt_delta_t>(k);
+    }
+  }
+
+  // Check if every species count remains in the valid range
+  for (size_t i = 0ul; i < num_species; ++i) {
+    const auto d = m_delta[i];
+    const auto amount = static_cast<uint64_t>((d < 0)? -d : d);
+    if (((d < 0) && (static_cast<uint64_t>(counts[i]) < amount)) ||
+        ((d > 0) && (static_cast<uint64_t>(max_count - counts[i]) < amount))) {
+      return false;
+    }
+  }
+
+  // Apply the accumulated updates
+  for (size_t i = 0ul; i < num_species; ++i) {
+    const auto d = m_delta[i];
+    bool ok = true;
+    if (d < 0) {
+      ok = m_net_ptr->dec_species_count(static_cast<v_idx_t>(i),
+                                        static_cast<species_cnt_t>(-d));
+    } else if (d > 0) {
+      ok = m_net_ptr->inc_species_count(static_cast<v_idx_t>(i),
+                                        static_cast<species_cnt_t>(d));
+    }
+    if (BOOST_UNLIKELY(!ok)) {
+      WCS_THROW("Failed to update the count of species " + std::to_string(i));
+    }
+  }
+
+  return true;
+}
+
+void SSA_Tau::mark_affected(const v_idx_t ridx)
+{
+  if (!m_dirty[ridx]) {
+    m_dirty[ridx] = true;
+    m_dirty_list.push_back(ridx);
+  }
+  const auto& reactions = m_net_ptr->reaction_list();
+  for (const auto& vd : m_net_ptr->get_affected_reactions(reactions[ridx])) {
+    const auto i = m_net_ptr->reaction_d2i(vd);
+    if (!m_dirty[i]) {
+      m_dirty[i] = true;
+      m_dirty_list.push_back(i);
+    }
+  }
+}
+
+void SSA_Tau::update_reactions()
+{
+  const auto& reactions = m_net_ptr->reaction_list();
+  // Keep only the feasible reactions in the list to recompute their rates
+  // all at once. check_reaction() zeroes the rate of an infeasible reaction.
+  size_t num_feasible = 0ul;
+  for (const auto ridx : m_dirty_list) {
+    if (m_net_ptr->check_reaction(reactions[ridx])) {
+      m_dirty_list[num_feasible++] = ridx;
+    }
+    m_dirty[ridx] = false;
+  }
+  m_net_ptr->set_reaction_rates(m_dirty_list.data(), num_feasible);
+  m_dirty_list.clear();
+}
+
+Sim_Method::result_t SSA_Tau::step_exact()
+{
+  const auto a0 = get_total_propensity();
+  if (BOOST_UNLIKELY(a0 <= static_cast<reaction_rate_t>(0.0))) {
+    std::cerr << "No more reaction can fire." << std::endl;
+    return Inactive;
+  }
+
+  // Determine when the next reaction to occur
+  const auto dt = -static_cast<sim_time_t>(log(m_rgen_tm())/a0);
+  const auto t = m_sim_time + dt;
+
+  if (BOOST_UNLIKELY((dt >= wcs::Network::get_etime_ulimit()) ||
+                     (t > m_max_time))) {
+    std::cerr << "No more reaction can fire." << std::endl;
+    return Inactive;
+  }
+  ++ m_sim_iter;
+  m_sim_time = t;
+
+  const auto ridx = choose_reaction(a0, false);
+
+  Sim_State_Change digest;
+  digest.m_sim_time = t;
+  digest.m_reaction_fired = m_net_ptr->reaction_list()[ridx];
+
+  // Execute the reaction, updating species counts
+  Sim_Method::fire_reaction(digest);
+
+  // Update the propensities of those reactions fired and affected
+  mark_affected(ridx);
+  update_reactions();
+
+  record(digest.m_reaction_fired);
+
+  return Success;
+}
+
+Sim_Method::result_t SSA_Tau::forward()
+{
+  if (BOOST_UNLIKELY((m_sim_iter >= m_max_iter) ||
+                     (m_sim_time >= m_max_time))) {
+    return Inactive; // do not continue simulation
+  }
+
+  if (m_ssa_steps_left > static_cast<sim_iter_t>(0u)) {
+    -- m_ssa_steps_left;
+    return step_exact();
+  }
+
+  const auto a0 = get_total_propensity();
+  if (BOOST_UNLIKELY(a0 <= static_cast<reaction_rate_t>(0.0))) {
+    std::cerr << "No more reaction can fire." << std::endl;
+    return Inactive;
+  }
+
+  const auto a0_critical = find_critical_reactions();
+  // The smallest step size worth leaping
+  const sim_time_t tau_min = m_ssa_factor / a0;
+  sim_time_t tau_noncritical = select_tau();
+  sim_time_t tau = static_cast<sim_time_t>(0);
+
+  while (true) {
+    if (tau_noncritical < tau_min) {
+      m_ssa_steps_left = m_num_ssa_steps - static_cast<sim_iter_t>(1u);
+      return step_exact();
+    }
+
+    // The time until a critical reaction fires
+    const sim_time_t tau_critical
+      = ((a0_critical > static_cast<reaction_rate_t>(0.0))?
+          -static_cast<sim_time_t>(log(m_rgen_tm())/a0_critical) :
+          std::numeric_limits<sim_time_t>::infinity());
+
+    bool fire_critical = (tau_critical <= tau_noncritical);
+    tau = (fire_critical? tau_critical : tau_noncritical);
+
+    if (m_sim_time + tau > m_max_time) {
+      tau = m_max_time - m_sim_time;
+      fire_critical = false;
+    }
+    if (BOOST_UNLIKELY(!std::isfinite(tau))) {
+      // Nothing bounds the step size. e.g., no reactant changes.
+      m_ssa_steps_left = m_num_ssa_steps - static_cast<sim_iter_t>(1u);
+      return step_exact();
+    }
+
+    if (leap(tau, a0_critical, fire_critical)) {
+      break;
+    }
+    // Retry with a smaller step as some species count went out of range
+    tau_noncritical = tau * 0.5;
+  }
+
+  ++ m_sim_iter;
+  m_sim_time += tau;
+
+  const auto& reactions = m_net_ptr->reaction_list();
+  const auto num_reactions = static_cast<v_idx_t>(reactions.size());
+
+  for (v_idx_t j = 0u; j < num_reactions; ++j) {
+    if (m_firings[j] > static_cast<firing_cnt_t>(0u)) {
+      mark_affected(j);
+    }
+  }
+  update_reactions();
+
+  if (m_recording) {
+    // Every firing in the leap is recorded as an event at the end of the leap
+    for (v_idx_t j = 0u; j < num_reactions; ++j) {
+      for (firing_cnt_t k = 0u; k < m_firings[j]; ++k) {
+        record(m_sim_time, reactions[j]);
+      }
+    }
+  } else if (m_profiling) {
+    // Recording counts the firings one by one. Otherwise, add them at once.
+    for (v_idx_t j = 0u; j < num_reactions; ++j) {
+      m_firing_counts[j] += m_firings[j];
+    }
+  }
+
+  return Success;
+}
+
+
+void SSA_Tau::init(const sim_iter_t max_iter,
+                   const double max_time,
+                   const unsigned rng_seed)
+{
+  if (!m_net_ptr) {
+    WCS_THROW("Invalid pointer to the reaction network.");
+  }
+
+  m_max_time = max_time;
+  m_max_iter = max_iter;
+  m_sim_time = static_cast<sim_time_t>(0);
+  m_sim_iter = static_cast<sim_iter_t>(0u);
+  m_ssa_steps_left = static_cast<sim_iter_t>(0u);
+
+  { // initialize the random number generator
+    if (rng_seed == 0u) {
+      m_rgen_evt.set_seed();
+      m_rgen_tm.set_seed();
+      m_rgen_leap.set_seed();
+    } else {
+      seed_seq_param_t common_param_e
+        = make_seed_seq_input(1, rng_seed, std::string("SSA_Tau"));
+      seed_seq_param_t common_param_t
+        = make_seed_seq_input(2, rng_seed, std::string("SSA_Tau"));
+      seed_seq_param_t common_param_l
+        = make_seed_seq_input(3, rng_seed, std::string("SSA_Tau"));
+
+      std::vector<seed_seq_param_t> unique_params;
+      const size_t num_procs = 1ul;
+      const size_t my_rank = 0ul;
+
+      // make sure to avoid generating any duplicate seed sequence
+      gen_unique_seed_seq_params<rng_t::get_state_size()>(
+          num_procs, common_param_e, unique_params);
+      m_rgen_evt.use_seed_seq(unique_params[my_rank]);
+
+      // make sure to avoid generating any duplicate seed sequence
+      gen_unique_seed_seq_params<rng_t::get_state_size()>(
+          num_procs, common_param_t, unique_params);
+      m_rgen_tm.use_seed_seq(unique_params[my_rank]);
+
+      // make sure to avoid generating any duplicate seed sequence
+      gen_unique_seed_seq_params<rng_t::get_state_size()>(
+          num_procs, common_param_l, unique_params);
+      m_rgen_leap.use_seed_seq(unique_params[my_rank]);
+    }
+
+    m_rgen_evt.param(typename rng_t::param_type(0.0, 1.0));
+    m_rgen_tm.param(typename rng_t::param_type(0.0, 1.0));
+    m_rgen_leap.param(typename rng_t::param_type(0.0, 1.0));
+  }
+
+  Sim_Method::initialize_recording(m_net_ptr);
+
+  build_leap_tables();
+
+  // Leaping relies on the propensity of an infeasible reaction being zero
+  for (const auto& vd : m_net_ptr->reaction_list()) {
+    m_net_ptr->check_reaction(vd);
+  }
+}
+
+
+#if defined(WCS_HAS_ROSS)
+void SSA_Tau::record_first_n(const sim_iter_t num)
+{
+}
+#endif // defined(WCS_HAS_ROSS)
+
+
+std::pair<sim_iter_t, sim_time_t> SSA_Tau::run()
+{
+  while (BOOST_LIKELY(forward() == Success)) {}
+
+  return std::make_pair(m_sim_iter, m_sim_time);
+}
+
+/**@}*/
+} // end of namespace wcs
@@ -0,0 +1,180 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef __WCS_SIM_METHODS_SSA_TAU_HPP__
+#define __WCS_SIM_METHODS_SSA_TAU_HPP__
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "sim_methods/sim_method.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_sim_methods
+ *  @{ */
+
+/**
+ *  Explicit tau-leaping method with the step size selection of Cao, Gillespie
+ *  and Petzold (J. Chem. Phys. 124, 044109, 2006). Each step advances the time
+ *  by a period `tau` chosen such that the relative change in the propensities
+ *  is bounded by `epsilon`, and fires each reaction as many times as drawn
+ *  from the Poisson distribution with the mean of its propensity times `tau`.
+ *  The species updates by all the reactions fired in a step are accumulated
+ *  and applied at once.
+ *
+ *  A reaction that can fire only a few more times before exhausting any of
+ *  its reactants is treated as critical. At most one critical reaction fires
+ *  per leap, and it is chosen as in the direct method, which prevents the
+ *  population from going negative in the common case. If it still happens,
+ *  the step is retried with a half of the step size.
+ *
+ *  When the selected step size is not much larger than the expected time to
+ *  the next reaction, leaping has no benefit. In that case, a number of exact
+ *  SSA steps follow instead.
+ *
+ *  Each leap or exact step counts as one iteration.
+ */
+class SSA_Tau : public Sim_Method {
+public:
+  using rng_t = wcs::RNGen<std::uniform_real_distribution, double>;
+  using v_desc_t = Sim_Method::v_desc_t;
+  /// Type of the number of times a reaction fires in a leap
+  using firing_cnt_t = uint64_t;
+  /// Type of the accumulated change of a species count in a leap
+  using cnt_delta_t = int64_t;
+  /// Net change of a species count by a reaction as the species index and the amount
+  using net_change_t = std::pair<v_idx_t, stoic_t>;
+
+  SSA_Tau(const std::shared_ptr<wcs::Network>& net_ptr);
+  SSA_Tau(SSA_Tau&& other) = default;
+  SSA_Tau& operator=(SSA_Tau&& other) = default;
+  ~SSA_Tau() override;
+
+  /// Set the error control parameter bounding the relative propensity change
+  void set_epsilon(const double eps);
+  double get_epsilon() const;
+
+  /// Initialize the tables of net changes and the orders of reactions
+  void init(const unsigned max_iter,
+            const double max_time,
+            const unsigned rng_seed) override;
+
+  /**
+   * Advance the simulation by either a leap or an exact SSA step.
+   * Check the simulation termination condition at the beginning. If it is not
+   * to be terminated yet, proceed and return Success. Otherwise, return a
+   * failure code.
+   */
+  Sim_Method::result_t forward();
+  /// Main loop of tau-leaping
+  std::pair<unsigned, sim_time_t> run() override;
+
+ #if defined(WCS_HAS_ROSS)
+  /// Tau-leaping is not reversible, and the states are recorded as they occur
+  void record_first_n(const sim_iter_t num) override;
+ #endif // defined(WCS_HAS_ROSS)
+
+  rng_t& rgen_e();
+  rng_t& rgen_t();
+
+protected:
+  void build_leap_tables();
+  /// Return the sum of the propensities of all the reactions
+  reaction_rate_t get_total_propensity() const;
+  /**
+   * Mark the reactions of which the number of firings before exhausting any
+   * reactant is less than m_n_critical, and return the sum of the propensities
+   * of the critical reactions.
+   */
+  reaction_rate_t find_critical_reactions();
+  /// Select the largest step size within the error bound
+  sim_time_t select_tau();
+  /**
+   * Return the denominator `g` of the bound of the relative change in the
+   * count `x` of a species of which the highest order reaction consuming it is
+   * of order `hor` and takes `stoic` of it.
+   */
+  static reaction_rate_t get_hor_factor(const int hor, const stoic_t stoic,
+                                        const species_cnt_t x);
+
+  /**
+   * Leap over the given period drawing the number of firings of non-critical
+   * reactions. If `fire_critical` is set, a critical reaction fires once as
+   * well. Return false without updating the state if any species count would
+   * go out of the range allowed.
+   */
+  bool leap(const sim_time_t tau, const reaction_rate_t a0_critical,
+            const bool fire_critical);
+  /// Choose a reaction to fire with the probability proportional to its rate
+  v_idx_t choose_reaction(const reaction_rate_t a0, const bool critical_only);
+  /// Execute an exact SSA step
+  Sim_Method::result_t step_exact();
+  /// Update the propensities of the reactions fired in the last leap and those affected
+  void update_reactions();
+  void mark_affected(const v_idx_t ridx);
+
+protected:
+  rng_t m_rgen_evt; ///< RNG for events
+  rng_t m_rgen_tm; ///< RNG for event times
+  rng_t m_rgen_leap; ///< RNG for the number of firings in a leap
+
+  /// Error control parameter
+  double m_epsilon;
+  /// Reactions that can fire fewer times than this are critical
+  firing_cnt_t m_n_critical;
+  /**
+   * Execute exact SSA steps instead of leaping if the step size selected
+   * is less than this many times of the expected time to the next reaction.
+   */
+  double m_ssa_factor;
+  /// The number of exact SSA steps to execute when falling back
+  sim_iter_t m_num_ssa_steps;
+  /// The number of remaining exact SSA steps to execute
+  sim_iter_t m_ssa_steps_left;
+
+  /**
+   * Offsets into m_net_changes by the reaction index. The net changes of
+   * species counts by the i-th reaction are in
+   * [m_change_offsets[i], m_change_offsets[i+1]).
+   */
+  std::vector<size_t> m_change_offsets;
+  /// Concatenated lists of the net changes of species counts by each reaction
+  std::vector<net_change_t> m_net_changes;
+  /// The highest order of the reactions consuming each species
+  std::vector<int> m_hor;
+  /// The amount that the highest order reaction takes of each species
+  std::vector<stoic_t> m_hor_stoic;
+
+  /// Whether each reaction is critical in the current step
+  std::vector<bool> m_critical;
+  /// Number of firings of each reaction in the current leap
+  std::vector<firing_cnt_t> m_firings;
+  /// Accumulated change of each species count in the current leap
+  std::vector<cnt_delta_t> m_delta;
+  /// Expected change of each species count per unit time
+  std::vector<reaction_rate_t> m_mu;
+  /// Variance of the change of each species count per unit time
+  std::vector<reaction_rate_t> m_sigma2;
+  /// Whether the propensity of each reaction needs to be recomputed
+  std::vector<bool> m_dirty;
+  /// List of reactions of which the propensities need to be recomputed
+  std::vector<v_idx_t> m_dirty_list;
+};
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_SIM_METHODS_SSA_TAU_HPP__
@@ -10,13 +10,28 @@
 
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
 #include "params/ssa_params.hpp"
 #include "utils/write_graphviz.hpp"
 #include "utils/timer.hpp"
+#include "utils/file.hpp"
+#include "utils/seed.hpp"
+#include "utils/trace_binary.hpp"
+#include "partition/activity_profile.hpp"
 #include "reaction_network/network.hpp"
 #include "sim_methods/ssa_nrm.hpp"
 #include "sim_methods/ssa_direct.hpp"
 #include "sim_methods/ssa_sod.hpp"
+#include "sim_methods/ssa_cr.hpp"
+#include "sim_methods/ssa_tau.hpp"
+#include "sim_methods/ssa_pdm.hpp"
 
 #ifdef WCS_HAS_VTUNE
 __itt_domain* vtune_domain_sim = __itt_domain_create("Simulate");
@@ -24,6 +39,220 @@ __itt_string_handle* vtune_handle_sim = __itt_string_handle_create("simulate");
 #endif // WCS_HAS_VTUNE
 
 
+/**
+ * Create an instance of the simulation method chosen, or return nullptr if
+ * the method is unknown.
+ */
+std::unique_ptr<wcs::Sim_Method>
+create_sim_method(const wcs::SSA_Params& cfg,
+                  const std::shared_ptr<wcs::Network>& rnet_ptr)
+{
+  std::unique_ptr<wcs::Sim_Method> ssa;
+
+  if (cfg.m_method == 0) {
+    ssa = std::make_unique<wcs::SSA_Direct>(rnet_ptr);
+  } else if (cfg.m_method == 1) {
+    ssa = std::make_unique<wcs::SSA_NRM>(rnet_ptr);
+  } else if (cfg.m_method == 2) {
+    ssa = std::make_unique<wcs::SSA_SOD>(rnet_ptr);
+  } else if (cfg.m_method == 3) {
+    ssa = std::make_unique<wcs::SSA_CR>(rnet_ptr);
+  } else if (cfg.m_method == 4) {
+    auto tau_leaping = std::make_unique<wcs::SSA_Tau>(rnet_ptr);
+    tau_leaping->set_epsilon(cfg.m_tau_epsilon);
+    ssa = std::move(tau_leaping);
+  } else if (cfg.m_method == 5) {
+    ssa = std::make_unique<wcs::SSA_PDM>(rnet_ptr);
+  }
+  return ssa;
+}
+
+const char* get_method_description(const int method)
+{
+  static const char* desc[7] = {
+    "Direct SSA method.",
+    "Next Reaction SSA method.",
+    "Sorted optimized direct SSA method.",
+    "Composition-rejection SSA method.",
+    "Tau-leaping method.",
+    "Partial-propensity direct SSA method.",
+    "Unknown SSA method."
+  };
+  return desc[((method < 0) || (method > 5))? 6 : method];
+}
+
+/// Enable tracing or sampling as configured, writing into the given file
+void setup_recording(const wcs::SSA_Params& cfg, wcs::Sim_Method& ssa,
+                     const std::string& outfile, const bool verbose)
+{
+  if (cfg.m_tracing && cfg.m_binary_trace) {
+    ssa.set_tracing<wcs::TraceBinary>(outfile, cfg.m_frag_size);
+    if (verbose) {
+      std::cerr << "Enable tracing in the binary format" << std::endl;
+    }
+  } else if (cfg.m_tracing) {
+    ssa.set_tracing<wcs::TraceSSA>(outfile, cfg.m_frag_size);
+    if (verbose) {
+      std::cerr << "Enable tracing" << std::endl;
+    }
+  } else if (cfg.m_sampling) {
+    if (cfg.m_iter_interval > 0u) {
+      ssa.set_sampling<wcs::SamplesSSA>(cfg.m_iter_interval,
+                                        outfile, cfg.m_frag_size);
+      if (verbose) {
+        std::cerr << "Enable sampling at " << cfg.m_iter_interval
+                  << " steps interval" << std::endl;
+      }
+    } else {
+      ssa.set_sampling<wcs::SamplesSSA>(cfg.m_time_interval,
+                                        outfile, cfg.m_frag_size);
+      if (verbose) {
+        std::cerr << "Enable sampling at " << cfg.m_time_interval
+                  << " secs interval" << std::endl;
+      }
+    }
+  }
+
+  if ((cfg.m_tracing || cfg.m_sampling) && (cfg.m_num_write_buffers > 0u)) {
+    ssa.set_async_recording(cfg.m_num_write_buffers);
+  }
+}
+
+/// Write the recorded trajectory or the final state into the given file
+void write_output(const wcs::SSA_Params& cfg, wcs::Sim_Method& ssa,
+                  const wcs::Network& rnet, const std::string& outfile)
+{
+  if (cfg.m_tracing || cfg.m_sampling) {
+    ssa.finalize_recording();
+  } else {
+    std::ofstream ofs(outfile);
+    ofs << "Species   : " << rnet.show_species_labels("") << std::endl;
+    ofs << "FinalState: " << rnet.show_species_counts() << std::endl;
+  }
+}
+
+/**
+ * Derive a distinct nonzero seed for each replica from the seed given. If the
+ * seed given is zero, a value dependent on the current system clock is used
+ * in its place.
+ */
+bool gen_replica_seeds(const unsigned seed, const size_t num_replicas,
+                       std::vector<unsigned>& seeds)
+{
+  const unsigned master_seed = (seed != 0u)? seed :
+    static_cast<unsigned>(
+      std::chrono::system_clock::now().time_since_epoch().count());
+
+  const wcs::seed_seq_param_t common_param
+    = wcs::make_seed_seq_input(master_seed, std::string("SSA_Ensemble"));
+  std::vector<wcs::seed_seq_param_t> unique_params;
+
+  // A seed of zero is reserved for seeding with the clock, and there can be
+  // at most one among the unique keys. Thus, generate one more than needed.
+  if (!wcs::gen_unique_seed_seq_params<1u>(num_replicas + 1ul,
+                                           common_param, unique_params)) {
+    return false;
+  }
+
+  seeds.clear();
+  seeds.reserve(num_replicas);
+  for (const auto& p : unique_params) {
+    const unsigned s = wcs::compute_key<1u>(p)[0];
+    if (s == 0u) continue;
+    seeds.push_back(s);
+    if (seeds.size() == num_replicas) break;
+  }
+  return true;
+}
+
+/**
+ * Run independent replicas of the simulation on a pool of threads. Each
+ * thread owns a copy of the network, which carries the mutable state of a
+ * simulation, and runs a replica after another, restoring the initial state
+ * of the network in between. The network passed in, which is already loaded,
+ * is used by the first thread. The other threads load their own from the
+ * input file, reusing the library of the reaction rate functions generated
+ * by the first load if any.
+ */
+int run_ensemble(const wcs::SSA_Params& cfg,
+                 const std::shared_ptr<wcs::Network>& rnet_ptr)
+{
+  const size_t num_replicas = static_cast<size_t>(cfg.m_num_replicas);
+  const size_t num_hw_threads
+    = std::max(static_cast<size_t>(std::thread::hardware_concurrency()), 1ul);
+  const size_t num_threads
+    = std::min(((cfg.m_num_threads == 0u)? num_hw_threads :
+                static_cast<size_t>(cfg.m_num_threads)), num_replicas);
+
+  std::vector<unsigned> seeds;
+  if (!gen_replica_seeds(cfg.m_seed, num_replicas, seeds)) {
+    std::cerr << "Failed to generate unique seeds for "
+              << num_replicas << " replicas." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cerr << get_method_description(cfg.m_method) << std::endl;
+  std::cerr << "Running " << num_replicas << " replicas on "
+            << num_threads << " threads." << std::endl;
+
+  std::atomic<size_t> next_replica{0ul};
+  std::vector<int> rcs(num_threads, EXIT_SUCCESS);
+  std::mutex err_mtx;
+
+  auto worker = [&](const size_t tid) {
+    size_t replica = num_replicas;
+    try {
+      std::shared_ptr<wcs::Network> net_ptr = rnet_ptr;
+      if (tid > 0ul) {
+        net_ptr = std::make_shared<wcs::Network>();
+        net_ptr->load(cfg.m_infile);
+        net_ptr->init();
+      }
+      const std::vector<wcs::species_cnt_t> initial_counts
+        = net_ptr->species_counts();
+      bool is_initial = true;
+
+      while ((replica = next_replica++) < num_replicas) {
+        if (!is_initial) {
+          net_ptr->reset_species_counts(initial_counts);
+        }
+        is_initial = false;
+
+        const std::string outfile
+          = wcs::append_to_stem(cfg.get_outfile(),
+                                ".r" + std::to_string(replica));
+        auto ssa = create_sim_method(cfg, net_ptr);
+        setup_recording(cfg, *ssa, outfile, false);
+        ssa->init(cfg.m_max_iter, cfg.m_max_time, seeds[replica]);
+        ssa->run();
+        write_output(cfg, *ssa, *net_ptr, outfile);
+      }
+    } catch (const std::exception& e) {
+      std::lock_guard<std::mutex> lock(err_mtx);
+      std::cerr << "Thread " << tid;
+      if (replica < num_replicas) {
+        std::cerr << " failed on replica " << replica;
+      }
+      std::cerr << ": " << e.what() << std::endl;
+      rcs[tid] = EXIT_FAILURE;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1ul);
+  for (size_t tid = 1ul; tid < num_threads; ++tid) {
+    threads.emplace_back(worker, tid);
+  }
+  worker(0ul);
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  return (std::all_of(rcs.cbegin(), rcs.cend(),
+                      [](const int rc) { return rc == EXIT_SUCCESS; })?
+          EXIT_SUCCESS : EXIT_FAILURE);
+}
+
 int main(int argc, char** argv)
 {
  #ifdef WCS_HAS_VTUNE
@@ -46,44 +275,56 @@ int main(int argc, char** argv)
     rc = EXIT_FAILURE;
   }
 
-  wcs::Sim_Method* ssa = nullptr;
+  if ((cfg.m_method < 0) || (cfg.m_method > 5)) {
+    std::cerr << "Unknown SSA method (" << cfg.m_method << ')' << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (cfg.m_num_replicas > 1u) {
+    double t_start = wcs::get_time();
+    const int rc_ensemble = run_ensemble(cfg, rnet_ptr);
+    std::cout << "Wall clock time to run ensemble: "
+              << wcs::get_time() - t_start << " (sec)" << std::endl;
+    return ((rc == EXIT_SUCCESS)? rc_ensemble : rc);
+  }
+
+  std::unique_ptr<wcs::Sim_Method> ssa;
 
   try {
-    if (cfg.m_method == 0) {
-      ssa = new wcs::SSA_Direct(rnet_ptr);
-      std::cerr << "Direct SSA method." << std::endl;
-    } else if (cfg.m_method == 1) {
-      std::cerr << "Next Reaction SSA method." << std::endl;
-      ssa = new wcs::SSA_NRM(rnet_ptr);
-    } else if (cfg.m_method == 2) {
-      std::cerr << "Sorted optimized direct SSA method." << std::endl;
-      ssa = new wcs::SSA_SOD(rnet_ptr);
-    } else {
-      std::cerr << "Unknown SSA method (" << cfg.m_method << ')' << std::endl;
-      return EXIT_FAILURE;
-    }
+    std::cerr << get_method_description(cfg.m_method) << std::endl;
+    ssa = create_sim_method(cfg, rnet_ptr);
   } catch (const std::exception& e) {
     std::cerr << "Fail to setup SSA method." << std::endl;
     return EXIT_FAILURE;
   }
 
-  if (cfg.m_tracing) {
-    ssa->set_tracing<wcs::TraceSSA>(cfg.get_outfile(), cfg.m_frag_size);
-    std::cerr << "Enable tracing" << std::endl;
-  } else if (cfg.m_sampling) {
-    if (cfg.m_iter_interval > 0u) {
-      ssa->set_sampling<wcs::SamplesSSA>(cfg.m_iter_interval,
-                                         cfg.get_outfile(), cfg.m_frag_size);
-      std::cerr << "Enable sampling at " << cfg.m_iter_interval
-                << " steps interval" << std::endl;
-    } else {
-      ssa->set_sampling<wcs::SamplesSSA>(cfg.m_time_interval,
-                                         cfg.get_outfile(), cfg.m_frag_size);
-      std::cerr << "Enable sampling at " << cfg.m_time_interval
-                << " secs interval" << std::endl;
+  if ((cfg.is_checkpointing() || !cfg.m_resume_file.empty()) &&
+      ((cfg.m_method < 0) || (cfg.m_method > 2))) {
+    std::cerr << "Checkpointing is not supported by "
+              << get_method_description(cfg.m_method) << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  setup_recording(cfg, *ssa, cfg.get_outfile(), true);
+  if (!cfg.m_profile_file.empty()) {
+    ssa->set_profiling();
+  }
+  try {
+    ssa->init(cfg.m_max_iter, cfg.m_max_time, cfg.m_seed);
+    if (!cfg.m_resume_file.empty()) {
+      ssa->load_checkpoint(cfg.m_resume_file);
+      std::cerr << "Resume from " << cfg.m_resume_file << " at iteration "
+                << ssa->get_sim_iter() << " (time "
+                << ssa->get_sim_time() << ")" << std::endl;
     }
+    if (cfg.is_checkpointing()) {
+      ssa->set_checkpointing(cfg.m_ckpt_file, cfg.m_ckpt_iter_interval,
+                             cfg.m_ckpt_wall_interval);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
   }
-  ssa->init(cfg.m_max_iter, cfg.m_max_time, cfg.m_seed);
 
  #ifdef WCS_HAS_VTUNE
   __itt_resume();
@@ -100,16 +341,18 @@ int main(int argc, char** argv)
   __itt_pause();
  #endif // WCS_HAS_VTUNE
 
-  if (cfg.m_tracing || cfg.m_sampling) {
-    ssa->finalize_recording();
-  } else {
-    std::string ofile = cfg.get_outfile();
-    std::ofstream ofs(ofile);
-    ofs << "Species   : " << rnet.show_species_labels("") << std::endl;
-    ofs << "FinalState: " << rnet.show_species_counts() << std::endl;
-  }
+  write_output(cfg, *ssa, rnet, cfg.get_outfile());
 
-  delete ssa;
+  if (ssa->is_profiling()) {
+    try {
+      wcs::Activity_Profile profile;
+      profile.set(rnet, ssa->get_firing_counts());
+      profile.write(cfg.m_profile_file);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
 
   return rc;
 }
@@ -46,6 +46,13 @@ struct WCS_Shared_State {
   wcs::sim_iter_t m_max_iter; ///< maximum simulation steps
   int m_nparts;
   int m_num_inner_threads;
+  /**
+   * Reaction network shared by every partition. It holds a single copy of
+   * the topology, the rate functions, the species counts and the reaction
+   * rates. A species count is updated only by the thread that fires the
+   * reaction, and a reaction rate only by the thread of its partition.
+   */
+  std::shared_ptr<wcs::Network> m_net_ptr;
 
   void set_num_partitions(int np);
 };
@@ -77,11 +84,23 @@ struct WCS_LP_State
 {
   /// Pointer to an ssa object
   std::unique_ptr<wcs::SSA_NRM> m_ssa_ptr;
-  /// Pointer to the reaction network
+  /// Pointer to the reaction network shared by every partition
   std::shared_ptr<wcs::Network> m_net_ptr;
   /// Simulation start time (wall clock)
   double m_t_start;
 
+  /// Id of the partition of this thread
+  wcs::partition_id_t m_pid;
+  /// Reactions that belong to this partition
+  wcs::Network::reaction_list_t m_reactions;
+  /**
+   * The reactions of this partition affected by firing each reaction, in the
+   * compressed sparse row format indexed by the reaction index. This is the
+   * part of the dependency graph of the shared network for this partition.
+   */
+  std::vector<size_t> m_dep_offsets;
+  std::vector<wcs::Network::v_desc_t> m_dep_reactions;
+
   WCS_LP_State(std::unique_ptr<wcs::SSA_NRM>&& ssa_ptr,
                std::shared_ptr<wcs::Network>& net_ptr);
 
@@ -89,13 +108,61 @@ struct WCS_LP_State
   WCS_LP_State(WCS_LP_State&& other) = default;
   WCS_LP_State& operator=(WCS_LP_State&& other) = default;
 
+  /**
+   * Collect the reactions of the given partition and their dependencies out
+   * of the shared network of which the partition has been set.
+   */
+  void set_partition(const wcs::partition_id_t pid);
+  /// Return the reactions of this partition affected by the given reaction
+  wcs::Network::affected_reactions_t
+    get_affected_reactions(const wcs::Network::v_desc_t rd) const;
+
 };
 
 WCS_LP_State::WCS_LP_State(std::unique_ptr<wcs::SSA_NRM>&& ssa_ptr,
                            std::shared_ptr<wcs::Network>& net_ptr)
-: m_ssa_ptr(std::move(ssa_ptr)), m_net_ptr(net_ptr), m_t_start(0.0)
+: m_ssa_ptr(std::move(ssa_ptr)), m_net_ptr(net_ptr), m_t_start(0.0),
+  m_pid(wcs::unassigned_partition)
 {}
 
+void WCS_LP_State::set_partition(const wcs::partition_id_t pid)
+{
+  const wcs::Network& net = *m_net_ptr;
+  const wcs::Network::graph_t& g = net.graph();
+  m_pid = pid;
+
+  m_reactions.clear();
+  for (const auto rd : net.reaction_list()) {
+    if (g[rd].get_partition() == pid) {
+      m_reactions.push_back(rd);
+    }
+  }
+
+  const size_t num_reactions = net.get_num_reactions();
+  m_dep_offsets.assign(1ul, 0ul);
+  m_dep_offsets.reserve(num_reactions + 1ul);
+  m_dep_reactions.clear();
+
+  for (size_t ridx = 0ul; ridx < num_reactions; ++ridx) {
+    const auto rd = net.reaction_i2d(static_cast<wcs::v_idx_t>(ridx));
+    for (const auto rd_affected : net.get_affected_reactions(rd)) {
+      if (g[rd_affected].get_partition() == pid) {
+        m_dep_reactions.push_back(rd_affected);
+      }
+    }
+    m_dep_offsets.push_back(m_dep_reactions.size());
+  }
+}
+
+wcs::Network::affected_reactions_t
+WCS_LP_State::get_affected_reactions(const wcs::Network::v_desc_t rd) const
+{
+  const auto ridx = m_net_ptr->reaction_d2i(rd);
+  return wcs::Network::affected_reactions_t(
+           m_dep_reactions.data() + m_dep_offsets[ridx],
+           m_dep_reactions.data() + m_dep_offsets[ridx + 1ul]);
+}
+
 #if defined(_OPENMP) && defined(WCS_OMP_RUN_PARTITION)
 namespace {
 /// Thread-local variable, file-visible only.
@@ -229,6 +296,12 @@ void wcs_init(const wcs::SSA_Params& cfg, const partition_idx_t& parts)
   shared_state.m_max_time = cfg.m_max_time;
   shared_state.m_max_iter = cfg.m_max_iter;
 
+  // Load the network only once to share among the threads
+  shared_state.m_net_ptr = std::make_shared<wcs::Network>();
+  shared_state.m_net_ptr->load(cfg.m_infile, true);
+  shared_state.m_net_ptr->init();
+  shared_state.m_net_ptr->set_partition(parts);
+
  #if OMP_DEBUG
   std::vector<wcs::my_omp_affinity> omp_aff(shared_state.m_nparts);
  #endif // OMP_DEBUG
@@ -243,16 +316,13 @@ void wcs_init(const wcs::SSA_Params& cfg, const partition_idx_t& parts)
     auto& ssa_ptr = lp_state.m_ssa_ptr;
     auto& net_ptr = lp_state.m_net_ptr;
 
-    net_ptr = std::make_shared<wcs::Network>();
-    wcs::Network& net = *net_ptr;
-
-    net.load(cfg.m_infile, true);
-    net.init();
-    net.set_partition(parts, tid);
+    net_ptr = shared_state.m_net_ptr;
+    lp_state.set_partition(static_cast<wcs::partition_id_t>(tid));
 
     ssa_ptr = std::make_unique<wcs::SSA_NRM>(net_ptr);
     wcs::SSA_NRM& ssa = *ssa_ptr;
     ssa.set_num_threads(shared_state.m_num_inner_threads);
+    ssa.set_local_reactions(&lp_state.m_reactions);
 
     #pragma omp master
     {
@@ -389,16 +459,23 @@ bool forward(const nrm_evt_t& evt_earliest)
     // Depdending on whether the firing reaction is local or not,
     // the processing of the reaction is different.
     const bool local = (net.graph()[firing.second].get_partition() ==
-                        omp_get_thread_num());
-    // Execute the reaction, updating species counts
-    // Only returns the affected reactions that are local
-    ssa.fire_reaction(digest);
+                        lp_state.m_pid);
+    // Execute the reaction, updating the species counts of the shared
+    // network once by the thread of the partition of the reaction.
+    if (local) {
+      ssa.fire_reaction(digest);
+    }
+    // Every thread reads the updated counts
+    #pragma omp barrier
+
+    // Only the affected reactions that are local
+    const auto affected = lp_state.get_affected_reactions(firing.second);
     if (local) {
       // Update the propensities and times of all local reactions that are fired and affected
-      ssa.update_reactions(firing, digest.m_reactions_affected, digest.m_reaction_times);
+      ssa.update_reactions(firing, affected, digest.m_reaction_times);
     } else {
       // This does not update the reaction fired which is not local.
-      ssa.update_reactions(firing.first, digest.m_reactions_affected, digest.m_reaction_times);
+      ssa.update_reactions(firing.first, affected, digest.m_reaction_times);
     }
 
     #pragma omp master
@@ -0,0 +1,107 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <algorithm>
+#include "utils/fragment_writer.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_utils
+ *  @{ */
+
+FragmentWriter::FragmentWriter(const unsigned num_buffers)
+: m_max_pending(std::max(num_buffers, 2u) - 1u),
+  m_num_pending(0u),
+  m_stop(false)
+{
+  m_thread = std::thread(&FragmentWriter::run, this);
+}
+
+FragmentWriter::~FragmentWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv_job.notify_one();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void FragmentWriter::submit(job_t&& job)
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv_done.wait(lock, [this] { return (m_num_pending < m_max_pending); });
+    rethrow_error();
+    m_jobs.emplace_back(std::move(job));
+    m_num_pending ++;
+  }
+  m_cv_job.notify_one();
+}
+
+void FragmentWriter::wait()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cv_done.wait(lock, [this] { return (m_num_pending == 0u); });
+  rethrow_error();
+}
+
+/// Must be called while holding the lock
+void FragmentWriter::rethrow_error()
+{
+  if (m_error) {
+    auto e = m_error;
+    m_error = nullptr;
+    std::rethrow_exception(e);
+  }
+}
+
+void FragmentWriter::run()
+{
+  while (true) {
+    job_t job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv_job.wait(lock, [this] { return (m_stop || !m_jobs.empty()); });
+      if (m_jobs.empty()) { // stop only after draining the queue
+        break;
+      }
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+
+    std::exception_ptr error;
+    try {
+      job();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    job = nullptr; // release the buffer before signaling the completion
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (error && !m_error) {
+        m_error = error;
+      }
+      m_num_pending --;
+    }
+    m_cv_done.notify_all();
+  }
+}
+
+/**@}*/
+} // end of namespace wcs
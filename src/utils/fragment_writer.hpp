@@ -0,0 +1,81 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef __WCS_UTILS_FRAGMENT_WRITER_HPP__
+#define __WCS_UTILS_FRAGMENT_WRITER_HPP__
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace wcs {
+/** \addtogroup wcs_utils
+ *  @{ */
+
+/**
+ * Background writer of trajectory fragments. The simulation thread hands
+ * off a job that owns a full fragment buffer, and a dedicated I/O thread
+ * serializes it into a file while the simulation continues with a new buffer.
+ *
+ * The memory is bounded by the number of buffers given at construction. One
+ * of them is the buffer being filled by the simulation, and the rest may be
+ * waiting or being written. When all of them are in flight, `submit()` blocks
+ * until the oldest one is done, which throttles the simulation down to the
+ * speed of the disk. Thus, two buffers give double buffering and three give
+ * triple buffering.
+ *
+ * An exception thrown by a job is kept, and rethrown in the simulation thread
+ * by the next call to `submit()` or `wait()`.
+ */
+class FragmentWriter {
+ public:
+  using job_t = std::function<void()>;
+
+  /// Construct with the total number of fragment buffers, which is at least 2
+  FragmentWriter(const unsigned num_buffers = 2u);
+  FragmentWriter(const FragmentWriter& other) = delete;
+  FragmentWriter& operator=(const FragmentWriter& other) = delete;
+  /// Write the jobs still pending and join the I/O thread
+  ~FragmentWriter();
+
+  /// Queue a job, blocking while all the buffers are in flight
+  void submit(job_t&& job);
+  /// Block until every job submitted so far completes
+  void wait();
+
+  unsigned get_num_buffers() const { return m_max_pending + 1u; }
+
+ protected:
+  void run();
+  void rethrow_error();
+
+ protected:
+  /// The maximum number of jobs waiting or being written
+  unsigned m_max_pending;
+  /// The number of jobs waiting or being written
+  unsigned m_num_pending;
+  bool m_stop;
+  std::deque<job_t> m_jobs;
+  std::exception_ptr m_error;
+
+  std::mutex m_mutex;
+  /// Signaled upon a new job or the stop request
+  std::condition_variable m_cv_job;
+  /// Signaled upon the completion of a job
+  std::condition_variable m_cv_done;
+  std::thread m_thread;
+};
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_UTILS_FRAGMENT_WRITER_HPP__
@@ -26,12 +26,17 @@
 #include <cstring> // strncpy
 #include <fcntl.h> // O_CREAT
 #include <unistd.h> // close
+#include <sys/file.h> // flock
+#include <sys/stat.h> // mkdir
 #include <sys/wait.h> // WEXITSTATUS
 #include <set>
 #include <regex>
 #include <string>
 #include "wcs_types.hpp"
 #include <thread> // std::thread::hardware_concurrency
+#if defined(_OPENMP)
+#include <omp.h>
+#endif // defined(_OPENMP)
 
 #if defined(WCS_HAS_SBML)
 
@@ -54,6 +59,10 @@ template<>
 const char* generate_cxx_code::basetype_to_string<double>::value = "double";
 template<>
 const char* generate_cxx_code::basetype_to_string<float>::value = "float";
+template<>
+const char* generate_cxx_code::basetype_to_string<unsigned int>::value = "unsigned int";
+template<>
+const char* generate_cxx_code::basetype_to_string<uint64_t>::value = "uint64_t";
 typedef reaction_rate_t ( * rate_function_pointer)(const std::vector<reaction_rate_t>&);
 
 void
@@ -1047,10 +1056,14 @@ void generate_cxx_code::print_reaction_rates(
   const std::unordered_set<std::string>& wcs_all_var,
   wcs::params_map_t& dep_params_f,
   wcs::params_map_t& dep_params_nf,
-  const rate_rules_dep_t& rate_rules_dep_map)
+  const rate_rules_dep_t& rate_rules_dep_map,
+  const bool batched,
+  const unsigned int chunk_id)
 {
   const char* Real = generate_cxx_code::basetype_to_string<reaction_rate_t>::value;
   const std::string zero = std::string("static_cast<") + Real + ">(0)";
+  // The id and the number of inputs of each reaction for the batched kernels
+  std::vector<std::pair<std::string, unsigned int>> rates;
   const ListOfReactions* reaction_list = model.getListOfReactions();
   const unsigned int num_reactions = reaction_list->size();
   typename assignment_rules_t::const_iterator arit;
@@ -1072,8 +1085,15 @@ void generate_cxx_code::print_reaction_rates(
       = reaction.getKineticLaw()->getListOfLocalParameters();
     unsigned int num_localparameters = local_parameter_list->size();
 
-    genfile << "extern \"C\" " << Real << " wcs__rate_" << reaction.getIdAttribute()
-              << "(const std::vector<" << Real <<">& __input) {\n";
+    if (batched) {
+      // The body is shared by the function of the reaction and the kernels
+      genfile << "static inline " << Real << " wcs__rate_body_"
+              << reaction.getIdAttribute() << "(const " << Real
+              << "* __input) {\n";
+    } else {
+      genfile << "extern \"C\" " << Real << " wcs__rate_" << reaction.getIdAttribute()
+                << "(const std::vector<" << Real <<">& __input) {\n";
+    }
 
     //print reaction's local parameters
     using reaction_local_parameters_t = std::unordered_set<std::string>;
@@ -1291,7 +1311,104 @@ void generate_cxx_code::print_reaction_rates(
     //        << reaction.getIdAttribute() << ");\n";
     genfile << "  return " << reaction.getIdAttribute() << ";\n";
     genfile << "}\n\n";
+
+    if (batched) {
+      genfile << "extern \"C\" " << Real << " wcs__rate_" << reaction.getIdAttribute()
+              << "(const std::vector<" << Real <<">& __input) {\n"
+              << "  return wcs__rate_body_" << reaction.getIdAttribute()
+              << "(__input.data());\n"
+              << "}\n\n";
+      rates.emplace_back(reaction.getIdAttribute(),
+                         static_cast<unsigned int>(par_index));
+    }
+  }
+
+  if (batched) {
+    print_batched_rate_kernels(genfile, rid_start, chunk_id, rates);
+  }
+}
+
+/**
+ *  Write two kernels for the chunk of reactions of which the function bodies
+ *  have been written into the same translation unit such that they can be
+ *  inlined. Both read the species counts from the dense array of the network
+ *  via its table of the rate inputs, and write the rates into the dense array
+ *  of reaction rates, both indexed by the reaction index. The reaction index
+ *  is the same as the order of the reaction in the SBML model.
+ *  - `wcs__rates_chunk_<k>` evaluates every reaction in the k-th chunk in the
+ *    straight-line code without any branch between reactions. The bodies of
+ *    the reactions in a similar form, such as those of the mass-action
+ *    kinetics, end up adjacent to each other, which the compiler can vectorize
+ *    across.
+ *  - `wcs__rates_list_<k>` evaluates the reactions in the given list of the
+ *    reaction indices which must all belong to the k-th chunk.
+ *  A negative rate is clamped to zero as done in Reaction::eval_rate().
+ */
+void generate_cxx_code::print_batched_rate_kernels(
+  std::ostream & genfile,
+  const unsigned int rid_start,
+  const unsigned int chunk_id,
+  const std::vector<std::pair<std::string, unsigned int>>& rates)
+{
+  const char* Real = generate_cxx_code::basetype_to_string<reaction_rate_t>::value;
+  const std::string zero = std::string("static_cast<") + Real + ">(0)";
+  const std::string params
+    = std::string("const species_cnt_t* __counts, ")
+    + "const v_idx_t* __input_idx, const size_t* __input_offsets";
+
+  unsigned int max_inputs = 1u;
+  for (const auto& r : rates) {
+    max_inputs = std::max(max_inputs, r.second);
   }
+
+  auto print_gather = [&](const unsigned int num_inputs,
+                          const std::string& indent) {
+    for (unsigned int i = 0u; i < num_inputs; ++i) {
+      genfile << indent << "__in[" << i << "] = static_cast<" << Real
+              << ">(__counts[__idx[" << i << "]]);\n";
+    }
+  };
+
+  genfile << "//Define the batched kernels of the chunk\n";
+  genfile << "extern \"C\" void wcs__rates_chunk_" << chunk_id << "("
+          << params << ", " << Real << "* __rates) {\n"
+          << "  " << Real << " __in[" << max_inputs << "];\n";
+  for (unsigned int j = 0u; j < rates.size(); ++j) {
+    const unsigned int ridx = rid_start + j;
+    genfile << "  {\n"
+            << "    const v_idx_t* const __idx = __input_idx + __input_offsets["
+            << ridx << "];\n";
+    print_gather(rates[j].second, "    ");
+    genfile << "    const " << Real << " __r = wcs__rate_body_"
+            << rates[j].first << "(__in);\n"
+            << "    __rates[" << ridx << "] = (__r < " << zero << ")? "
+            << zero << " : __r;\n"
+            << "  }\n";
+  }
+  genfile << "}\n\n";
+
+  genfile << "extern \"C\" void wcs__rates_list_" << chunk_id << "("
+          << params << ", const v_idx_t* __ridx, const size_t __n, "
+          << Real << "* __rates) {\n"
+          << "  " << Real << " __in[" << max_inputs << "];\n"
+          << "  for (size_t __j = 0ul; __j < __n; ++__j) {\n"
+          << "    const v_idx_t __r = __ridx[__j];\n"
+          << "    const v_idx_t* const __idx = __input_idx + __input_offsets[__r];\n"
+          << "    " << Real << " __v = " << zero << ";\n"
+          << "    switch (__r) {\n";
+  for (unsigned int j = 0u; j < rates.size(); ++j) {
+    genfile << "      case " << rid_start + j << ":\n";
+    print_gather(rates[j].second, "        ");
+    genfile << "        __v = wcs__rate_body_" << rates[j].first << "(__in);\n"
+            << "        break;\n";
+  }
+  genfile << "      default:\n"
+          << "        WCS_THROW(\"Reaction index \" + std::to_string(__r) + "
+          << "\" is not in the chunk " << chunk_id << ".\");\n"
+          << "    }\n"
+          << "    __rates[__r] = (__v < " << zero << ")? " << zero << " : __v;\n"
+          << "  }\n"
+          << "}\n\n";
 }
 
 
@@ -1308,7 +1425,7 @@ void generate_cxx_code::print_reaction_rates(
  *  By default, it is on. To avoid generating a single translation unit that
  *  is extreme large, we limit the number of reactions that are written
  *  into a single file by specifying chunk_size. By default, it is set to
- *  1000.
+ *  0, with which the size is chosen adaptively by choose_chunk_size().
  */
 generate_cxx_code::generate_cxx_code(const std::string& libpath,
                                      bool regen, bool save_log, bool cleanup,
@@ -1317,7 +1434,13 @@ generate_cxx_code::generate_cxx_code(const std::string& libpath,
                                      unsigned int num_compiling_threads)
 : m_lib_filename(libpath), m_regen(regen), m_save_log(save_log),
   m_cleanup(cleanup), m_tmp_dir(tmp_dir), m_chunk(chunk_size),
-  m_num_compiling_threads(num_compiling_threads)
+  m_num_compiling_threads(num_compiling_threads),
+ #if defined(WCS_JIT_BATCH_RATES)
+  m_batched(true),
+ #else
+  m_batched(false),
+ #endif // defined(WCS_JIT_BATCH_RATES)
+  m_use_cache(false), m_cache_lookup(false)
 {
   m_regen = m_regen || !check_if_file_exists(m_lib_filename);
 
@@ -1347,6 +1470,22 @@ generate_cxx_code::generate_cxx_code(const std::string& libpath,
      }
   }
 
+  m_cache_dir = get_cache_dir();
+  m_use_cache = !m_cache_dir.empty();
+ #if defined(_OPENMP)
+  // With a partitioned network, each thread has its own generator of which
+  // only the master writes the source files. Then, the threads cannot agree
+  // on the key that depends on the content of the files.
+  m_use_cache = m_use_cache && !omp_in_parallel();
+ #endif // defined(_OPENMP)
+
+  if (m_use_cache) {
+    setup_cache(regen);
+    std::cerr << "Looking up the machine code for reaction rate formula in "
+              + m_cache_dir << std::endl;
+    return;
+  }
+
  #if defined(_OPENMP)
   #pragma omp master
  #endif // defined(_OPENMP)
@@ -1401,11 +1540,19 @@ const nullstream &operator<<(nullstream &&os, const T&) {
   return os;
 }
 
-void generate_cxx_code::create_ostream(src_file_t& ofile, size_t suffix_size)
+void generate_cxx_code::create_ostream(src_file_t& ofile, size_t suffix_size,
+                                       const bool unique)
 {
   std::string& src_name = ofile.first;
   std::unique_ptr<std::ostream>& os_ptr = ofile.second;
 
+  if (!unique) {
+    os_ptr = std::make_unique<std::ofstream>(src_name);
+    if (!os_ptr || !(*os_ptr)) {
+      WCS_THROW("\n Failed to open a source file " + src_name);
+    }
+    return;
+  }
 
   char tmp_filename[PATH_MAX+1] = {'\0'};
   strncpy(tmp_filename, src_name.c_str(), PATH_MAX);
@@ -1443,7 +1590,7 @@ void generate_cxx_code::open_ostream(const unsigned int num_reactions)
  #endif
 
   if (m_chunk == 0u) {
-    m_chunk = 3000u;
+    WCS_THROW("The number of reactions per source file is not set.");
   }
   size_t num_reaction_files = (num_reactions + m_chunk - 1) / m_chunk;
   m_ostreams.resize(num_reaction_files + 3);
@@ -1475,17 +1622,22 @@ void generate_cxx_code::open_ostream(const unsigned int num_reactions)
 
       const std::string hdr_suffix = ".hpp";
       const std::string src_suffix = ".cpp";
-      m_ostreams[0].first = m_tmp_dir + "/Makefile_XXXXXX";
-      m_ostreams[1].first = m_tmp_dir + "/" + stem + "_XXXXXX" + hdr_suffix;
-      m_ostreams[2].first = m_tmp_dir + "/" + stem + "_XXXXXX" + src_suffix;
-      create_ostream(m_ostreams[0], 0);
-      create_ostream(m_ostreams[1], hdr_suffix.length());
-      create_ostream(m_ostreams[2], src_suffix.length());
+      // The staging directory of the cache is private to this object. There,
+      // file names are kept fixed such that the generated code that includes
+      // the header by name does not vary between runs.
+      const bool unique = !m_use_cache;
+      const std::string tag = (unique? "_XXXXXX" : "");
+      m_ostreams[0].first = m_tmp_dir + "/Makefile" + tag;
+      m_ostreams[1].first = m_tmp_dir + "/" + stem + tag + hdr_suffix;
+      m_ostreams[2].first = m_tmp_dir + "/" + stem + tag + src_suffix;
+      create_ostream(m_ostreams[0], 0, unique);
+      create_ostream(m_ostreams[1], hdr_suffix.length(), unique);
+      create_ostream(m_ostreams[2], src_suffix.length(), unique);
 
       for (unsigned i = 0u, j = 0u; i < num_reactions; i += m_chunk, j++) {
         m_ostreams[j+3].first = m_tmp_dir + "/" + stem + '_' + std::to_string(j)
-                              + "_XXXXXX" + src_suffix;
-        create_ostream(m_ostreams[j+3], src_suffix.size());
+                              + tag + src_suffix;
+        create_ostream(m_ostreams[j+3], src_suffix.size(), unique);
       }
     }
    #if defined(_OPENMP)
@@ -1671,6 +1823,8 @@ void generate_cxx_code::write_header(
             << "#include <vector>\n"
             << "#include <cmath>\n"
             << "#include <cstdio>\n"
+            << "#include <cstddef>\n"
+            << "#include <cstdint>\n"
             << "#include <string>\n"
             << "#include <math.h>\n"
             << "#include <iostream>\n"
@@ -1683,6 +1837,10 @@ void generate_cxx_code::write_header(
             << "//Get the correct floating point type from the code at runtime.\n"
             << "typedef " << Real << " reaction_rate_t;\n"
             //<< "typedef reaction_rate_t " << Real << ";\n\n"
+            << "//Types of the dense arrays of the network for batched kernels.\n"
+            << "typedef " << basetype_to_string<species_cnt_t>::value
+            << " species_cnt_t;\n"
+            << "typedef " << basetype_to_string<v_idx_t>::value << " v_idx_t;\n\n"
             << "//Prototype all the functions\n";
 
   for (unsigned int ic = 0u; ic < num_functions; ic++) {
@@ -1779,13 +1937,28 @@ void generate_cxx_code::generate_code(
     model_reactions_map, rate_rules_map, model_species, ev_assign);
 
 
+  choose_chunk_size(model, num_reactions);
   open_ostream(num_reactions);
   std::ostream& os_header = *(m_ostreams[1].second);
   std::ostream& os_common_impl = *(m_ostreams[2].second);
+  // Refer to the header by a name relative to the source files when caching
+  // as the key depends on the content of the source files.
+  const std::string header_name
+    = (m_use_cache? get_subpath(m_tmp_dir, m_ostreams[1].first)
+                  : m_ostreams[1].first);
 
 
   write_header(model, os_header);
-  write_common_impl(model, m_ostreams[1].first, os_common_impl);
+  write_common_impl(model, header_name, os_common_impl);
+  if (m_batched) {
+    // Let the loader find the kernels of each chunk
+    const unsigned int num_chunks = (num_reactions + m_chunk - 1u) / m_chunk;
+    os_common_impl << "\n//Describe the batched rate kernels\n"
+                   << "extern \"C\" const unsigned int wcs__rates_chunk_size = "
+                   << m_chunk << "u;\n"
+                   << "extern \"C\" const unsigned int wcs__rates_num_chunks = "
+                   << num_chunks << "u;\n";
+  }
 
   //  A map for constants in initial assignments
   constant_init_ass_t sconstant_init_assig;
@@ -1828,11 +2001,11 @@ void generate_cxx_code::generate_code(
     const unsigned int rid_end = std::min(i + m_chunk, num_reactions);
 
     generate_cxx_code::print_reaction_rates(
-      model, i, rid_end, genfile, m_ostreams[1].first,
+      model, i, rid_end, genfile, header_name,
       good_params, sconstant_init_assig,
       assignment_rules_map, model_reactions_map, ev_assign,
       wcs_all_const, wcs_all_var, dep_params_f,
-      dep_params_nf, rate_rules_dep_map);
+      dep_params_nf, rate_rules_dep_map, m_batched, j);
     close_ostream(m_ostreams[j+3].second);
   }
 }
@@ -1888,12 +2061,31 @@ std::string generate_cxx_code::gen_makefile()
       shared_lib = stem + ext;
 
       os_makefile << "CXX = " + std::string(CMAKE_CXX_COMPILER) + "\n";
-      os_makefile << "CXXFLAGS = " + std::string(CMAKE_CXX_FLAGS) + "\n";
+      os_makefile << "CXXFLAGS = " + get_cxx_flags() + "\n";
       os_makefile << "WCS_INCLUDE_DIR = " + std::string(WCS_INCLUDE_DIR) + "\n";
       os_makefile << "LIBRARY_FLAGS = " + std::string(CMAKE_CXX_SHARED_LIBRARY_FLAGS) + "\n\n";
       os_makefile << "all: " + shared_lib + "\n\n";
     }
 
+    const std::string suppress_warnings = " -Wno-unused ";
+    const std::string compilation_log = (m_save_log? " 2>> wcs_jit_log.txt" : "");
+
+    // Precompile the header included first by every source file. The compiler
+    // picks up the precompiled one in place of the header found in the same
+    // directory, and falls back to the header if it is not usable.
+    std::string pch_filename;
+    if (use_precompiled_header()) {
+      pch_filename = hdr_filename + ".gch";
+      std::string cmd0
+        = std::string("$(CXX) $(CXXFLAGS)") + suppress_warnings
+        + " -fPIC $(WCS_INCLUDE_DIR) "
+        + " -x c++-header " + hdr_filename + " -o " + pch_filename
+        + compilation_log;
+
+      os_makefile << pch_filename + ": " + hdr_filename + "\n"
+                   + "\t" + cmd0 + "\n\n";
+    }
+
     // commands to build object file for each source file
     for (size_t i = 2u; i < m_ostreams.size(); ++i)
     {
@@ -1914,8 +2106,6 @@ std::string generate_cxx_code::gen_makefile()
       const std::string obj_filename = stem + ".o";
       obj_files += ' ' + obj_filename;
 
-      const std::string suppress_warnings = " -Wno-unused ";
-      const std::string compilation_log = (m_save_log? " 2>> wcs_jit_log.txt" : "");
       const std::string tmp_file = (m_cleanup? src_filename : "");
 
       std::string cmd1
@@ -1923,7 +2113,8 @@ std::string generate_cxx_code::gen_makefile()
         + " -fPIC $(WCS_INCLUDE_DIR) "
         + " -c " + src_filename + compilation_log;
 
-      os_makefile << obj_filename + ": " + src_filename + ' ' + hdr_filename + "\n"
+      os_makefile << obj_filename + ": " + src_filename + ' ' + hdr_filename
+                   + (pch_filename.empty()? "" : ' ' + pch_filename) + "\n"
                    + "\t" + cmd1 + "\n\n";
 
       //int ret = build(cmd1, obj_filename, tmp_file, compilation_log);
@@ -1937,10 +2128,15 @@ std::string generate_cxx_code::gen_makefile()
 
       os_makefile << shared_lib + ": " + obj_files + "\n"
                    + "\t" + cmd2 + "\n\n";
-      os_makefile << "clean: \n\t@rm -f " + obj_files + " " + m_lib_filename + "\n";
+      os_makefile << "clean: \n\t@rm -f " + obj_files + " " + pch_filename
+                   + " " + m_lib_filename + "\n";
 
       //int ret = build(cmd2, m_lib_filename, obj_files, "");
     }
+    // Remove the precompiled header along with the objects after building
+    if (!pch_filename.empty()) {
+      obj_files += ' ' + pch_filename;
+    }
   }
 
   close_ostream(m_ostreams[0].second);
@@ -1968,6 +2164,119 @@ std::string generate_cxx_code::gen_makefile()
   return obj_files;
 }
 
+int generate_cxx_code::run_make(const std::string& obj_files)
+{
+  int ret = EXIT_SUCCESS;
+
+ #if defined(_OPENMP)
+  #pragma omp master
+ #endif // defined(_OPENMP)
+  {
+    const unsigned parallel_compile
+      = std::min(get_num_compile_jobs(),
+                 static_cast<unsigned>(m_ostreams.size()-2));
+
+    std::string cmd3 = "pushd " + m_tmp_dir
+                     + "; make -j " + std::to_string(parallel_compile)
+                     + " -f " + m_ostreams[0].first + " all; popd";
+    std::cout << cmd3 << std::endl;
+    ret = build(cmd3, m_lib_filename, obj_files, "");
+  }
+  return ret;
+}
+
+unsigned int generate_cxx_code::get_num_compile_jobs() const
+{
+  unsigned int jobs
+    = static_cast<unsigned int>(std::thread::hardware_concurrency()*0.5);
+  jobs = std::max(1u, jobs);
+
+  if (m_num_compiling_threads != 0u) {
+    jobs = std::min(jobs, m_num_compiling_threads);
+  }
+  return jobs;
+}
+
+bool generate_cxx_code::use_precompiled_header()
+{
+  // Only GCC looks up the precompiled header implicitly by the name of the
+  // header included.
+  return (std::string(CMAKE_CXX_COMPILER_ID) == "GNU");
+}
+
+std::string generate_cxx_code::get_cxx_flags()
+{
+  const char* env = std::getenv("WCS_JIT_OPT_MODE");
+  const std::string mode = ((env != nullptr)? std::string(env) : WCS_JIT_OPT_MODE);
+  std::string flags = CMAKE_CXX_FLAGS;
+
+  if (mode == "compile") {
+    // The generated code is mostly straight-line. Light optimization without
+    // debug information keeps most of the speed at a fraction of the time.
+    flags += " -O1 -g0";
+  } else if (mode == "runtime") {
+    flags += " -O3 -fno-math-errno";
+  } else if (!mode.empty() && (mode != "default")) {
+    WCS_THROW("Unknown JIT optimization mode '" + mode +
+              "'. It must be one of default, compile or runtime.");
+  }
+  return flags;
+}
+
+unsigned int generate_cxx_code::get_chunk_size() const
+{
+  return m_chunk;
+}
+
+/**
+ *  The size of the code generated for a reaction is estimated by the length
+ *  of its rate formula, which appears in both the computation and the checks
+ *  of the result, on top of the boilerplate of the function. Reactions are
+ *  split into at least as many chunks as the number of parallel jobs, and
+ *  more if needed to keep each translation unit under `max_unit_size`, of
+ *  which the compilation time grows faster than linearly with the size. On
+ *  the other hand, each chunk takes at least `min_chunk` reactions, as every
+ *  translation unit costs the start-up of the compiler.
+ */
+void generate_cxx_code::choose_chunk_size(
+  const LIBSBML_CPP_NAMESPACE::Model& model,
+  const unsigned int num_reactions)
+{
+  if (m_chunk != 0u) {
+    return;
+  }
+  if (num_reactions == 0u) {
+    m_chunk = 1u;
+    return;
+  }
+
+  constexpr size_t boilerplate_size = 512ul;
+  constexpr size_t max_unit_size = 256ul*1024ul;
+  constexpr size_t min_chunk = 64ul;
+
+  const ListOfReactions* reaction_list = model.getListOfReactions();
+  size_t code_size = 0ul;
+  for (unsigned int ic = 0u; ic < num_reactions; ic++) {
+    code_size += boilerplate_size;
+    const auto* kinetic_law = reaction_list->get(ic)->getKineticLaw();
+    if ((kinetic_law == nullptr) || (kinetic_law->getMath() == nullptr)) {
+      continue;
+    }
+    char* formula = SBML_formulaToString(kinetic_law->getMath());
+    if (formula != nullptr) {
+      code_size += 2ul * strlen(formula);
+      free(formula);
+    }
+  }
+
+  const size_t num_chunks
+    = std::max(static_cast<size_t>(get_num_compile_jobs()),
+               (code_size + max_unit_size - 1ul) / max_unit_size);
+  size_t chunk = (num_reactions + num_chunks - 1ul) / num_chunks;
+  chunk = std::max(chunk, std::min(min_chunk, static_cast<size_t>(num_reactions)));
+  m_chunk = static_cast<unsigned int>(chunk);
+}
+
 std::string generate_cxx_code::compile_code()
 {
  #if defined(_OPENMP)
@@ -1976,7 +2285,6 @@ std::string generate_cxx_code::compile_code()
   {
     std::cerr << "JIT compiling ..." << std::endl;
   }
-  int ret = EXIT_SUCCESS;
 
   if (!m_regen) {
     close_ostream(m_ostreams[0].second);
@@ -1989,32 +2297,204 @@ std::string generate_cxx_code::compile_code()
     return "";
   }
 
+  if (m_use_cache) {
+    return compile_code_with_cache();
+  }
+
   std::string obj_files = gen_makefile();
 
- #if defined(_OPENMP)
-  #pragma omp master
- #endif // defined(_OPENMP)
+  const int ret = run_make(obj_files);
+
+  if (ret == EXIT_FAILURE) return "";
+
+  return m_lib_filename;
+}
+
+std::string generate_cxx_code::get_cache_dir()
+{
+  const char* env = std::getenv("WCS_JIT_CACHE_DIR");
+  std::string dir = ((env != nullptr)? std::string(env) : WCS_JIT_CACHE_DIR);
+
+  while ((dir.size() > 1ul) && (dir.back() == '/')) {
+    dir.pop_back();
+  }
+  return dir;
+}
+
+/// Create the directory as well as any missing parent directory
+static bool mkdir_recursive(const std::string& path)
+{
+  struct stat sb;
+  if (stat(path.c_str(), &sb) == 0) {
+    return (S_ISDIR(sb.st_mode) != 0);
+  }
+  const auto pos = path.find_last_of('/');
+  if ((pos != std::string::npos) && (pos > 0ul) &&
+      !mkdir_recursive(path.substr(0ul, pos))) {
+    return false;
+  }
+  // Another process may have created it in the meantime
+  return ((mkdir(path.c_str(), 0755) == 0) || (errno == EEXIST));
+}
+
+void generate_cxx_code::setup_cache(const bool regen)
+{
+  // The sources are always generated to compute the key to look up.
+  m_cache_lookup = !regen;
+  m_regen = true;
+
+  if (!mkdir_recursive(m_cache_dir)) {
+    WCS_THROW("Failed to create the cache directory " + m_cache_dir +
+              ": " + strerror(errno));
+  }
+
+  char canonical[PATH_MAX] = {'\0'};
+  if (realpath(m_cache_dir.c_str(), canonical) == nullptr) {
+    WCS_THROW("Failed to resolve the cache directory " + m_cache_dir);
+  }
+  m_cache_dir = canonical;
+
+  // Generate the code in a private staging directory within the cache such
+  // that the library built can be moved into the cache atomically.
+  std::string staging = m_cache_dir + "/staging_XXXXXX";
+  if (mkdtemp(&staging[0]) == nullptr) {
+    WCS_THROW("Failed to create a staging directory in " + m_cache_dir +
+              ": " + strerror(errno));
+  }
+  m_tmp_dir = staging;
+  // The name of the library is independent of the model such that
+  // identical models under different names share the library.
+  m_lib_filename = m_tmp_dir + "/wcs_rates.so";
+}
+
+/// Incremental 128-bit FNV-1a hash
+class fnv1a_128 {
+ public:
+  fnv1a_128()
+  : m_hash((static_cast<uint128_t>(0x6c62272e07bb0142ull) << 64u)
+           | 0x62b821756295c58dull)
+  {}
+
+  void update(const char* data, const size_t len)
   {
-    unsigned parallel_compile
-      = static_cast<unsigned>(std::thread::hardware_concurrency()*0.5);
-    parallel_compile = std::max(1u, parallel_compile);
-    parallel_compile
-      = std::min(parallel_compile, static_cast<unsigned>(m_ostreams.size()-2));
+    const uint128_t prime = (static_cast<uint128_t>(1u) << 88u) + 0x13bu;
+    for (size_t i = 0ul; i < len; ++i) {
+      m_hash ^= static_cast<unsigned char>(data[i]);
+      m_hash *= prime;
+    }
+  }
 
-    if (m_num_compiling_threads != 0u) {
-      parallel_compile
-        = std::min(parallel_compile, m_num_compiling_threads);
+  /// Hash a string including the terminating null to separate items
+  void update(const std::string& str)
+  {
+    update(str.c_str(), str.size() + 1ul);
+  }
+
+  std::string hex() const
+  {
+    static const char digits[] = "0123456789abcdef";
+    std::string str(32u, '0');
+    uint128_t h = m_hash;
+    for (size_t i = 32ul; i-- > 0ul; h >>= 4u) {
+      str[i] = digits[static_cast<unsigned>(h & 0xfu)];
     }
+    return str;
+  }
 
-    std::string cmd3 = "pushd " + m_tmp_dir
-                     + "; make -j " + std::to_string(parallel_compile)
-                     + " -f " + m_ostreams[0].first + " all; popd";
-    std::cout << cmd3 << std::endl;
-    ret = build(cmd3, m_lib_filename, obj_files, "");
+ private:
+  __extension__ typedef unsigned __int128 uint128_t;
+  uint128_t m_hash;
+};
+
+std::string generate_cxx_code::compute_cache_key() const
+{
+  fnv1a_128 h;
+
+  // Bump this up whenever the way to build the library changes
+  h.update(std::string("wcs_jit_cache_v2"));
+  h.update(std::string(CMAKE_CXX_COMPILER));
+  h.update(std::string(CMAKE_CXX_COMPILER_VERSION));
+  h.update(get_cxx_flags());
+  h.update(std::string(CMAKE_CXX_SHARED_LIBRARY_FLAGS));
+  h.update(std::string(WCS_INCLUDE_DIR));
+  h.update(std::string(basetype_to_string<reaction_rate_t>::value));
+ #if defined(WCS_64BIT_CNT)
+  h.update(std::string("WCS_64BIT_CNT"));
+ #endif // defined(WCS_64BIT_CNT)
+  h.update(std::to_string(sizeof(species_cnt_t)));
+
+  // Skip the Makefile, which is not yet written, and depends only on the
+  // parameters above and the names of the source files.
+  std::vector<char> buf(1ul << 16u);
+  for (size_t i = 1ul; i < m_ostreams.size(); ++i) {
+    const std::string& src_filename = m_ostreams[i].first;
+    h.update(get_subpath(m_tmp_dir, src_filename));
+
+    std::ifstream is(src_filename, std::ios::binary);
+    if (!is) {
+      WCS_THROW("Failed to read " + src_filename);
+    }
+    while (is.read(buf.data(), static_cast<std::streamsize>(buf.size())) ||
+           (is.gcount() > 0)) {
+      h.update(buf.data(), static_cast<size_t>(is.gcount()));
+    }
+  }
+  return h.hex();
+}
+
+std::string generate_cxx_code::compile_code_with_cache()
+{
+  const std::string key = compute_cache_key();
+  const std::string cached_lib = m_cache_dir + "/" + key + ".so";
+  const std::string lock_file = m_cache_dir + "/" + key + ".lock";
+
+  // Let only one process at a time build the library of the same key while
+  // the others wait to reuse it.
+  const int fd = open(lock_file.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    WCS_THROW("Failed to open the lock file " + lock_file +
+              ": " + strerror(errno));
+  }
+  if (flock(fd, LOCK_EX) != 0) {
+    close(fd);
+    WCS_THROW("Failed to lock " + lock_file + ": " + strerror(errno));
+  }
+
+  int ret = EXIT_SUCCESS;
+  if (m_cache_lookup && check_if_file_exists(cached_lib)) {
+    std::cerr << "Reusing the cached library " + cached_lib << std::endl;
+    close_ostream(m_ostreams[0].second);
+    m_regen = false;
+  } else {
+    std::string obj_files = gen_makefile();
+    ret = run_make(obj_files);
+
+    // Install the library built only as a whole
+    if ((ret != EXIT_FAILURE) &&
+        (rename(m_lib_filename.c_str(), cached_lib.c_str()) != 0)) {
+      std::cerr << "Failed to install " + m_lib_filename + " as "
+                   + cached_lib + ": " + strerror(errno) << std::endl;
+      ret = EXIT_FAILURE;
+    }
+    if (ret != EXIT_FAILURE) {
+      sync_directory(m_cache_dir);
+      std::cerr << "Cached the library as " + cached_lib << std::endl;
+    }
+  }
+
+  flock(fd, LOCK_UN);
+  close(fd);
+
+  if (m_cleanup) {
+    const std::string cmd_rm = "rm -rf " + m_tmp_dir;
+    if (system(cmd_rm.c_str()) != 0) {
+      std::cerr << "Failed to remove " + m_tmp_dir << std::endl;
+    }
   }
 
   if (ret == EXIT_FAILURE) return "";
 
+  m_lib_filename = cached_lib;
   return m_lib_filename;
 }
 
@@ -2033,6 +2513,16 @@ std::string generate_cxx_code::get_lib_filename() const
   return m_lib_filename;
 }
 
+void generate_cxx_code::set_batched(const bool batched)
+{
+  m_batched = batched;
+}
+
+bool generate_cxx_code::is_batched() const
+{
+  return m_batched;
+}
+
 } // end of namespace wcs
 
 #endif // defined(WCS_HAS_SBML)
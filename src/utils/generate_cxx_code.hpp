@@ -52,21 +52,55 @@ class generate_cxx_code {
                     bool save_log = false,
                     bool cleanup = true,
                     const std::string& tmp_dir = "tmp_jit",
-                    unsigned int chunk_size = 1000u,
+                    unsigned int chunk_size = 0u,
                     unsigned int num_compiling_threads = 4u);
 
+  /**
+   * Set whether to emit the batched rate kernels in addition to the function
+   * for each reaction. By default, this follows the build option
+   * WCS_JIT_BATCH_RATES.
+   */
+  void set_batched(const bool batched);
+  bool is_batched() const;
+
   void generate_code(
     const LIBSBML_CPP_NAMESPACE::Model& model,
     params_map_t& dep_params_f,
     params_map_t& dep_params_nf,
     rate_rules_dep_t& rate_rules_dep_map);
 
+  /**
+   * Compile the generated code into a library and return the path to the
+   * library file. With the cache enabled, this is the path to the library in
+   * the cache.
+   */
   std::string compile_code();
   std::string gen_makefile();
 
   std::vector<std::string> get_src_filenames() const;
   std::string get_lib_filename() const;
 
+  /**
+   * Return the directory to cache the compiled libraries in, which is given
+   * by the environment variable WCS_JIT_CACHE_DIR, or by the build option of
+   * the same name if the variable is not set. Caching is disabled if empty.
+   */
+  static std::string get_cache_dir();
+
+  /**
+   * Return the flags to compile the generated code with. These are the flags
+   * of this build extended by the optimization mode, which is given by the
+   * environment variable WCS_JIT_OPT_MODE, or by the build option of the same
+   * name if the variable is not set.
+   * - default: no extra flag
+   * - compile: favor the compilation speed over that of the code compiled
+   * - runtime: favor the speed of the code compiled
+   */
+  static std::string get_cxx_flags();
+
+  /// Return the number of reactions written into a translation unit
+  unsigned int get_chunk_size() const;
+
   template <typename TTT>
   class basetype_to_string {
    public:
@@ -74,7 +108,39 @@ class generate_cxx_code {
   };
 
  private:
-  static void create_ostream(src_file_t& ofile, size_t suffix_size);
+  /**
+   * Create a source file of the given name. If `unique` is set, the name is
+   * taken as a template of which the six 'X' characters in front of the
+   * suffix are replaced to make the name unique.
+   */
+  static void create_ostream(src_file_t& ofile, size_t suffix_size,
+                             const bool unique = true);
+  /// Prepare the staging directory in the cache to generate the code in
+  void setup_cache(const bool regen);
+  /**
+   * Compute the key of the library to build as the hash of the generated
+   * source files, the compiler, the compilation flags and the type
+   * configuration that the generated code depends on.
+   */
+  std::string compute_cache_key() const;
+  /**
+   * Look up the library of the generated code in the cache, and build and
+   * install it if not found.
+   */
+  std::string compile_code_with_cache();
+  /// Run make with the generated Makefile
+  int run_make(const std::string& obj_files);
+  /// Return the number of jobs to compile the generated code in parallel
+  unsigned int get_num_compile_jobs() const;
+  /**
+   * Unless given, choose the number of reactions to write into a translation
+   * unit based on the estimated size of the code to generate and the number
+   * of jobs to compile in parallel.
+   */
+  void choose_chunk_size(const LIBSBML_CPP_NAMESPACE::Model& model,
+                         const unsigned int num_reactions);
+  /// Whether to precompile the header shared by the generated source files
+  static bool use_precompiled_header();
   void open_ostream(unsigned int num_reactions);
   void close_ostream(std::unique_ptr<std::ostream>& os_ptr);
 
@@ -181,7 +247,20 @@ class generate_cxx_code {
     const std::unordered_set<std::string>& wcs_all_var,
     params_map_t& dep_params_f,
     params_map_t& dep_params_nf,
-    const rate_rules_dep_t& rate_rules_dep_map);
+    const rate_rules_dep_t& rate_rules_dep_map,
+    const bool batched,
+    const unsigned int chunk_id);
+
+  /**
+   * Write the batched kernels of a chunk of reactions. `rates` lists the id
+   * and the number of inputs of each reaction in the chunk, starting from the
+   * reaction of the index `rid_start`.
+   */
+  static void print_batched_rate_kernels(
+    std::ostream & genfile,
+    const unsigned int rid_start,
+    const unsigned int chunk_id,
+    const std::vector<std::pair<std::string, unsigned int>>& rates);
 
  private:
    std::string m_lib_filename; ///< Name of the library file
@@ -190,11 +269,23 @@ class generate_cxx_code {
    bool m_cleanup; ///< Whether to remove the temporary source file generated
    std::string m_tmp_dir;
 
-   /// The number of reactions to group into a translation unit for compilation
+   /**
+    * The number of reactions to group into a translation unit for compilation.
+    * If zero, it is chosen by choose_chunk_size() at the code generation.
+    */
    unsigned int m_chunk;
    /// The number of threads used in parallel compilation (make -j n ...)
    unsigned int m_num_compiling_threads;
    std::vector<src_file_t> m_ostreams;
+   /// Whether to emit the batched rate kernels
+   bool m_batched;
+
+   /// Directory of the cache of compiled libraries
+   std::string m_cache_dir;
+   /// Whether to use the cache of compiled libraries
+   bool m_use_cache;
+   /// Whether to reuse the library in the cache if found
+   bool m_cache_lookup;
 };
 
 /**@}*/
@@ -11,9 +11,12 @@
 #ifndef __WCS_UTILS_GRAPH_FACTORY_HPP__
 #define __WCS_UTILS_GRAPH_FACTORY_HPP__
 
+#include <fstream>
 #include <string>
 #include <unordered_map>
 #include <type_traits>
+#include <tuple>
+#include <vector>
 #include <dlfcn.h> //dlopen
 #include "utils/file.hpp"
 
@@ -48,6 +51,9 @@
 #include <reaction_network/species.hpp>
 #include <reaction_network/reaction.hpp>
 #include <utils/detect_methods.hpp>
+#include <utils/graphml_scanner.hpp>
+#include <utils/exception.hpp>
+#include <boost/lexical_cast.hpp>
 #include <utils/sbml_utils.hpp>
 
 
@@ -83,6 +89,14 @@ class GraphFactory {
   /** Export the internal adjacency list to g, which might be of a different
       type in terms of the random accessibility but of a compatible one (G). */
   template<typename G> void copy_to(G& g) const;
+  /**
+   * Read a GraphML file directly into g without the intermediate graph,
+   * with the same result as read_graphml() followed by copy_to(). The file
+   * is scanned twice. The first pass collects the vertex types and the end
+   * points of edges to reserve the storage of g. The second constructs the
+   * vertex and edge properties in place.
+   */
+  template<typename G> static bool read_graphml(const std::string& ifn, G& g);
 
   #if defined(WCS_HAS_SBML)
   template<typename G>
@@ -185,6 +199,239 @@ template<typename G> void GraphFactory::copy_to(G& g) const
   }
 }
 
+template<typename G>
+bool GraphFactory::read_graphml(const std::string& ifn, G& g)
+{
+  using v_new_desc_t = typename boost::graph_traits<G>::vertex_descriptor;
+  using e_new_prop_t = typename boost::edge_bundle_type<G>::type;
+
+  using directed_category = typename boost::graph_traits<G>::directed_category;
+  constexpr bool is_bidirectional
+    = std::is_same<directed_category, boost::bidirectional_tag>::value;
+
+  std::ifstream in_file(ifn.c_str(), std::ios::binary);
+  if (!in_file.good ())
+    return false;
+
+  try {
+    GraphMLScanner scanner(in_file);
+    GraphMLScanner::item_type it;
+
+    // As boost::read_graphml(), a node is created when its id first appears
+    // either by itself or as an end point of an edge, and a node declared
+    // multiple times accumulates the data given. Nodes are identified by the
+    // order of creation.
+    std::unordered_map<std::string, size_t> node_pos;
+    std::vector<int> node_type;
+    // The number of times that each node is declared, up to two
+    std::vector<unsigned char> num_decls;
+    std::vector<std::pair<size_t, size_t>> edge_ends;
+
+    const auto find_or_create_node = [&](const std::string& id) {
+      const auto ret = node_pos.emplace(id, node_type.size());
+      if (ret.second) {
+        const std::string* const vt
+          = scanner.default_data(GraphMLScanner::_node_, "v_type");
+        node_type.push_back((vt == nullptr)? v_prop_t{}.get_typeid()
+                                           : boost::lexical_cast<int>(*vt));
+        num_decls.push_back(0u);
+      }
+      return ret.first->second;
+    };
+
+    // The first pass to find the vertex types and the edge end points
+    while ((it = scanner.next()) != GraphMLScanner::_none_) {
+      if (it == GraphMLScanner::_node_) {
+        const size_t pos = find_or_create_node(scanner.id());
+        const std::string* const vt = scanner.data("v_type", false);
+        if (vt != nullptr) {
+          node_type[pos] = boost::lexical_cast<int>(*vt);
+        }
+        num_decls[pos] = std::min(num_decls[pos] + 1, 2);
+      } else {
+        const size_t src = find_or_create_node(scanner.source());
+        const size_t dst = find_or_create_node(scanner.target());
+        edge_ends.emplace_back(src, dst);
+      }
+    }
+
+    const size_t num_nodes = node_type.size();
+    const size_t num_edges = edge_ends.size();
+    const int species_type = static_cast<int>(v_prop_t::_species_);
+    const int reaction_type = static_cast<int>(v_prop_t::_reaction_);
+
+    std::vector<size_t> out_degree(num_nodes, 0ul);
+    std::vector<size_t> in_degree(num_nodes, 0ul);
+    std::vector<bool> has_species_input(num_nodes, false);
+    for (const auto& e : edge_ends) {
+      out_degree[e.first] ++;
+      in_degree[e.second] ++;
+      if (node_type[e.first] == species_type) {
+        has_species_input[e.second] = true;
+      }
+    }
+
+    // As copy_to(), drop the reactions without any species input or product
+    std::vector<bool> keep(num_nodes, false);
+    size_t num_kept = 0ul;
+    for (size_t i = 0ul; i < num_nodes; ++i) {
+      keep[i] = (node_type[i] == species_type) ||
+                ((node_type[i] == reaction_type) &&
+                 (has_species_input[i] || (out_degree[i] > 0ul)));
+      num_kept += static_cast<size_t>(keep[i]);
+    }
+    has_species_input.clear();
+    node_type.clear();
+    node_type.shrink_to_fit();
+
+    // As copy_to(), add the edges grouped by the source node in the order of
+    // the nodes, and in the order of appearance among the same source.
+    std::vector<size_t> slot_offset(num_nodes + 1ul, 0ul);
+    for (size_t i = 0ul; i < num_nodes; ++i) {
+      slot_offset[i+1] = slot_offset[i] + out_degree[i];
+    }
+    std::vector<size_t> edge_slot(num_edges);
+    std::vector<std::pair<size_t, size_t>> slot_ends(num_edges);
+    for (size_t k = 0ul; k < num_edges; ++k) {
+      const auto src = edge_ends[k].first;
+      edge_slot[k] = slot_offset[src] ++;
+      slot_ends[edge_slot[k]] = edge_ends[k];
+    }
+    edge_ends.clear();
+    edge_ends.shrink_to_fit();
+    slot_offset.clear();
+    slot_offset.shrink_to_fit();
+
+    // Add the vertices in the order of creation with the storage of edges
+    // reserved, and set their properties while reading the nodes again.
+    if constexpr (has_reserve_for_vertex_list<G>::value) {
+      g.m_vertices.reserve(num_kept);
+    }
+    std::vector<v_new_desc_t> vds(num_nodes);
+    for (size_t i = 0ul; i < num_nodes; ++i) {
+      if (!keep[i]) {
+        continue;
+      }
+      const v_new_desc_t vd = boost::add_vertex(g);
+      if constexpr (has_reserve_for_vertex_out_edges<G>::value) {
+        g.m_vertices[vd].m_out_edges.reserve(out_degree[i]);
+      }
+      if constexpr (has_reserve_for_vertex_in_edges<G>::value &&
+                    is_bidirectional)
+      {
+        g.m_vertices[vd].m_in_edges.reserve(in_degree[i]);
+      }
+      vds[i] = vd;
+    }
+    out_degree.clear();
+    in_degree.clear();
+
+    // Set the fields of a flat vertex by the data looked up by the name
+    const auto set_node_data = [](v_prop_t& flat, const auto& data_of)
+    {
+      const std::string* d = nullptr;
+      if ((d = data_of("v_label")) != nullptr) {
+        flat.m_label = *d;
+      }
+      if ((d = data_of("v_type")) != nullptr) {
+        flat.m_typeid = boost::lexical_cast<int>(*d);
+      }
+      if ((d = data_of("s_count")) != nullptr) {
+        flat.m_count = boost::lexical_cast<v_prop_t::s_cnt_t>(*d);
+      }
+      if ((d = data_of("r_const")) != nullptr) {
+        flat.m_rate_const = boost::lexical_cast<v_prop_t::r_rate_t>(*d);
+      }
+      if ((d = data_of("r_rate")) != nullptr) {
+        flat.m_rate_formula = *d;
+      }
+      flat.set_type();
+    };
+
+    // Flat vertices of the nodes declared multiple times to accumulate data
+    std::unordered_map<size_t, v_prop_t> multi_decls;
+    std::vector<bool> declared(num_nodes, false);
+    std::vector<e_new_prop_t> eprops(num_edges);
+    size_t ei = 0ul;
+
+    // The second pass to construct the properties
+    scanner.rewind();
+    while ((it = scanner.next()) != GraphMLScanner::_none_) {
+      if (it == GraphMLScanner::_node_) {
+        const auto pit = node_pos.find(scanner.id());
+        if (pit == node_pos.cend()) {
+          WCS_THROW(ifn + " has changed while reading.");
+        }
+        const size_t pos = pit->second;
+        if (!keep[pos]) {
+          continue;
+        }
+        // The default values only apply to a new node
+        const bool or_default = !declared[pos];
+        const auto data_of = [&](const char* name) {
+          return scanner.data(name, or_default);
+        };
+        if (num_decls[pos] > 1u) {
+          auto& flat = multi_decls[pos];
+          set_node_data(flat, data_of);
+          g[vds[pos]] = wcs::Vertex{flat, g};
+        } else {
+          v_prop_t flat;
+          set_node_data(flat, data_of);
+          g[vds[pos]] = wcs::Vertex{flat, g};
+        }
+        declared[pos] = true;
+      } else {
+        if (ei >= num_edges) {
+          WCS_THROW(ifn + " has changed while reading.");
+        }
+        auto& e = eprops[edge_slot[ei++]];
+        const std::string* d = nullptr;
+        if ((d = scanner.data("e_label")) != nullptr) {
+          e.m_label = *d;
+        }
+        if ((d = scanner.data("e_stoic")) != nullptr) {
+          e.m_stoichio = boost::lexical_cast<stoic_t>(*d);
+        }
+      }
+    }
+    if (ei != num_edges) {
+      WCS_THROW(ifn + " has changed while reading.");
+    }
+    node_pos.clear();
+    multi_decls.clear();
+    edge_slot.clear();
+    edge_slot.shrink_to_fit();
+
+    for (size_t i = 0ul; i < num_nodes; ++i) {
+      if (keep[i] && !declared[i]) {
+        // Only with the default values as created by an edge
+        const auto data_of = [&](const char* name) {
+          return scanner.default_data(GraphMLScanner::_node_, name);
+        };
+        v_prop_t flat;
+        set_node_data(flat, data_of);
+        g[vds[i]] = wcs::Vertex{flat, g};
+      }
+    }
+
+    for (size_t k = 0ul; k < num_edges; ++k) {
+      const auto& e = slot_ends[k];
+      if (!keep[e.first] || !keep[e.second]) {
+        WCS_THROW("An edge refers to a vertex excluded from the graph.");
+      }
+      boost::add_edge(vds[e.first], vds[e.second], std::move(eprops[k]), g);
+    }
+  } catch (std::exception& e) {
+    std::cerr << e.what () << std::endl;
+    in_file.close ();
+    return false;
+  }
+
+  in_file.close ();
+  return true;
+}
+
 #if defined(WCS_HAS_SBML)
 /// Create a Boost graph out of an SBML model
 template<typename G> void
@@ -0,0 +1,459 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <cctype> // isspace()
+#include <cstring> // strlen()
+#include "utils/graphml_scanner.hpp"
+#include "utils/exception.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_utils
+ *  @{ */
+
+static constexpr int eof = std::char_traits<char>::eof();
+
+GraphMLScanner::GraphMLScanner(std::istream& is)
+: m_is(is), m_buf(is.rdbuf()), m_type(_none_)
+{}
+
+inline int GraphMLScanner::get()
+{
+  return m_buf->sbumpc();
+}
+
+inline int GraphMLScanner::peek()
+{
+  return m_buf->sgetc();
+}
+
+void GraphMLScanner::rewind()
+{
+  m_is.clear();
+  m_is.seekg(0);
+  m_buf = m_is.rdbuf();
+  m_keys.clear();
+  m_values.clear();
+  m_has_value.clear();
+  m_type = _none_;
+}
+
+void GraphMLScanner::skip_past(const char* const delim)
+{
+  const size_t n = strlen(delim);
+  std::string window;
+  int c;
+  while ((c = get()) != eof) {
+    window.push_back(static_cast<char>(c));
+    if (window.size() > n) {
+      window.erase(0, 1);
+    }
+    if (window == delim) {
+      return;
+    }
+  }
+  WCS_THROW("Unexpected end of GraphML while looking for " + std::string(delim));
+}
+
+bool GraphMLScanner::read_tag(std::string& name, attrs_t& attrs,
+                              bool& is_end, bool& is_empty)
+{
+  int c = peek();
+  if (c == '?') { // processing instruction
+    skip_past("?>");
+    return false;
+  }
+  if (c == '!') {
+    get();
+    c = peek();
+    if (c == '-') { // comment
+      skip_past("-->");
+    } else if (c == '[') { // CDATA section outside of data
+      skip_past("]]>");
+    } else { // document type declaration without an internal subset
+      skip_past(">");
+    }
+    return false;
+  }
+
+  is_end = false;
+  is_empty = false;
+  if (c == '/') {
+    get();
+    is_end = true;
+  }
+
+  name.clear();
+  while (((c = peek()) != eof) && !isspace(c) && (c != '>') && (c != '/')) {
+    name.push_back(static_cast<char>(get()));
+  }
+  // Ignore the namespace prefix
+  const auto pos = name.find(':');
+  if (pos != std::string::npos) {
+    name.erase(0, pos + 1);
+  }
+
+  attrs.clear();
+  while (true) {
+    while (((c = get()) != eof) && isspace(c)) {}
+    if (c == eof) {
+      WCS_THROW("Unexpected end of GraphML in the tag " + name);
+    } else if (c == '>') {
+      break;
+    } else if (c == '/') {
+      if (get() != '>') {
+        WCS_THROW("Malformed tag " + name);
+      }
+      is_empty = true;
+      break;
+    }
+
+    std::string aname(1, static_cast<char>(c));
+    while (((c = peek()) != eof) && !isspace(c) && (c != '=')) {
+      aname.push_back(static_cast<char>(get()));
+    }
+    while (((c = get()) != eof) && isspace(c)) {}
+    if (c != '=') {
+      WCS_THROW("Malformed attribute " + aname + " of the tag " + name);
+    }
+    while (((c = get()) != eof) && isspace(c)) {}
+    if ((c != '"') && (c != '\'')) {
+      WCS_THROW("Malformed attribute " + aname + " of the tag " + name);
+    }
+    const int quote = c;
+    std::string value;
+    while (((c = get()) != eof) && (c != quote)) {
+      if (c == '&') {
+        std::string ent;
+        while (((c = get()) != eof) && (c != ';')) {
+          ent.push_back(static_cast<char>(c));
+        }
+        decode_entity(ent, value);
+      } else {
+        value.push_back(static_cast<char>(c));
+      }
+    }
+    if (c == eof) {
+      WCS_THROW("Unexpected end of GraphML in the tag " + name);
+    }
+    attrs.emplace_back(std::move(aname), std::move(value));
+  }
+  return true;
+}
+
+void GraphMLScanner::read_text(std::string& text)
+{
+  text.clear();
+  // Whether there is whitespace to put before the next character
+  bool space = false;
+  int c;
+  while ((c = get()) != eof) {
+    if (isspace(c)) {
+      space = !text.empty();
+      continue;
+    }
+    if (space && (c != '<')) {
+      text.push_back(' ');
+      space = false;
+    }
+    if (c == '&') {
+      std::string ent;
+      while (((c = get()) != eof) && (c != ';')) {
+        ent.push_back(static_cast<char>(c));
+      }
+      decode_entity(ent, text);
+    } else if (c == '<') {
+      c = peek();
+      if (c == '/') { // end tag of the current element
+        skip_past(">");
+        return;
+      } else if (c == '!') {
+        get();
+        if (peek() == '[') {
+          skip_past("[CDATA[");
+          std::string cdata;
+          while ((c = get()) != eof) {
+            cdata.push_back(static_cast<char>(c));
+            const auto n = cdata.size();
+            if ((n >= 3u) && (cdata.compare(n - 3u, 3u, "]]>") == 0)) {
+              cdata.resize(n - 3u);
+              break;
+            }
+          }
+          if (space && !cdata.empty()) {
+            text.push_back(' ');
+            space = false;
+          }
+          text.append(cdata);
+        } else {
+          skip_past("-->");
+        }
+      } else if (c == '?') {
+        skip_past("?>");
+      } else {
+        WCS_THROW("Unexpected element in the character data of GraphML");
+      }
+    } else {
+      text.push_back(static_cast<char>(c));
+    }
+  }
+  WCS_THROW("Unexpected end of GraphML in the character data");
+}
+
+void GraphMLScanner::skip_element(const std::string& name)
+{
+  size_t depth = 1ul;
+  std::string tag;
+  attrs_t attrs;
+  int c;
+  while (depth > 0ul) {
+    while (((c = get()) != eof) && (c != '<')) {}
+    if (c == eof) {
+      WCS_THROW("Unexpected end of GraphML in the element " + name);
+    }
+    bool is_end = false;
+    bool is_empty = false;
+    if (!read_tag(tag, attrs, is_end, is_empty)) {
+      continue;
+    }
+    if (is_end) {
+      depth --;
+    } else if (!is_empty) {
+      depth ++;
+    }
+  }
+}
+
+const std::string* GraphMLScanner::find_attr(const attrs_t& attrs,
+                                             const std::string& name)
+{
+  for (const auto& a : attrs) {
+    if (a.first == name) {
+      return &(a.second);
+    }
+  }
+  return nullptr;
+}
+
+void GraphMLScanner::decode_entity(const std::string& ent, std::string& out)
+{
+  if (ent == "lt") {
+    out.push_back('<');
+  } else if (ent == "gt") {
+    out.push_back('>');
+  } else if (ent == "amp") {
+    out.push_back('&');
+  } else if (ent == "quot") {
+    out.push_back('"');
+  } else if (ent == "apos") {
+    out.push_back('\'');
+  } else if ((ent.size() > 1u) && (ent[0] == '#')) {
+    unsigned long cp = 0ul;
+    try {
+      cp = (ent[1] == 'x')? std::stoul(ent.substr(2), nullptr, 16)
+                          : std::stoul(ent.substr(1), nullptr, 10);
+    } catch (...) {
+      WCS_THROW("Invalid character reference &" + ent + ';');
+    }
+    // Encode in UTF-8
+    if (cp < 0x80ul) {
+      out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800ul) {
+      out.push_back(static_cast<char>(0xC0ul | (cp >> 6)));
+      out.push_back(static_cast<char>(0x80ul | (cp & 0x3Ful)));
+    } else if (cp < 0x10000ul) {
+      out.push_back(static_cast<char>(0xE0ul | (cp >> 12)));
+      out.push_back(static_cast<char>(0x80ul | ((cp >> 6) & 0x3Ful)));
+      out.push_back(static_cast<char>(0x80ul | (cp & 0x3Ful)));
+    } else {
+      out.push_back(static_cast<char>(0xF0ul | (cp >> 18)));
+      out.push_back(static_cast<char>(0x80ul | ((cp >> 12) & 0x3Ful)));
+      out.push_back(static_cast<char>(0x80ul | ((cp >> 6) & 0x3Ful)));
+      out.push_back(static_cast<char>(0x80ul | (cp & 0x3Ful)));
+    }
+  } else {
+    WCS_THROW("Unknown entity &" + ent + ';');
+  }
+}
+
+void GraphMLScanner::read_key(const attrs_t& attrs, const bool is_empty)
+{
+  key_t key;
+  const std::string* const id = find_attr(attrs, "id");
+  const std::string* const name = find_attr(attrs, "attr.name");
+  const std::string* const domain = find_attr(attrs, "for");
+  if (id == nullptr) {
+    WCS_THROW("A GraphML key without id");
+  }
+  key.m_id = *id;
+  key.m_name = (name == nullptr)? *id : *name;
+  key.m_for_node = (domain == nullptr) || (*domain == "node") ||
+                   (*domain == "all");
+  key.m_for_edge = (domain == nullptr) || (*domain == "edge") ||
+                   (*domain == "all");
+  key.m_has_default = false;
+
+  int c;
+  while (!is_empty) {
+    while (((c = get()) != eof) && (c != '<')) {}
+    if (c == eof) {
+      WCS_THROW("Unexpected end of GraphML in the key " + key.m_id);
+    }
+    bool is_end = false;
+    bool is_child_empty = false;
+    if (!read_tag(m_name, m_attrs, is_end, is_child_empty)) {
+      continue;
+    }
+    if (is_end) { // end of the key
+      break;
+    }
+    if (m_name == "default") {
+      key.m_has_default = true;
+      if (!is_child_empty) {
+        read_text(key.m_default);
+      }
+    } else if (!is_child_empty) {
+      skip_element(m_name);
+    }
+  }
+
+  m_keys.emplace_back(std::move(key));
+  m_values.resize(m_keys.size());
+  m_has_value.resize(m_keys.size());
+}
+
+void GraphMLScanner::read_item(const std::string& name, const bool is_empty)
+{
+  const std::string* const id = find_attr(m_attrs, "id");
+  m_id = (id == nullptr)? "" : *id;
+
+  if (m_type == _edge_) {
+    const std::string* const src = find_attr(m_attrs, "source");
+    const std::string* const dst = find_attr(m_attrs, "target");
+    if ((src == nullptr) || (dst == nullptr)) {
+      WCS_THROW("A GraphML edge without the source or the target");
+    }
+    m_source = *src;
+    m_target = *dst;
+  }
+  std::fill(m_has_value.begin(), m_has_value.end(), false);
+
+  int c;
+  while (!is_empty) {
+    while (((c = get()) != eof) && (c != '<')) {}
+    if (c == eof) {
+      WCS_THROW("Unexpected end of GraphML in the " + name + ' ' + m_id);
+    }
+    bool is_end = false;
+    bool is_child_empty = false;
+    if (!read_tag(m_name, m_attrs, is_end, is_child_empty)) {
+      continue;
+    }
+    if (is_end) { // end of the node or the edge
+      break;
+    }
+    if (m_name == "data") {
+      const std::string* const key = find_attr(m_attrs, "key");
+      size_t i = 0ul;
+      for ( ; (key != nullptr) && (i < m_keys.size()); ++i) {
+        if (m_keys[i].m_id == *key) {
+          break;
+        }
+      }
+      if ((key == nullptr) || (i == m_keys.size())) {
+        WCS_THROW("Unknown GraphML key in the " + name + ' ' + m_id);
+      }
+      if (is_child_empty) {
+        m_values[i].clear();
+      } else {
+        read_text(m_values[i]);
+      }
+      m_has_value[i] = true;
+    } else if (!is_child_empty) {
+      skip_element(m_name);
+    }
+  }
+}
+
+GraphMLScanner::item_type GraphMLScanner::next()
+{
+  m_type = _none_;
+  int c;
+  while (true) {
+    while (((c = get()) != eof) && (c != '<')) {}
+    if (c == eof) {
+      return _none_;
+    }
+    bool is_end = false;
+    bool is_empty = false;
+    if (!read_tag(m_name, m_attrs, is_end, is_empty) || is_end) {
+      continue;
+    }
+    // Other elements such as graphml and graph are transparent
+    if (m_name == "key") {
+      read_key(m_attrs, is_empty);
+    } else if (m_name == "node") {
+      m_type = _node_;
+      read_item("node", is_empty);
+      return m_type;
+    } else if (m_name == "edge") {
+      m_type = _edge_;
+      read_item("edge", is_empty);
+      return m_type;
+    }
+  }
+}
+
+size_t GraphMLScanner::find_key(const item_type t,
+                                const std::string& attr_name) const
+{
+  size_t i = 0ul;
+  for ( ; i < m_keys.size(); ++i) {
+    const auto& key = m_keys[i];
+    if ((key.m_name == attr_name) &&
+        (((t == _node_) && key.m_for_node) ||
+         ((t == _edge_) && key.m_for_edge))) {
+      break;
+    }
+  }
+  return i;
+}
+
+const std::string* GraphMLScanner::data(const std::string& attr_name,
+                                        const bool or_default) const
+{
+  const size_t i = find_key(m_type, attr_name);
+  if (i == m_keys.size()) {
+    return nullptr;
+  }
+  if (m_has_value[i]) {
+    return &(m_values[i]);
+  }
+  return ((or_default && m_keys[i].m_has_default)? &(m_keys[i].m_default)
+                                                 : nullptr);
+}
+
+const std::string* GraphMLScanner::default_data(const item_type t,
+                                                const std::string& attr_name) const
+{
+  const size_t i = find_key(t, attr_name);
+  if ((i == m_keys.size()) || !m_keys[i].m_has_default) {
+    return nullptr;
+  }
+  return &(m_keys[i].m_default);
+}
+
+/**@}*/
+} // end of namespace wcs
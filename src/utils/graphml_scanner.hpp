@@ -0,0 +1,126 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef __WCS_UTILS_GRAPHML_SCANNER_HPP__
+#define __WCS_UTILS_GRAPHML_SCANNER_HPP__
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace wcs {
+/** \addtogroup wcs_utils
+ *  @{ */
+
+/**
+ * Pull parser of GraphML that visits one node or edge element at a time
+ * without building a document tree. Only the subset of XML that GraphML
+ * relies on is supported: elements, attributes, character data with the
+ * predefined and numeric entities, CDATA sections, comments, processing
+ * instructions and the document type declaration, which are skipped.
+ *
+ * The data of the current element is kept in a buffer per key, which is
+ * reused across elements. Thus, the memory does not grow with the size of
+ * the graph. The scanner can be rewound to read the stream again.
+ */
+class GraphMLScanner {
+ public:
+  enum item_type { _none_=0, _node_, _edge_ };
+
+  GraphMLScanner(std::istream& is);
+
+  /**
+   * Advance to the next node or edge, and return its type. Return `_none_`
+   * at the end of the stream. Throw an exception upon a malformed input.
+   */
+  item_type next();
+  /// Go back to the beginning of the stream
+  void rewind();
+
+  /// Return the id of the current element
+  const std::string& id() const { return m_id; }
+  /// Return the id of the source node of the current edge
+  const std::string& source() const { return m_source; }
+  /// Return the id of the target node of the current edge
+  const std::string& target() const { return m_target; }
+
+  /**
+   * Return the data of the current element for the key of the given
+   * attribute name. If not given, return the default value of the key unless
+   * `or_default` is false. Return nullptr if neither is available.
+   */
+  const std::string* data(const std::string& attr_name,
+                          const bool or_default = true) const;
+  /// Return the default value of the key for the given type of elements
+  const std::string* default_data(const item_type t,
+                                  const std::string& attr_name) const;
+
+ protected:
+  struct key_t {
+    std::string m_id;
+    std::string m_name;
+    bool m_for_node;
+    bool m_for_edge;
+    bool m_has_default;
+    std::string m_default;
+  };
+
+  using attrs_t = std::vector<std::pair<std::string, std::string>>;
+
+  int get();
+  int peek();
+  /// Skip up to and including the given delimiter
+  void skip_past(const char* const delim);
+  /**
+   * Read a tag that begins right after '<'. Return false if it is not an
+   * element, e.g., a comment, which is skipped. Otherwise, set the name, the
+   * attributes, and whether it is an end tag or an empty-element tag.
+   */
+  bool read_tag(std::string& name, attrs_t& attrs, bool& is_end,
+                bool& is_empty);
+  /**
+   * Read the character data up to the end tag of the current element. As
+   * boost::read_graphml(), the leading and the trailing whitespace is
+   * trimmed, and each run of whitespace in between becomes a single space.
+   */
+  void read_text(std::string& text);
+  /// Skip the content up to the end tag of the element
+  void skip_element(const std::string& name);
+  void read_key(const attrs_t& attrs, const bool is_empty);
+  void read_item(const std::string& name, const bool is_empty);
+  /// Return the index of the key for the given type of elements
+  size_t find_key(const item_type t, const std::string& attr_name) const;
+  static const std::string* find_attr(const attrs_t& attrs,
+                                      const std::string& name);
+  static void decode_entity(const std::string& ent, std::string& out);
+
+ protected:
+  std::istream& m_is;
+  std::streambuf* m_buf;
+
+  std::vector<key_t> m_keys;
+
+  item_type m_type;
+  std::string m_id;
+  std::string m_source;
+  std::string m_target;
+  /// Data of the current element by the key index
+  std::vector<std::string> m_values;
+  /// Whether the data of the corresponding key is given in the current element
+  std::vector<bool> m_has_value;
+
+  /// Buffers reused to read tags
+  std::string m_name;
+  attrs_t m_attrs;
+};
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_UTILS_GRAPHML_SCANNER_HPP__
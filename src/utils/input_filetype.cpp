@@ -18,6 +18,8 @@ namespace wcs {
 /** \addtogroup wcs_utils
  *  @{ */
 
+constexpr char input_filetype::snapshot_magic[];
+
 input_filetype::input_filetype(const std::string filename)
 : m_filename(filename)
 {}
@@ -38,6 +40,15 @@ input_filetype::input_type input_filetype::detect() const
   }
   else
   {
+    char magic[sizeof(snapshot_magic)] = {'\0'};
+    if (file.read(magic, sizeof(magic)) &&
+        std::equal(magic, magic + sizeof(magic), snapshot_magic)) {
+      file.close();
+      return input_filetype::input_type::_snapshot_;
+    }
+    file.clear();
+    file.seekg(0);
+
     for(int i=0; i<10; i++) {
       if (std::getline(file, line)){
         std::transform(line.begin(), line.end(), line.begin(),
@@ -19,7 +19,10 @@ namespace wcs {
 
 class input_filetype {
  public:
-  enum input_type { _ioerror_=0, _graphml_, _sbml_, _unknown_ };
+  enum input_type { _ioerror_=0, _graphml_, _sbml_, _snapshot_, _unknown_ };
+  /// The leading bytes of a binary network snapshot file
+  static constexpr char snapshot_magic[8] = {'W','C','S','N','S','N','P','\0'};
+
   input_filetype(const std::string filename);
   input_type detect() const;
 
@@ -0,0 +1,113 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include "reaction_network/network.hpp"
+#include "utils/file.hpp"
+#include "utils/timer.hpp"
+
+
+#define OPTIONS "gho:"
+static const struct option longopts[] = {
+    {"generate", no_argument,        0, 'g'},
+    {"help",     no_argument,        0, 'h'},
+    {"outfile",  required_argument,  0, 'o'},
+    { 0, 0, 0, 0 },
+};
+
+void print_usage(const std::string exec, int code)
+{
+  std::cerr <<
+    "Usage: " << exec << " <filename>.graphml|<filename>.xml\n"
+    "    Load a reaction network model, either a graph (<filename>.graphml)\n"
+    "    or an SBML model (<filename>.xml), and write the fully initialized\n"
+    "    network into a compact binary snapshot (<filename>.wcsnet).\n"
+    "    The snapshot can be given to the simulators in place of the model\n"
+    "    to skip parsing it. With SBML, the snapshot refers to the library\n"
+    "    of the rate functions generated, which must remain available.\n"
+    "    The output is written to a file that has the same name as the input\n"
+    "    file except the extention '.wcsnet' unless --outfile is given.\n"
+    "\n"
+    "    OPTIONS:\n"
+    "    -g, --generate\n"
+    "            Regenerate the library of the rate functions even if it\n"
+    "            already exists.\n"
+    "\n"
+    "    -h, --help\n"
+    "            Display this usage information\n"
+    "\n"
+    "    -o, --outfile\n"
+    "            Specify the output file name\n"
+    "\n";
+  exit(code);
+}
+
+int main(int argc, char** argv)
+{
+  int c;
+  bool reuse = true;
+  std::string outfile;
+
+  while ((c = getopt_long(argc, argv, OPTIONS, longopts, NULL)) != -1) {
+    switch (c) {
+      case 'g': /* --generate */
+        reuse = false;
+        break;
+      case 'h': /* --help */
+        print_usage(argv[0], 0);
+        break;
+      case 'o': /* --outfile */
+        outfile = std::string(optarg);
+        break;
+      default:
+        print_usage(argv[0], 1);
+        break;
+    }
+  }
+
+  if (optind != (argc - 1)) {
+    print_usage (argv[0], 1);
+  }
+
+  std::string fn(argv[optind]);
+
+  if (outfile.empty()) {
+    std::string parent_dir, stem, ext;
+    wcs::extract_file_component(fn, parent_dir, stem, ext);
+    outfile = stem + ".wcsnet";
+  }
+
+  try {
+    double t_start = wcs::get_time();
+    wcs::Network rnet;
+    rnet.load(fn, reuse);
+    rnet.init();
+    std::cerr << "Network loading time: " << wcs::get_time() - t_start
+              << " sec" << std::endl;
+
+    t_start = wcs::get_time();
+    rnet.save_snapshot(outfile);
+    std::cerr << "Snapshot writing time: " << wcs::get_time() - t_start
+              << " sec" << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,223 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef __WCS_UTILS_PHILOX_HPP__
+#define __WCS_UTILS_PHILOX_HPP__
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace wcs {
+/** \addtogroup wcs_utils
+ *  @{ */
+
+/**
+ * Counter-based random number engine Philox4x32-10 of Salmon et al.
+ * (SC'11, "Parallel random numbers: as easy as 1, 2, 3"). Each output block
+ * of four 32-bit words is a bijection of a 128-bit counter under a 64-bit
+ * key. Here, the key comes from the seed, the upper half of the counter is
+ * the stream id, and the lower half is the index of the block within the
+ * stream. Thus, independent streams are obtained by only changing the stream
+ * id, and the position in a stream is fully described by the number of words
+ * drawn, which allows to skip ahead or to restore the position in O(1).
+ *
+ * Blocks are generated `batch_blocks` at a time into a small buffer. The loop
+ * over the blocks of a batch has no dependency across iterations, and the
+ * compiler can vectorize it.
+ *
+ * This satisfies the requirements of the uniform random bit generator, and
+ * can be used with the distributions of the standard library. It is trivially
+ * copyable such that the state can be serialized by `bits()`.
+ */
+class Philox4x32 {
+ public:
+  using result_type = uint32_t;
+  using counter_t = uint64_t;
+  using stream_t = uint64_t;
+  /// The number of blocks of four words generated at once
+  static constexpr unsigned batch_blocks = 4u;
+  static constexpr unsigned batch_size = 4u * batch_blocks;
+  static constexpr result_type default_seed = 20111115u;
+
+  Philox4x32() { seed(default_seed); }
+  explicit Philox4x32(result_type s) { seed(s); }
+  template <typename SSeq, typename = std::enable_if_t<
+              !std::is_convertible<SSeq, result_type>::value &&
+              !std::is_same<std::decay_t<SSeq>, Philox4x32>::value>>
+  explicit Philox4x32(SSeq& q) { seed(q); }
+
+  static constexpr result_type min() {
+    return std::numeric_limits<result_type>::min();
+  }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  /// Set the key by the given value, and rewind to the beginning of stream 0
+  void seed(result_type s = default_seed) {
+    m_key[0] = s;
+    m_key[1] = 0u;
+    set_stream(static_cast<stream_t>(0u));
+  }
+
+  /// Set the key using the seed sequence, and rewind to the beginning of stream 0
+  template <typename SSeq>
+  std::enable_if_t<!std::is_convertible<SSeq, result_type>::value>
+  seed(SSeq& q) {
+    q.generate(m_key, m_key + 2);
+    set_stream(static_cast<stream_t>(0u));
+  }
+
+  /// Switch to the beginning of the given stream under the current key
+  void set_stream(const stream_t s) {
+    m_stream = s;
+    set_counter(static_cast<counter_t>(0u));
+  }
+  stream_t get_stream() const { return m_stream; }
+
+  /// Move to the given position in the current stream in terms of words drawn
+  void set_counter(const counter_t c) {
+    m_counter = c;
+    if ((m_counter % batch_size) != 0u) {
+      generate_batch(m_counter / batch_size);
+    }
+  }
+  /// Return the number of words drawn from the current stream
+  counter_t get_counter() const { return m_counter; }
+
+  result_type operator()() {
+    const auto i = static_cast<unsigned>(m_counter % batch_size);
+    if (i == 0u) {
+      generate_batch(m_counter / batch_size);
+    }
+    ++ m_counter;
+    return m_buffer[i];
+  }
+
+  void discard(unsigned long long z) {
+    set_counter(m_counter + static_cast<counter_t>(z));
+  }
+
+  /**
+   * Compute the block of the given counter under the given key. This is the
+   * stateless form of the generator.
+   */
+  static void block(const result_type key[2], const result_type ctr[4],
+                    result_type out[4]) {
+    result_type k0 = key[0];
+    result_type k1 = key[1];
+    result_type c0 = ctr[0];
+    result_type c1 = ctr[1];
+    result_type c2 = ctr[2];
+    result_type c3 = ctr[3];
+
+    for (unsigned r = 0u; r < num_rounds; ++r) {
+      const uint64_t p0 = static_cast<uint64_t>(mult0) * c0;
+      const uint64_t p1 = static_cast<uint64_t>(mult1) * c2;
+      c0 = static_cast<result_type>(p1 >> 32) ^ c1 ^ k0;
+      c1 = static_cast<result_type>(p1);
+      c2 = static_cast<result_type>(p0 >> 32) ^ c3 ^ k1;
+      c3 = static_cast<result_type>(p0);
+      k0 += weyl0;
+      k1 += weyl1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+
+  friend bool operator==(const Philox4x32& lhs, const Philox4x32& rhs) {
+    return (lhs.m_key[0] == rhs.m_key[0]) && (lhs.m_key[1] == rhs.m_key[1]) &&
+           (lhs.m_stream == rhs.m_stream) && (lhs.m_counter == rhs.m_counter);
+  }
+  friend bool operator!=(const Philox4x32& lhs, const Philox4x32& rhs) {
+    return !(lhs == rhs);
+  }
+
+  /// Serialize the key, the stream and the position, but not the buffer
+  template <class Archive>
+  void save(Archive& ar) const {
+    ar(m_key[0], m_key[1], m_stream, m_counter);
+  }
+  template <class Archive>
+  void load(Archive& ar) {
+    counter_t c = static_cast<counter_t>(0u);
+    ar(m_key[0], m_key[1], m_stream, c);
+    set_counter(c);
+  }
+
+ protected:
+  static constexpr unsigned num_rounds = 10u;
+  static constexpr result_type mult0 = 0xD2511F53u;
+  static constexpr result_type mult1 = 0xCD9E8D57u;
+  static constexpr result_type weyl0 = 0x9E3779B9u;
+  static constexpr result_type weyl1 = 0xBB67AE85u;
+
+  /**
+   * Fill the buffer with the blocks of the given batch. The rounds are
+   * applied to all the blocks of the batch in lockstep such that the
+   * innermost loops run across independent blocks.
+   */
+  void generate_batch(const counter_t batch) {
+    const counter_t first = batch * batch_blocks;
+    result_type c0[batch_blocks], c1[batch_blocks];
+    result_type c2[batch_blocks], c3[batch_blocks];
+
+    for (unsigned b = 0u; b < batch_blocks; ++b) {
+      c0[b] = static_cast<result_type>(first + b);
+      c1[b] = static_cast<result_type>((first + b) >> 32);
+      c2[b] = static_cast<result_type>(m_stream);
+      c3[b] = static_cast<result_type>(m_stream >> 32);
+    }
+
+    result_type k0 = m_key[0];
+    result_type k1 = m_key[1];
+    for (unsigned r = 0u; r < num_rounds; ++r) {
+      for (unsigned b = 0u; b < batch_blocks; ++b) {
+        const uint64_t p0 = static_cast<uint64_t>(mult0) * c0[b];
+        const uint64_t p1 = static_cast<uint64_t>(mult1) * c2[b];
+        c0[b] = static_cast<result_type>(p1 >> 32) ^ c1[b] ^ k0;
+        c1[b] = static_cast<result_type>(p1);
+        c2[b] = static_cast<result_type>(p0 >> 32) ^ c3[b] ^ k1;
+        c3[b] = static_cast<result_type>(p0);
+      }
+      k0 += weyl0;
+      k1 += weyl1;
+    }
+
+    for (unsigned b = 0u; b < batch_blocks; ++b) {
+      m_buffer[4u*b] = c0[b];
+      m_buffer[4u*b + 1u] = c1[b];
+      m_buffer[4u*b + 2u] = c2[b];
+      m_buffer[4u*b + 3u] = c3[b];
+    }
+  }
+
+ protected:
+  result_type m_key[2];
+  stream_t m_stream;
+  /// The number of words drawn from the current stream
+  counter_t m_counter;
+  /// Words of the current batch
+  result_type m_buffer[batch_size];
+};
+
+/// Whether the engine can restore its position from a counter alone
+template <typename E>
+struct is_counter_based_engine : std::false_type {};
+
+template <>
+struct is_counter_based_engine<Philox4x32> : std::true_type {};
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_UTILS_PHILOX_HPP__
@@ -0,0 +1,197 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <getopt.h>
+#include "utils/trace_binary_reader.hpp"
+#include "utils/to_string.hpp"
+
+
+#define OPTIONS "ahp:t:o:"
+static const struct option longopts[] = {
+    {"all",     no_argument,        0, 'a'},
+    {"help",    no_argument,        0, 'h'},
+    {"period",  required_argument,  0, 'p'},
+    {"times",   required_argument,  0, 't'},
+    {"outfile", required_argument,  0, 'o'},
+    { 0, 0, 0, 0 },
+};
+
+void print_usage(const std::string exec, int code)
+{
+  std::cerr <<
+    "Usage: " << exec << " <filename>\n"
+    "    Reconstruct the species population from a binary trace file\n"
+    "    written by `ssa --binary`. Without any option, show the summary\n"
+    "    of the trace and the final state.\n"
+    "\n"
+    "    OPTIONS:\n"
+    "    -h, --help\n"
+    "            Display this usage information\n"
+    "\n"
+    "    -a, --all\n"
+    "            Show the state after every event along with the reaction\n"
+    "            fired.\n"
+    "\n"
+    "    -t, --times\n"
+    "            Show the state at each of the comma-separated list of time\n"
+    "            points (e.g., 0.5,1,10).\n"
+    "\n"
+    "    -p, --period\n"
+    "            Show the state at every given period of time until the\n"
+    "            last event.\n"
+    "\n"
+    "    -o, --outfile\n"
+    "            Specify the output file name. Without this, the standard\n"
+    "            output is used.\n"
+    "\n";
+  exit(code);
+}
+
+void write_labels(const wcs::TraceBinaryReader& reader, const bool all,
+                  std::ostream& os)
+{
+  std::string str = "Time:";
+  for (const auto& label : reader.species_labels()) {
+    str += '\t' + label;
+  }
+  if (all) {
+    str += "\tReaction";
+  }
+  os << str << '\n';
+}
+
+void write_state(const wcs::TraceBinaryReader& reader, const wcs::sim_time_t t,
+                 const std::string& rlabel, std::ostream& os)
+{
+  std::string str = wcs::to_string_in_scientific(t);
+  for (const auto c : reader.counts()) {
+    str += '\t' + std::to_string(c);
+  }
+  if (!rlabel.empty()) {
+    str += '\t' + rlabel;
+  }
+  os << str << '\n';
+}
+
+int main(int argc, char** argv)
+{
+  int c;
+  bool all = false;
+  wcs::sim_time_t period = static_cast<wcs::sim_time_t>(0);
+  std::vector<wcs::sim_time_t> times;
+  std::string outfile;
+
+  while ((c = getopt_long(argc, argv, OPTIONS, longopts, NULL)) != -1) {
+    switch (c) {
+      case 'a': /* --all */
+        all = true;
+        break;
+      case 'h': /* --help */
+        print_usage(argv[0], 0);
+        break;
+      case 'p': /* --period */
+        period = static_cast<wcs::sim_time_t>(std::stod(optarg));
+        if (period <= static_cast<wcs::sim_time_t>(0)) {
+          std::cerr << "The period must be positive." << std::endl;
+          print_usage(argv[0], 1);
+        }
+        break;
+      case 't': /* --times */
+        {
+          std::stringstream ss(optarg);
+          std::string item;
+          while (std::getline(ss, item, ',')) {
+            times.push_back(static_cast<wcs::sim_time_t>(std::stod(item)));
+          }
+          std::sort(times.begin(), times.end());
+        }
+        break;
+      case 'o': /* --outfile */
+        outfile = std::string(optarg);
+        break;
+      default:
+        print_usage(argv[0], 1);
+        break;
+    }
+  }
+
+  if (optind != (argc - 1)) {
+    print_usage(argv[0], 1);
+  }
+
+  std::ofstream ofs;
+  if (!outfile.empty()) {
+    ofs.open(outfile);
+    if (!ofs) {
+      std::cerr << "Failed to open " << outfile << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream& os = (outfile.empty()? std::cout : ofs);
+
+  try {
+    wcs::TraceBinaryReader reader(argv[optind]);
+
+    if (all) {
+      write_labels(reader, true, os);
+      write_state(reader, reader.time(), "NA", os);
+      while (reader.next()) {
+        write_state(reader, reader.time(),
+                    reader.reaction_labels()[reader.last_reaction()], os);
+      }
+    } else if (!times.empty()) {
+      write_labels(reader, false, os);
+      for (const auto t : times) {
+        reader.advance_to(t);
+        write_state(reader, t, "", os);
+      }
+    } else if (period > static_cast<wcs::sim_time_t>(0)) {
+      write_labels(reader, false, os);
+      wcs::sim_time_t t = static_cast<wcs::sim_time_t>(0);
+      for (size_t i = 1ul; reader.advance_to(t); ++i) {
+        write_state(reader, t, "", os);
+        t = period * static_cast<wcs::sim_time_t>(i);
+      }
+      write_state(reader, t, "", os);
+    } else {
+      while (reader.next());
+      const auto n_rec = reader.get_num_events_recorded();
+      os << "num_species = " << reader.get_num_species()
+         << "\tnum_reactions = " << reader.get_num_reactions()
+         << "\tnum_events = " << reader.num_events();
+      if (n_rec == wcs::trace_binary::unknown_num_events) {
+        os << " (not finalized)";
+      } else if (n_rec != reader.num_events()) {
+        os << " (" << n_rec << " recorded)";
+      }
+      os << "\tlast_event_time = "
+         << wcs::to_string_in_scientific(reader.time()) << '\n';
+      write_labels(reader, false, os);
+      write_state(reader, reader.time(), "", os);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -40,11 +40,27 @@ ENABLE_CUSTOM_CEREAL (std::uniform_real_distribution<float>)
 
 #include "utils/state_io.hpp"
 #include "utils/seed.hpp"
+#include "utils/philox.hpp"
 
 namespace wcs {
 /** \addtogroup wcs_utils
  *  @{ */
 
+/**
+ * Whether the engine can be stepped back by a number of draws from its
+ * current state alone. A counter-based engine only needs to rewind the
+ * counter. A multiplicative linear congruential engine, such as
+ * std::minstd_rand, steps back by multiplying the state with the inverse of
+ * the multiplier modulo the modulus.
+ */
+template <typename E>
+struct is_reversible_engine : is_counter_based_engine<E> {};
+
+template <typename U, U a, U m>
+struct is_reversible_engine< std::linear_congruential_engine<U, a, 0u, m> >
+: std::integral_constant<bool, ((m > 1u) && (m <= (1ull << 32u)) &&
+                                (a % m != 0u))> {};
+
 template <template <typename> typename D = std::uniform_real_distribution,
           typename V = double>
 class RNGen {
@@ -53,7 +69,30 @@ class RNGen {
   using distribution_t = D<V>;
   using param_type = typename distribution_t::param_type;
   //using generator_type = std::mt19937; // better quality but has large state
+ #if defined(WCS_RNG_PHILOX)
+  using generator_type = wcs::Philox4x32;
+ #else
   using generator_type = std::minstd_rand;
+ #endif // defined(WCS_RNG_PHILOX)
+  /**
+   * Whether the generator is counter-based. If so, thread private generators
+   * share the key and differ only by the stream id, and the engine state
+   * saved by `save_engine_bits()` is only the position in the stream.
+   */
+  static constexpr bool is_counter_based
+    = is_counter_based_engine<generator_type>::value;
+  /// Type of the number of values drawn from the engine
+  using draw_count_t = uint64_t;
+  /**
+   * Whether the generator can be rolled back by the number of draws alone
+   * instead of restoring a saved state. This requires a single engine.
+   */
+ #if WCS_THREAD_PRIVATE_RNG
+  static constexpr bool is_reversible = false;
+ #else
+  static constexpr bool is_reversible
+    = is_reversible_engine<generator_type>::value;
+ #endif // WCS_THREAD_PRIVATE_RNG
  #if WCS_THREAD_PRIVATE_RNG
   using generator_list_t = std::vector< std::unique_ptr<generator_type> >;
  #endif // WCS_THREAD_PRIVATE_RNG
@@ -83,6 +122,14 @@ class RNGen {
    * the first generator object.
    */
   result_type pull();
+  /**
+   * Draw a value from the given distribution object using the internal
+   * generator engine. This allows sampling from a distribution of which the
+   * parameters vary per draw (e.g., Poisson with a different mean for each
+   * reaction) without reseeding the engine as `param()` does.
+   */
+  template <typename DD>
+  typename DD::result_type draw(DD& dist);
   const distribution_t& distribution() const;
   //// Return the length of the generator state in words
   static constexpr unsigned get_state_size();
@@ -114,10 +161,28 @@ class RNGen {
   template<typename S> S& load_bits(S &is);
   size_t byte_size() const;
 
+  /**
+   * Save and load the state of the generator engine only. For a counter-based
+   * engine, this is the position in the stream, which is restored into the
+   * existing engine keeping its key and stream id. This suffices to roll back
+   * the generator, but the full state is needed to restore it otherwise.
+   */
   template<typename S> S& save_engine_bits(S &os) const;
   template<typename S> S& load_engine_bits(S &is);
   size_t engine_byte_size() const;
 
+  /**
+   * Return the number of values drawn from the engine so far. Only the
+   * difference between two calls is meaningful, which is the number of draws
+   * in between. This is only available when `is_reversible`.
+   */
+  draw_count_t num_draws() const;
+  /**
+   * Step the engine back by the given number of draws such that the same
+   * values are drawn again. This is only available when `is_reversible`.
+   */
+  void rewind(const draw_count_t n);
+
  #if WCS_THREAD_PRIVATE_RNG
   /**
    * Set the number of omp threads to use. By default it is set to the value
@@ -146,6 +211,13 @@ class RNGen {
   generator_type m_gen;
 #endif // WCS_THREAD_PRIVATE_RNG
   distribution_t m_distribution;
+ #if !WCS_THREAD_PRIVATE_RNG
+  /**
+   * The number of values drawn from an engine that does not count the draws
+   * by itself, which is maintained only when the engine is reversible.
+   */
+  draw_count_t m_num_draws;
+ #endif // !WCS_THREAD_PRIVATE_RNG
 
  #if WCS_THREAD_PRIVATE_RNG
   int m_num_threads;
@@ -8,7 +8,7 @@
  *                                                                            *
  ******************************************************************************/
 
-#include <type_traits> // std::is_same, std::is_pod
+#include <type_traits> // std::is_same, std::is_trivially_copyable
 #include <cassert>     // assert
 #include <algorithm>   // std::max
 #include <functional>  // std::hash
@@ -24,12 +24,164 @@ namespace wcs {
 /** \addtogroup wcs_utils
  *  @{ */
 
+namespace rngen_detail {
+
+/**
+ * Seed the engine of each thread. A counter-based engine shares the key, and
+ * takes the thread id as the stream id.
+ */
+template <typename G>
+inline void seed_thread_engine(G& g, const bool sseq_used,
+                               const seed_seq_param_t& sseq_param,
+                               const unsigned seed, const int tid)
+{
+  if constexpr (is_counter_based_engine<G>::value) {
+    if (sseq_used) {
+      std::seed_seq sseq(sseq_param.begin(), sseq_param.end());
+      g.seed(sseq);
+    } else {
+      g.seed(seed);
+    }
+    g.set_stream(static_cast<typename G::stream_t>(tid));
+  } else if (sseq_used) {
+    wcs::seed_seq_param_t sseq_thread_param;
+    sseq_thread_param.reserve(sseq_param.size()+1);
+    sseq_thread_param = sseq_param;
+    sseq_thread_param.push_back(tid);
+    std::seed_seq sseq(sseq_thread_param.begin(), sseq_thread_param.end());
+    g.seed(sseq);
+  } else {
+  // https://www.boost.org/doc/libs/1_55_0/doc/html/hash/reference.html#boost.hash_combine
+    unsigned s = seed ^ (std::hash<unsigned>()(tid) + 0x9e3779b9
+                         + (seed << 6) + (seed >> 2));
+    g.seed(s);
+  }
+}
+
+/// Save the position of a counter-based engine, or the whole state otherwise
+template <typename G, typename S>
+inline void save_engine_position(const G& g, S& os)
+{
+  if constexpr (is_counter_based_engine<G>::value) {
+    os << bits(g.get_counter());
+  } else {
+    os << bits(g);
+  }
+}
+
+/**
+ * Restore the position of a counter-based engine keeping the key and the
+ * stream, or the whole state otherwise
+ */
+template <typename G, typename S>
+inline void load_engine_position(G& g, S& is)
+{
+  if constexpr (is_counter_based_engine<G>::value) {
+    typename G::counter_t c = 0u;
+    is >> bits(c);
+    g.set_counter(c);
+  } else {
+    is >> bits(g);
+  }
+}
+
+/**
+ * Adaptor of an engine that counts the values drawn from it. It exposes the
+ * same range and values as the engine such that a distribution produces the
+ * same sequence through it.
+ */
+template <typename G, typename C>
+struct counting_engine {
+  using result_type = typename G::result_type;
+  static constexpr result_type min() { return G::min(); }
+  static constexpr result_type max() { return G::max(); }
+  result_type operator()() {
+    ++ m_count;
+    return m_g();
+  }
+
+  G& m_g;
+  C& m_count;
+};
+
+/// Return the inverse of a modulo m, of which the existence is assumed
+constexpr uint64_t inverse_mod(const uint64_t a, const uint64_t m)
+{
+  int64_t t = 0, nt = 1;
+  int64_t r = static_cast<int64_t>(m);
+  int64_t nr = static_cast<int64_t>(a % m);
+  while (nr != 0) {
+    const int64_t q = r / nr;
+    const int64_t pt = t - q * nt;
+    t = nt;
+    nt = pt;
+    const int64_t pr = r - q * nr;
+    r = nr;
+    nr = pr;
+  }
+  return static_cast<uint64_t>((t < 0)? t + static_cast<int64_t>(m) : t);
+}
+
+/// Return the number of values drawn from a counter-based engine
+template <typename G>
+inline uint64_t engine_counter(const G& g)
+{
+  return static_cast<uint64_t>(g.get_counter());
+}
+
+/// Step a counter-based engine back by n draws
+template <typename G>
+inline void step_back(G& g, const uint64_t n)
+{
+  g.set_counter(g.get_counter() - static_cast<typename G::counter_t>(n));
+}
+
+/**
+ * Step a multiplicative linear congruential engine back by n draws. The state
+ * is not exposed, but the next value is the next state, from which the
+ * current one is recovered. Then, the state n draws earlier is obtained by
+ * the inverse of the multiplier raised to the power of n.
+ */
+template <typename U, U a, U m>
+inline void step_back(std::linear_congruential_engine<U, a, 0u, m>& g,
+                      const uint64_t n)
+{
+  if (n == 0u) return;
+  constexpr uint64_t a_inv = inverse_mod(a, m);
+
+  uint64_t x = static_cast<uint64_t>(
+                 std::linear_congruential_engine<U, a, 0u, m>(g)());
+  uint64_t p = 1u;
+  uint64_t b = a_inv;
+  for (uint64_t e = n + 1u; e > 0u; e >>= 1u) {
+    if (e & 1u) p = (p * b) % m;
+    b = (b * b) % m;
+  }
+  x = (x * p) % m;
+  // The state is in [1, m-1], which the seed sets as is
+  g.seed(static_cast<U>(x));
+}
+
+template <typename G>
+constexpr size_t engine_position_size()
+{
+  if constexpr (is_counter_based_engine<G>::value) {
+    return sizeof(typename G::counter_t);
+  } else {
+    return sizeof(G);
+  }
+}
+
+} // end of namespace rngen_detail
+
 template <template <typename> typename D, typename V>
 inline RNGen<D, V>::RNGen()
 : m_sseq_used(false)
 {
  #if WCS_THREAD_PRIVATE_RNG
   m_num_threads = omp_get_max_threads();
+ #else
+  m_num_draws = static_cast<draw_count_t>(0u);
  #endif // WCS_THREAD_PRIVATE_RNG
 }
 
@@ -76,19 +228,8 @@ inline void RNGen<D, V>::param(const RNGen<D, V>::param_type& p)
    #endif // OMP_DEBUG
     const auto tid = omp_get_thread_num();
     m_gen[tid] = std::make_unique<generator_type>();
-    if (m_sseq_used) {
-      wcs::seed_seq_param_t sseq_thread_param;
-      sseq_thread_param.reserve(m_sseq_param.size()+1);
-      sseq_thread_param = m_sseq_param;
-      sseq_thread_param.push_back(tid);
-      std::seed_seq sseq(sseq_thread_param.begin(), sseq_thread_param.end());
-      m_gen[tid]->seed(sseq);
-    } else {
-    // https://www.boost.org/doc/libs/1_55_0/doc/html/hash/reference.html#boost.hash_combine
-      unsigned seed = m_seed ^ (std::hash<unsigned>()(tid) + 0x9e3779b9
-                                + (m_seed << 6) + (m_seed >> 2));
-      m_gen[tid]->seed(seed);
-    }
+    rngen_detail::seed_thread_engine(*m_gen[tid], m_sseq_used, m_sseq_param,
+                                     m_seed, tid);
   }
 
   #if OMP_DEBUG
@@ -121,7 +262,13 @@ inline typename RNGen<D, V>::result_type RNGen<D, V>::operator()()
  #if WCS_THREAD_PRIVATE_RNG
   return m_distribution(*(m_gen[omp_get_thread_num()]));
  #else
-  return m_distribution(m_gen);
+  if constexpr (is_reversible && !is_counter_based) {
+    rngen_detail::counting_engine<generator_type, draw_count_t>
+      g{m_gen, m_num_draws};
+    return m_distribution(g);
+  } else {
+    return m_distribution(m_gen);
+  }
  #endif // WCS_THREAD_PRIVATE_RNG
 }
 
@@ -131,7 +278,24 @@ inline typename RNGen<D, V>::result_type RNGen<D, V>::pull()
  #if WCS_THREAD_PRIVATE_RNG
   return m_distribution(*(m_gen[0]));
  #else
-  return m_distribution(m_gen);
+  return (*this)();
+ #endif // WCS_THREAD_PRIVATE_RNG
+}
+
+template <template <typename> typename D, typename V>
+template <typename DD>
+inline typename DD::result_type RNGen<D, V>::draw(DD& dist)
+{
+ #if WCS_THREAD_PRIVATE_RNG
+  return dist(*(m_gen[omp_get_thread_num()]));
+ #else
+  if constexpr (is_reversible && !is_counter_based) {
+    rngen_detail::counting_engine<generator_type, draw_count_t>
+      g{m_gen, m_num_draws};
+    return dist(g);
+  } else {
+    return dist(m_gen);
+  }
  #endif // WCS_THREAD_PRIVATE_RNG
 }
 
@@ -160,6 +324,8 @@ constexpr unsigned RNGen<D, V>::get_state_size()
     return 112u;
   } else if constexpr (std::is_same<generator_type, std::ranlux48>::value) {
     return 120u;
+  } else if constexpr (std::is_same<generator_type, wcs::Philox4x32>::value) {
+    return 2u; // the length of the key
   }
   // This size is only used in determining seed_seq length, and it is not
   // unsafe to use an inaccurate number for the purpose.
@@ -265,8 +431,9 @@ inline S& RNGen<D, V>::load_bits(S& is)
 template <template <typename> typename D, typename V>
 inline size_t RNGen<D, V>::byte_size() const
 {
-  // It is also assumed that the generator_type is a POD structure
-  assert (std::is_pod<generator_type>::value);
+  // It is also assumed that the generator_type is trivially copyable
+  static_assert(std::is_trivially_copyable<generator_type>::value,
+                "The generator engine must be trivially copyable.");
  #if WCS_THREAD_PRIVATE_RNG
   assert (m_gen.size() > 0u);
   return (sizeof(m_seed) + sizeof(m_sseq_used) +
@@ -291,10 +458,10 @@ inline S& RNGen<D, V>::save_engine_bits(S& os) const
   os << bits(num_gens);
 
   for (const auto& g: m_gen) {
-    if (!!g) os << bits(*g);
+    if (!!g) rngen_detail::save_engine_position(*g, os);
   }
  #else
-  os << bits(m_gen);
+  rngen_detail::save_engine_position(m_gen, os);
  #endif // WCS_THREAD_PRIVATE_RNG
   return os;
 }
@@ -308,25 +475,68 @@ inline S& RNGen<D, V>::load_engine_bits(S& is)
   n_threads_t num_gens = 0u;
   is >> bits(num_gens);
 
-  m_gen.resize(num_gens);
+  if constexpr (is_counter_based) {
+    // Only the positions are restored into the existing engines
+    if (m_gen.size() != static_cast<size_t>(num_gens)) {
+      WCS_THROW("The number of generators differs from that of the state.");
+    }
+  } else {
+    m_gen.resize(num_gens);
 
+    for (auto& g: m_gen) {
+       g = std::make_unique<generator_type>();
+    }
+  }
   for (auto& g: m_gen) {
-     g = std::make_unique<generator_type>();
-     is >> bits(*g);
+    rngen_detail::load_engine_position(*g, is);
   }
  #else
-  is >> bits(m_gen);
+  rngen_detail::load_engine_position(m_gen, is);
  #endif // WCS_THREAD_PRIVATE_RNG
   return is;
 }
 
 template <template <typename> typename D, typename V>
 inline size_t RNGen<D, V>::engine_byte_size() const
+{
+  constexpr size_t pos_size
+    = rngen_detail::engine_position_size<generator_type>();
+ #if WCS_THREAD_PRIVATE_RNG
+  return sizeof(n_threads_t) + pos_size * m_gen.size();
+ #else
+  return pos_size;
+ #endif // WCS_THREAD_PRIVATE_RNG
+}
+
+template <template <typename> typename D, typename V>
+inline typename RNGen<D, V>::draw_count_t RNGen<D, V>::num_draws() const
+{
+ #if WCS_THREAD_PRIVATE_RNG
+  WCS_THROW("Thread private generators are not reversible.");
+  return static_cast<draw_count_t>(0u);
+ #else
+  if constexpr (is_counter_based) {
+    return rngen_detail::engine_counter(m_gen);
+  } else {
+    return m_num_draws;
+  }
+ #endif // WCS_THREAD_PRIVATE_RNG
+}
+
+template <template <typename> typename D, typename V>
+inline void RNGen<D, V>::rewind(const draw_count_t n)
 {
  #if WCS_THREAD_PRIVATE_RNG
-  return sizeof(*(m_gen[0])) * m_gen.size();
+  WCS_THROW("Thread private generators are not reversible.");
  #else
-  return sizeof(m_gen);
+  if constexpr (is_reversible) {
+    rngen_detail::step_back(m_gen, n);
+    if constexpr (!is_counter_based) {
+      m_num_draws -= n;
+    }
+  } else {
+    WCS_THROW("The generator engine is not reversible.");
+  }
  #endif // WCS_THREAD_PRIVATE_RNG
 }
 
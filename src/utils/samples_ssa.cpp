@@ -26,6 +26,7 @@
 #include "utils/samples_ssa.hpp"
 #include "utils/to_string.hpp"
 #include "utils/exception.hpp"
+#include "utils/state_io.hpp"
 
 namespace wcs {
 /** \addtogroup wcs_utils
@@ -179,6 +180,8 @@ void SamplesSSA::finalize(const sim_time_t t)
       flush();
     }
 
+    wait_fragments();
+
     std::ofstream ofs;
     ofs.open((m_outfile_stem + m_outfile_ext), std::ofstream::out);
     write_header(ofs);
@@ -198,6 +201,44 @@ void SamplesSSA::finalize(const sim_time_t t)
   }
 }
 
+void SamplesSSA::save_checkpoint(std::ostream& os)
+{
+  Trajectory::save_checkpoint(os);
+
+  std::vector<v_idx_t> ridx;
+  std::vector<r_cnt_t> rcnt;
+  ridx.reserve(m_r_diffs.size());
+  rcnt.reserve(m_r_diffs.size());
+  for (const auto& r_diff: m_r_diffs) {
+    ridx.push_back(m_net_ptr->reaction_d2i(r_diff.first));
+    rcnt.push_back(r_diff.second);
+  }
+
+  os << bits(m_start_iter) << bits(m_cur_iter) << bits(m_cur_time)
+     << bits(m_next_sample_iter) << bits(m_next_sample_time)
+     << bits(ridx) << bits(rcnt);
+}
+
+void SamplesSSA::load_checkpoint(std::istream& is)
+{
+  Trajectory::load_checkpoint(is);
+
+  std::vector<v_idx_t> ridx;
+  std::vector<r_cnt_t> rcnt;
+  is >> bits(m_start_iter) >> bits(m_cur_iter) >> bits(m_cur_time)
+     >> bits(m_next_sample_iter) >> bits(m_next_sample_time)
+     >> bits(ridx) >> bits(rcnt);
+
+  if (ridx.size() != rcnt.size()) {
+    WCS_THROW("Invalid sampling state in the checkpoint.");
+  }
+  m_r_diffs.clear();
+  m_s_diffs.clear();
+  for (size_t i = 0ul; i < ridx.size(); ++i) {
+    m_r_diffs[m_net_ptr->reaction_i2d(ridx[i])] = rcnt[i];
+  }
+}
+
 size_t SamplesSSA::estimate_tmpstr_size() const
 {
   return m_species_counts.size()*cnt_digits +
@@ -286,16 +327,17 @@ void SamplesSSA::flush()
  #if defined(WCS_HAS_CEREAL)
   const auto freg_file = m_outfile_stem + '.' + std::to_string(m_cur_frag_id++)
                        + ".cereal";
-  {
+  m_cur_record_in_frag = static_cast<frag_size_t>(0u);
+  m_num_steps += m_samples.size();
+
+  hand_off_fragment(m_samples, [freg_file] (const samples_t& frag) {
     std::ofstream os(freg_file, std::ios::binary);
+    if (!os) {
+      WCS_THROW("Failed to open " + freg_file);
+    }
     cereal::BinaryOutputArchive archive(os);
-
-    archive(m_samples);
-
-    m_cur_record_in_frag = static_cast<frag_size_t>(0u);
-  }
-  m_num_steps += m_samples.size();
-  m_samples.clear();
+    archive(frag);
+  });
  #endif // WCS_HAS_CEREAL
 }
 
@@ -61,6 +61,9 @@ public:
   using Trajectory::record_step;
   void record_step(const sim_time_t t, const r_desc_t r) override;
   void finalize(const sim_time_t t) override;
+  /// Also save the reaction counts over the current sampling interval
+  void save_checkpoint(std::ostream& os) override;
+  void load_checkpoint(std::istream& is) override;
 
 protected:
   using s_map_t = typename std::unordered_map<s_desc_t, s_diff_t>;
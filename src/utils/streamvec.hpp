@@ -12,6 +12,7 @@
 #define __STREAMVEC_HPP__
 
 #include <streambuf>
+#include <vector>
 
 namespace wcs {
 /** \addtogroup wcs_utils
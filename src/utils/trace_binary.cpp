@@ -0,0 +1,199 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <cstring> // memcpy
+#include <limits>
+#include "utils/trace_binary.hpp"
+#include "utils/exception.hpp"
+#include "utils/file.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_utils
+ *  @{ */
+
+namespace {
+
+template <typename T>
+inline void write_binary(std::ostream& os, const T& v)
+{
+  os.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+inline void write_label(std::ostream& os, const std::string& label)
+{
+  write_binary(os, static_cast<trace_binary::len_t>(label.size()));
+  os.write(label.data(), static_cast<std::streamsize>(label.size()));
+}
+
+} // end of anonymous namespace
+
+TraceBinary::TraceBinary(const std::shared_ptr<wcs::Network>& net_ptr)
+: Trajectory(net_ptr), m_last_time(static_cast<sim_time_t>(0))
+{}
+
+TraceBinary::~TraceBinary()
+{}
+
+void TraceBinary::set_outfile(const std::string outfile,
+                              const frag_size_t frag_size)
+{
+  if (outfile.empty()) {
+    WCS_THROW("An output file name is required for the binary trace.");
+    return;
+  }
+  std::string parent_dir;
+  std::string stem;
+  extract_file_component(outfile, parent_dir, stem, m_outfile_ext);
+  m_outfile_stem = parent_dir + stem;
+
+  // The records are appended to a single file regardless of the fragment
+  // size. Thus, this does not rely on Cereal unlike the text trace.
+  m_frag_size = ((frag_size == static_cast<frag_size_t>(0u))?
+                 std::numeric_limits<frag_size_t>::max() : frag_size);
+}
+
+void TraceBinary::initialize()
+{
+  Trajectory::initialize();
+
+  m_trace.clear();
+  if (m_frag_size != std::numeric_limits<frag_size_t>::max()) {
+    m_trace.reserve(m_frag_size);
+  }
+  m_num_steps = 0ul;
+  m_cur_record_in_frag = static_cast<frag_size_t>(0u);
+  m_last_time = static_cast<sim_time_t>(0);
+
+  const auto outfile = m_outfile_stem + m_outfile_ext;
+  m_ofs.open(outfile, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_ofs) {
+    WCS_THROW("Failed to open " + outfile);
+    return;
+  }
+  write_header(m_ofs);
+}
+
+void TraceBinary::record_step(const sim_time_t t, const r_desc_t r)
+{
+  m_trace.emplace_back(t, m_net_ptr->reaction_d2i(r));
+
+  if (++m_cur_record_in_frag >= m_frag_size) {
+    flush();
+  }
+}
+
+void TraceBinary::finalize(const sim_time_t t)
+{
+  if (!m_ofs.is_open()) {
+    return;
+  }
+  while (!m_trace.empty() && (m_trace.back().first > t)) {
+    m_trace.pop_back();
+  }
+  flush();
+
+  // Now that the number of events is known, fill it in the header
+  const auto num_events = static_cast<trace_binary::count_t>(m_num_steps);
+  m_ofs.seekp(static_cast<std::streamoff>(trace_binary::num_events_offset));
+  write_binary(m_ofs, num_events);
+  m_ofs.close();
+}
+
+std::ostream& TraceBinary::write_header(std::ostream& os) const
+{
+  using namespace trace_binary;
+  const wcs::Network::graph_t& g = m_net_ptr->graph();
+  const auto& species = m_net_ptr->species_list();
+  const auto& reactions = m_net_ptr->reaction_list();
+
+  os.write(magic, sizeof(magic));
+  write_binary(os, version);
+  write_binary(os, byte_order_mark);
+  write_binary(os, unknown_num_events);
+  write_binary(os, static_cast<count_t>(species.size()));
+  write_binary(os, static_cast<count_t>(reactions.size()));
+
+  for (const auto& vd : species) {
+    write_label(os, g[vd].get_label());
+  }
+  for (const auto& vd : reactions) {
+    write_label(os, g[vd].get_label());
+  }
+
+  for (const auto& vd : reactions) {
+    const auto reactants = m_net_ptr->get_reactant_updates(vd);
+    const auto products = m_net_ptr->get_product_updates(vd);
+    write_binary(os, static_cast<len_t>(reactants.size() + products.size()));
+    for (const auto& u : reactants) {
+      write_binary(os, static_cast<index_t>(u.first));
+      write_binary(os, -static_cast<delta_t>(u.second));
+    }
+    for (const auto& u : products) {
+      write_binary(os, static_cast<index_t>(u.first));
+      write_binary(os, static_cast<delta_t>(u.second));
+    }
+  }
+
+  for (const auto scnt : m_species_counts) {
+    write_binary(os, static_cast<count_t>(scnt));
+  }
+  return os;
+}
+
+std::ostream& TraceBinary::write(std::ostream& os)
+{
+  using namespace trace_binary;
+
+  m_bytes.resize(m_trace.size() * record_size);
+  char* ptr = m_bytes.data();
+
+  for (const auto& rec : m_trace) {
+    // Take the delta from the time reconstructed rather than the time of the
+    // previous event such that the rounding error does not accumulate.
+    const auto dt = static_cast<time_delta_t>(rec.first - m_last_time);
+    const auto ridx = static_cast<index_t>(rec.second);
+    m_last_time += dt;
+    std::memcpy(ptr, &dt, sizeof(dt));
+    ptr += sizeof(dt);
+    std::memcpy(ptr, &ridx, sizeof(ridx));
+    ptr += sizeof(ridx);
+  }
+  os.write(m_bytes.data(), static_cast<std::streamsize>(m_bytes.size()));
+  return os;
+}
+
+void TraceBinary::flush()
+{
+  if (!m_trace.empty()) {
+    write(m_ofs);
+    if (!m_ofs) {
+      WCS_THROW("Failed to write the trace into " +
+                m_outfile_stem + m_outfile_ext);
+      return;
+    }
+    m_num_steps += m_trace.size();
+    m_trace.clear();
+  }
+  m_cur_record_in_frag = static_cast<frag_size_t>(0u);
+}
+
+bool TraceBinary::is_checkpointable() const
+{
+  return false;
+}
+
+/**@}*/
+} // end of namespace wcs
@@ -0,0 +1,75 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef	 __WCS_UTILS_TRACE_BINARY_HPP__
+#define	 __WCS_UTILS_TRACE_BINARY_HPP__
+#include <fstream>
+#include <vector>
+#include "utils/trajectory.hpp"
+#include "utils/trace_binary_format.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_utils
+ *  @{ */
+
+/**
+ * Record every event into a compact binary trace file as it occurs. The
+ * header, which carries the species and reaction labels, the species
+ * updates by each reaction and the initial population, is written at
+ * initialization. Then, each event is appended as the time delta from the
+ * previous event and the reaction index. Events are kept in a memory buffer
+ * that is written out whenever it fills up to the fragment size. Unlike the
+ * text trace, no population state is materialized at finalization. The states
+ * can be reconstructed on demand by `TraceBinaryReader` (see
+ * trace_binary_format.hpp for the layout).
+ */
+class TraceBinary : public Trajectory {
+public:
+  using tentry_t = typename std::pair<sim_time_t, v_idx_t>;
+  using trace_t = typename std::vector<tentry_t>;
+
+  TraceBinary(const std::shared_ptr<wcs::Network>& net_ptr);
+  TraceBinary(TraceBinary&& other) = default;
+  TraceBinary& operator=(TraceBinary&& other) = default;
+
+  ~TraceBinary() override;
+  /**
+   * Set the output file name and the number of records to buffer before
+   * writing out. Setting it to 0 buffers every record until finalization.
+   */
+  void set_outfile(const std::string outfile = "",
+                   const frag_size_t frag_size = default_frag_size) override;
+  void initialize() override;
+  using Trajectory::record_step;
+  void record_step(const sim_time_t t, const r_desc_t r) override;
+  void finalize(const sim_time_t t) override;
+  /// The binary trace is a single stream, and cannot continue from a checkpoint
+  bool is_checkpointable() const override;
+
+protected:
+  std::ostream& write_header(std::ostream& os) const override;
+  /// Append the records in the buffer to the stream
+  std::ostream& write(std::ostream& os) override;
+  void flush() override;
+
+protected:
+  /// Buffered records of the event time and the reaction index
+  trace_t m_trace;
+  /// Output stream of the trace file
+  std::ofstream m_ofs;
+  /// Byte buffer to serialize records into
+  std::vector<char> m_bytes;
+  /// The time of the last event written as reconstructed from time deltas
+  sim_time_t m_last_time;
+};
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_UTILS_TRACE_BINARY_HPP__
@@ -0,0 +1,70 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef	 __WCS_UTILS_TRACE_BINARY_FORMAT_HPP__
+#define	 __WCS_UTILS_TRACE_BINARY_FORMAT_HPP__
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+namespace wcs {
+/** \addtogroup wcs_utils
+ *  @{ */
+
+/**
+ * Layout of the binary trace file. All the values are written in the byte
+ * order of the host that produced the file, which is identified by the byte
+ * order mark.
+ *
+ * Header:
+ *   - magic string (8 bytes)
+ *   - format version (uint32_t)
+ *   - byte order mark (uint32_t)
+ *   - number of events (uint64_t), or `unknown_num_events` if the trace was
+ *     not finalized
+ *   - number of species (uint64_t)
+ *   - number of reactions (uint64_t)
+ *   - label of each species in the order of the species index, and then that
+ *     of each reaction in the order of the reaction index, each as the length
+ *     (uint32_t) followed by the characters
+ *   - for each reaction in the order of the reaction index, the number of
+ *     species updates (uint32_t) followed by as many pairs of the species
+ *     index (uint32_t) and the change in the count (int64_t)
+ *   - initial count of each species (uint64_t) in the order of the index
+ *
+ * Body: a stream of event records until the end of file, each of which is
+ * the time passed since the previous event (double) followed by the index of
+ * the reaction fired (uint32_t). The time of an event is the sum of the time
+ * deltas up to the event.
+ */
+namespace trace_binary {
+
+constexpr char magic[8] = {'W', 'C', 'S', 'T', 'R', 'A', 'C', 'E'};
+constexpr uint32_t version = 1u;
+constexpr uint32_t byte_order_mark = 0x01020304u;
+
+using len_t = uint32_t;
+using count_t = uint64_t;
+using index_t = uint32_t;
+using delta_t = int64_t;
+using time_delta_t = double;
+
+constexpr count_t unknown_num_events = std::numeric_limits<count_t>::max();
+/// The offset of the number of events from the beginning of the file
+constexpr size_t num_events_offset
+  = sizeof(magic) + sizeof(version) + sizeof(byte_order_mark);
+/// The size of an event record in bytes
+constexpr size_t record_size = sizeof(time_delta_t) + sizeof(index_t);
+
+} // end of namespace trace_binary
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_UTILS_TRACE_BINARY_FORMAT_HPP__
@@ -0,0 +1,273 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <cstring> // memcpy
+#include "utils/trace_binary_reader.hpp"
+#include "utils/exception.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_utils
+ *  @{ */
+
+namespace {
+
+/// The number of event records to read from the file at once
+constexpr size_t records_per_chunk = 16384ul;
+
+template <typename T>
+inline bool read_binary(std::istream& is, T& v)
+{
+  return static_cast<bool>(is.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+} // end of anonymous namespace
+
+TraceBinaryReader::TraceBinaryReader(const std::string& filename)
+: m_filename(filename),
+  m_body_offset(static_cast<std::streamoff>(0)),
+  m_num_events_recorded(trace_binary::unknown_num_events),
+  m_time(static_cast<sim_time_t>(0)),
+  m_last_reaction(static_cast<index_t>(0u)),
+  m_num_events(static_cast<count_t>(0u)),
+  m_has_next(false),
+  m_next_time(static_cast<sim_time_t>(0)),
+  m_next_reaction(static_cast<index_t>(0u)),
+  m_buffer_size(0ul),
+  m_buffer_pos(0ul)
+{
+  m_ifs.open(filename, std::ios::in | std::ios::binary);
+  if (!m_ifs) {
+    WCS_THROW("Failed to open " + filename);
+    return;
+  }
+  read_header();
+  m_buffer.resize(records_per_chunk * trace_binary::record_size);
+  rewind();
+}
+
+void TraceBinaryReader::read_header()
+{
+  using namespace trace_binary;
+  const std::string err = "Invalid binary trace header in " + m_filename;
+
+  char m[sizeof(magic)];
+  uint32_t ver = 0u;
+  uint32_t bom = 0u;
+  count_t num_species = 0u;
+  count_t num_reactions = 0u;
+
+  if (!m_ifs.read(m, sizeof(m)) ||
+      (std::memcmp(m, magic, sizeof(magic)) != 0)) {
+    WCS_THROW(err + ": not a binary trace");
+    return;
+  }
+  if (!read_binary(m_ifs, ver) || (ver != version)) {
+    WCS_THROW(err + ": unsupported version " + std::to_string(ver));
+    return;
+  }
+  if (!read_binary(m_ifs, bom) || (bom != byte_order_mark)) {
+    WCS_THROW(err + ": written in a different byte order");
+    return;
+  }
+  if (!read_binary(m_ifs, m_num_events_recorded) ||
+      !read_binary(m_ifs, num_species) ||
+      !read_binary(m_ifs, num_reactions)) {
+    WCS_THROW(err);
+    return;
+  }
+
+  auto read_labels = [&](std::vector<std::string>& labels, const count_t n) {
+    labels.resize(n);
+    for (auto& label : labels) {
+      len_t len = 0u;
+      if (!read_binary(m_ifs, len)) {
+        WCS_THROW(err);
+      }
+      label.resize(len);
+      if ((len > 0u) && !m_ifs.read(&label[0], len)) {
+        WCS_THROW(err);
+      }
+    }
+  };
+  read_labels(m_species_labels, num_species);
+  read_labels(m_reaction_labels, num_reactions);
+
+  m_update_offsets.clear();
+  m_update_offsets.reserve(num_reactions + 1ul);
+  m_update_offsets.push_back(0ul);
+  m_updates.clear();
+
+  for (count_t i = 0u; i < num_reactions; ++i) {
+    len_t n = 0u;
+    if (!read_binary(m_ifs, n)) {
+      WCS_THROW(err);
+      return;
+    }
+    for (len_t j = 0u; j < n; ++j) {
+      update_t u;
+      if (!read_binary(m_ifs, u.first) || !read_binary(m_ifs, u.second) ||
+          (u.first >= num_species)) {
+        WCS_THROW(err);
+        return;
+      }
+      m_updates.emplace_back(u);
+    }
+    m_update_offsets.push_back(m_updates.size());
+  }
+
+  m_initial_counts.resize(num_species);
+  for (auto& c : m_initial_counts) {
+    if (!read_binary(m_ifs, c)) {
+      WCS_THROW(err);
+      return;
+    }
+  }
+  m_body_offset = m_ifs.tellg();
+}
+
+const std::vector<std::string>& TraceBinaryReader::species_labels() const
+{
+  return m_species_labels;
+}
+
+const std::vector<std::string>& TraceBinaryReader::reaction_labels() const
+{
+  return m_reaction_labels;
+}
+
+const std::vector<TraceBinaryReader::count_t>&
+TraceBinaryReader::initial_counts() const
+{
+  return m_initial_counts;
+}
+
+size_t TraceBinaryReader::get_num_species() const
+{
+  return m_species_labels.size();
+}
+
+size_t TraceBinaryReader::get_num_reactions() const
+{
+  return m_reaction_labels.size();
+}
+
+TraceBinaryReader::count_t TraceBinaryReader::get_num_events_recorded() const
+{
+  return m_num_events_recorded;
+}
+
+void TraceBinaryReader::rewind()
+{
+  m_ifs.clear();
+  m_ifs.seekg(m_body_offset);
+  m_buffer_size = 0ul;
+  m_buffer_pos = 0ul;
+
+  m_counts = m_initial_counts;
+  m_time = static_cast<sim_time_t>(0);
+  m_last_reaction = static_cast<index_t>(0u);
+  m_num_events = static_cast<count_t>(0u);
+  load_next();
+}
+
+bool TraceBinaryReader::fill_buffer()
+{
+  m_ifs.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+  const auto n = static_cast<size_t>(m_ifs.gcount());
+  // Ignore a partial record at the end, which a trace interrupted may have
+  m_buffer_size = n - (n % trace_binary::record_size);
+  m_buffer_pos = 0ul;
+  return (m_buffer_size > 0ul);
+}
+
+void TraceBinaryReader::load_next()
+{
+  if ((m_buffer_pos >= m_buffer_size) && !fill_buffer()) {
+    m_has_next = false;
+    return;
+  }
+  trace_binary::time_delta_t dt;
+  const char* ptr = m_buffer.data() + m_buffer_pos;
+  std::memcpy(&dt, ptr, sizeof(dt));
+  std::memcpy(&m_next_reaction, ptr + sizeof(dt), sizeof(m_next_reaction));
+  m_buffer_pos += trace_binary::record_size;
+
+  if (m_next_reaction >= m_reaction_labels.size()) {
+    WCS_THROW("Invalid reaction index " + std::to_string(m_next_reaction) +
+              " in " + m_filename);
+    return;
+  }
+  m_next_time = m_time + static_cast<sim_time_t>(dt);
+  m_has_next = true;
+}
+
+bool TraceBinaryReader::next()
+{
+  if (!m_has_next) {
+    return false;
+  }
+  const auto ridx = m_next_reaction;
+  for (size_t i = m_update_offsets[ridx]; i < m_update_offsets[ridx+1]; ++i) {
+    const auto& u = m_updates[i];
+    m_counts[u.first] = static_cast<count_t>(m_counts[u.first] + u.second);
+  }
+  m_time = m_next_time;
+  m_last_reaction = ridx;
+  m_num_events ++;
+  load_next();
+  return true;
+}
+
+bool TraceBinaryReader::advance_to(const sim_time_t t)
+{
+  while (m_has_next && (m_next_time <= t)) {
+    next();
+  }
+  return m_has_next;
+}
+
+bool TraceBinaryReader::has_next() const
+{
+  return m_has_next;
+}
+
+sim_time_t TraceBinaryReader::peek_time() const
+{
+  return m_next_time;
+}
+
+const std::vector<TraceBinaryReader::count_t>& TraceBinaryReader::counts() const
+{
+  return m_counts;
+}
+
+sim_time_t TraceBinaryReader::time() const
+{
+  return m_time;
+}
+
+TraceBinaryReader::index_t TraceBinaryReader::last_reaction() const
+{
+  return m_last_reaction;
+}
+
+TraceBinaryReader::count_t TraceBinaryReader::num_events() const
+{
+  return m_num_events;
+}
+
+/**@}*/
+} // end of namespace wcs
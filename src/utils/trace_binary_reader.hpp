@@ -0,0 +1,121 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef	 __WCS_UTILS_TRACE_BINARY_READER_HPP__
+#define	 __WCS_UTILS_TRACE_BINARY_READER_HPP__
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "wcs_types.hpp"
+#include "utils/trace_binary_format.hpp"
+
+namespace wcs {
+/** \addtogroup wcs_utils
+ *  @{ */
+
+/**
+ * Replay a binary trace written by `TraceBinary`. The reader does not need
+ * the reaction network as the trace carries the species updates by each
+ * reaction. Starting from the initial population, events are read from the
+ * file in chunks and applied one at a time, which allows reconstructing the
+ * state at any event or time point without materializing all the states.
+ */
+class TraceBinaryReader {
+public:
+  using count_t = trace_binary::count_t;
+  using index_t = trace_binary::index_t;
+  using delta_t = trace_binary::delta_t;
+  /// Species update as the species index and the change in the count
+  using update_t = std::pair<index_t, delta_t>;
+
+  /// Open the trace file and read the header. Throw on failure.
+  TraceBinaryReader(const std::string& filename);
+
+  const std::vector<std::string>& species_labels() const;
+  const std::vector<std::string>& reaction_labels() const;
+  const std::vector<count_t>& initial_counts() const;
+  size_t get_num_species() const;
+  size_t get_num_reactions() const;
+  /**
+   * Return the number of events recorded in the header, or
+   * `trace_binary::unknown_num_events` if the trace was not finalized.
+   */
+  count_t get_num_events_recorded() const;
+
+  /// Go back to the initial state
+  void rewind();
+  /// Apply the next event, and return false if there is none left
+  bool next();
+  /**
+   * Apply all the events that occur at or before the given time, and return
+   * false if there is none left afterwards.
+   */
+  bool advance_to(const sim_time_t t);
+  /// Return whether any event is left to apply
+  bool has_next() const;
+  /// Return the time of the next event if any left
+  sim_time_t peek_time() const;
+
+  /// Return the species counts at the current state
+  const std::vector<count_t>& counts() const;
+  /// Return the time of the last event applied
+  sim_time_t time() const;
+  /// Return the index of the reaction of the last event applied
+  index_t last_reaction() const;
+  /// Return the number of events applied so far
+  count_t num_events() const;
+
+protected:
+  void read_header();
+  /// Load the next event into m_next_time and m_next_reaction
+  void load_next();
+  /// Fill the record buffer from the file
+  bool fill_buffer();
+
+protected:
+  std::string m_filename;
+  std::ifstream m_ifs;
+  /// The file offset where event records begin
+  std::streamoff m_body_offset;
+  count_t m_num_events_recorded;
+
+  std::vector<std::string> m_species_labels;
+  std::vector<std::string> m_reaction_labels;
+  /**
+   * Offsets into m_updates by the reaction index. The species updates by the
+   * i-th reaction are in [m_update_offsets[i], m_update_offsets[i+1]).
+   */
+  std::vector<size_t> m_update_offsets;
+  std::vector<update_t> m_updates;
+  std::vector<count_t> m_initial_counts;
+
+  /// Current species counts
+  std::vector<count_t> m_counts;
+  sim_time_t m_time;
+  index_t m_last_reaction;
+  count_t m_num_events;
+
+  /// Whether the next event has been loaded
+  bool m_has_next;
+  sim_time_t m_next_time;
+  index_t m_next_reaction;
+
+  /// Chunk of raw records read from the file
+  std::vector<char> m_buffer;
+  /// The number of bytes valid in the buffer
+  size_t m_buffer_size;
+  /// The position of the next record in the buffer
+  size_t m_buffer_pos;
+};
+
+/**@}*/
+} // end of namespace wcs
+#endif // __WCS_UTILS_TRACE_BINARY_READER_HPP__
@@ -80,6 +80,8 @@ void TraceSSA::finalize(const sim_time_t t)
       flush();
     }
 
+    wait_fragments();
+
     std::ofstream ofs;
     ofs.open((m_outfile_stem + m_outfile_ext), std::ofstream::out);
     write_header(ofs);
@@ -213,16 +215,17 @@ void TraceSSA::flush()
  #if defined(WCS_HAS_CEREAL)
   const auto freg_file = m_outfile_stem + '.' + std::to_string(m_cur_frag_id++)
                        + ".cereal";
-  {
+  m_cur_record_in_frag = static_cast<frag_size_t>(0u);
+  m_num_steps += m_trace.size();
+
+  hand_off_fragment(m_trace, [freg_file] (const trace_t& frag) {
     std::ofstream os(freg_file, std::ios::binary);
+    if (!os) {
+      WCS_THROW("Failed to open " + freg_file);
+    }
     cereal::BinaryOutputArchive archive(os);
-
-    archive(m_trace);
-
-    m_cur_record_in_frag = static_cast<frag_size_t>(0u);
-  }
-  m_num_steps += m_trace.size();
-  m_trace.clear();
+    archive(frag);
+  });
  #endif // WCS_HAS_CEREAL
 }
 
@@ -17,6 +17,7 @@
 #include "utils/exception.hpp"
 #include "utils/to_string.hpp"
 #include "utils/file.hpp"
+#include "utils/state_io.hpp"
 #include "utils/trajectory.hpp"
 
 namespace wcs {
@@ -76,6 +77,53 @@ void Trajectory::set_outfile(const std::string outfile, const frag_size_t frag_s
   }
 }
 
+void Trajectory::set_async(const unsigned num_buffers)
+{
+  if ((num_buffers == 0u) || !is_fragmented()) {
+    wait_fragments();
+    m_writer.reset();
+  } else if (!m_writer || (m_writer->get_num_buffers() != num_buffers)) {
+    wait_fragments();
+    m_writer = std::make_shared<FragmentWriter>(num_buffers);
+  }
+}
+
+bool Trajectory::is_fragmented() const
+{
+  return (m_frag_size != static_cast<frag_size_t>(0u)) &&
+         (m_frag_size != std::numeric_limits<frag_size_t>::max());
+}
+
+bool Trajectory::is_checkpointable() const
+{
+  return is_fragmented();
+}
+
+void Trajectory::save_checkpoint(std::ostream& os)
+{
+  if (!is_checkpointable()) {
+    WCS_THROW("Checkpointing the trajectory requires fragment files. " \
+              "Build with WCS_WITH_CEREAL=ON and set a fragment size.");
+  }
+  if (m_cur_record_in_frag > static_cast<frag_size_t>(0u)) {
+    flush();
+  }
+  // The checkpoint must not refer to a fragment that is not in the file yet
+  wait_fragments();
+
+  os << bits(m_species_counts) << bits(m_cur_frag_id) << bits(m_num_steps);
+}
+
+void Trajectory::load_checkpoint(std::istream& is)
+{
+  if (!is_checkpointable()) {
+    WCS_THROW("Checkpointing the trajectory requires fragment files. " \
+              "Build with WCS_WITH_CEREAL=ON and set a fragment size.");
+  }
+  is >> bits(m_species_counts) >> bits(m_cur_frag_id) >> bits(m_num_steps);
+  m_cur_record_in_frag = static_cast<frag_size_t>(0u);
+}
+
 void Trajectory::initialize()
 {
   if (!m_net_ptr) {
@@ -127,5 +175,12 @@ void Trajectory::flush()
   m_cur_record_in_frag = static_cast<frag_size_t>(0u);
 }
 
+void Trajectory::wait_fragments()
+{
+  if (m_writer) {
+    m_writer->wait();
+  }
+}
+
 /**@}*/
 } // end of namespace wcs
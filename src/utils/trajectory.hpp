@@ -12,7 +12,10 @@
 #define	 __WCS_UTILS_TRAJECTORY_HPP__
 #include <string>
 #include <iostream>
+#include <memory>
+#include <utility>
 #include "sim_methods/update.hpp"
+#include "utils/fragment_writer.hpp"
 
 namespace wcs {
 /** \addtogroup wcs_utils
@@ -27,6 +30,8 @@ namespace wcs {
  * During simulation, trajectory data are kept in a memory buffer. The buffer
  * can be configured to flush out to temprary files, called fragments, as it
  * fills up to an amount predefined by users.
+ * Optionally, fragments can be written asynchronously by a background thread
+ * (See FragmentWriter) such that the simulation does not wait on the disk.
  * At finalization, the history of population change is reconstructed from the
  * buffer or the fragment files, and written into a final trajectory file.
  */
@@ -47,8 +52,15 @@ public:
   Trajectory& operator=(Trajectory&& other) = default;
 
   virtual ~Trajectory();
-  void set_outfile(const std::string outfile = "",
-                   const frag_size_t frag_size = default_frag_size);
+  virtual void set_outfile(const std::string outfile = "",
+                           const frag_size_t frag_size = default_frag_size);
+  /**
+   * Write fragments in the background using the given total number of
+   * fragment buffers, which bounds the memory for the trajectory data.
+   * Setting it to 0 makes writes synchronous. This has no effect unless
+   * fragmenting is enabled by `set_outfile()`.
+   */
+  void set_async(const unsigned num_buffers);
 
   virtual void initialize();
   virtual void record_step(const sim_time_t t, const r_desc_t r);
@@ -56,12 +68,38 @@ public:
   virtual void record_step(const sim_time_t t, conc_updates_t&& updates);
   virtual void finalize(const sim_time_t t) = 0;
 
+  /**
+   * Whether the recording can continue from a checkpoint. This requires the
+   * records to be kept in fragment files rather than in memory.
+   */
+  virtual bool is_checkpointable() const;
+  /**
+   * Write out the records buffered as a fragment, and save the state needed
+   * to continue recording after a restart into the given stream. The records
+   * themselves remain in the fragment files.
+   */
+  virtual void save_checkpoint(std::ostream& os);
+  /// Restore the state saved by `save_checkpoint()` after `initialize()`
+  virtual void load_checkpoint(std::istream& is);
+
 protected:
+  /// Whether the records are flushed into fragment files as they accumulate
+  bool is_fragmented() const;
   void record_initial_condition();
   virtual std::ostream& write_header(std::ostream& os) const = 0;
   virtual std::ostream& write(std::ostream& os) = 0;
   virtual void flush();
 
+  /**
+   * Hand off the full fragment buffer to be saved by the given function,
+   * and leave the buffer empty. The save function must not refer to this
+   * object as it may run in the background.
+   */
+  template <typename B, typename F>
+  void hand_off_fragment(B& buffer, F&& save);
+  /// Wait until every fragment handed off is in the file
+  void wait_fragments();
+
 protected:
   /// Initial species population
   std::vector<species_cnt_t> m_species_counts;
@@ -88,8 +126,24 @@ protected:
   frag_size_t m_cur_record_in_frag;
   /// Total number of steps recorded
   size_t m_num_steps;
+  /// Background writer of fragments, which is null for synchronous writes
+  std::shared_ptr<FragmentWriter> m_writer;
 };
 
+template <typename B, typename F>
+void Trajectory::hand_off_fragment(B& buffer, F&& save)
+{
+  if (!m_writer) {
+    save(buffer);
+    buffer.clear();
+    return;
+  }
+  // Moving a buffer to the heap does not copy the records
+  auto full = std::make_shared<B>(std::move(buffer));
+  buffer.clear();
+  m_writer->submit([full, save = std::forward<F>(save)] () { save(*full); });
+}
+
 /**@}*/
 } // end of namespace wcs
 #endif // __WCS_UTILS_TRAJECTORY_HPP__
@@ -0,0 +1,142 @@
+/******************************************************************************
+ *                                                                            *
+ *    Copyright 2020   Lawrence Livermore National Security, LLC and other    *
+ *    Whole Cell Simulator Project Developers. See the top-level COPYRIGHT    *
+ *    file for details.                                                       *
+ *                                                                            *
+ *    SPDX-License-Identifier: MIT                                            *
+ *                                                                            *
+ ******************************************************************************/
+
+#if defined(WCS_HAS_CONFIG)
+#include "wcs_config.hpp"
+#else
+#error "no config"
+#endif
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include "utils/philox.hpp"
+
+#if defined(WCS_HAS_CATCH2)
+#include <cstddef>
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#endif // defined(WCS_HAS_CATCH2)
+
+using philox_t = wcs::Philox4x32;
+using word_t = philox_t::result_type;
+
+/// Known answers of Philox4x32-10 from the Random123 distribution
+bool test_known_answers()
+{
+  const word_t key[3][2] = {
+    {0x00000000u, 0x00000000u},
+    {0xffffffffu, 0xffffffffu},
+    {0xa4093822u, 0x299f31d0u}};
+  const word_t ctr[3][4] = {
+    {0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u},
+    {0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu},
+    {0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u}};
+  const word_t expected[3][4] = {
+    {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u},
+    {0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu},
+    {0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u}};
+
+  bool ok = true;
+  for (int i = 0; i < 3; ++i) {
+    word_t out[4];
+    philox_t::block(key[i], ctr[i], out);
+    for (int j = 0; j < 4; ++j) {
+      ok = ok && (out[j] == expected[i][j]);
+    }
+  }
+  return ok;
+}
+
+/// The engine output must be the blocks of consecutive counters in the stream
+bool test_stream_layout()
+{
+  const word_t seed = 7u;
+  const philox_t::stream_t stream = 0x123456789abcdefull;
+  philox_t gen(seed);
+  gen.set_stream(stream);
+
+  const word_t key[2] = {seed, 0u};
+  bool ok = true;
+  for (word_t b = 0u; b < 3u*philox_t::batch_blocks + 1u; ++b) {
+    const word_t ctr[4] = {b, 0u, static_cast<word_t>(stream),
+                           static_cast<word_t>(stream >> 32)};
+    word_t out[4];
+    philox_t::block(key, ctr, out);
+    for (int j = 0; j < 4; ++j) {
+      ok = ok && (gen() == out[j]);
+    }
+  }
+  return ok;
+}
+
+/// Restoring the counter or skipping ahead must resume at the same position
+bool test_counter_restore()
+{
+  std::seed_seq sseq{1u, 2u, 3u};
+  philox_t gen(sseq);
+  std::vector<word_t> seq;
+  for (int i = 0; i < 5; ++i) gen();
+  const auto c = gen.get_counter();
+  for (int i = 0; i < 40; ++i) seq.push_back(gen());
+
+  philox_t gen2(gen);
+  gen2.set_counter(c);
+  bool ok = true;
+  for (const auto v : seq) {
+    ok = ok && (gen2() == v);
+  }
+
+  philox_t gen3(gen);
+  gen3.set_counter(0u);
+  gen3.discard(c + 17u);
+  ok = ok && (gen3() == seq[17]);
+
+  // A different stream under the same key must give a different sequence
+  gen2.set_stream(gen.get_stream() + 1u);
+  gen2.set_counter(c);
+  ok = ok && (gen2() != seq[0]);
+  return ok;
+}
+
+#if defined(WCS_HAS_CATCH2)
+#define CHECK_RESULT REQUIRE(ok == true)
+TEST_CASE( "Philox4x32 engine", "[rng]" )
+#else
+#define CHECK_RESULT \
+          std::cout << (ok? "PASS" : "FAILED") << std::endl << std::endl;
+#define SECTION(T) std::cout << T << std::endl;
+
+int main (int argc, char** argv)
+#endif
+{
+  bool ok = false;
+
+  SECTION("Compare the blocks with the known answers")
+  {
+    ok = test_known_answers();
+    CHECK_RESULT;
+  }
+
+  SECTION("Check that the engine draws the blocks of consecutive counters")
+  {
+    ok = test_stream_layout();
+    CHECK_RESULT;
+  }
+
+  SECTION("Restore the position in the stream by the counter")
+  {
+    ok = test_counter_restore();
+    CHECK_RESULT;
+  }
+#if !defined(WCS_HAS_CATCH2)
+  return 0;
+#endif
+}
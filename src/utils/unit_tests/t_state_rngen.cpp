@@ -231,6 +231,45 @@ inline bool test_RNGen_state_io(const RNGenParamT& p,
   return (rnseq1 == rnseq2);
 }
 
+/**
+ * Test rolling back a reversible generator by the number of draws instead of
+ * restoring a saved state. The range of the distribution is wider than that
+ * of the engine such that a value may take more than one draw.
+ */
+template<typename RNGenT, typename RNGenParamT = typename RNGenT::param_type>
+inline bool test_RNGen_rewind(const RNGenParamT& p, std::stringstream& sstr)
+{
+  if constexpr (!RNGenT::is_reversible) {
+    sstr << "The generator is not reversible." << std::endl;
+    return true;
+  } else {
+    const size_t n_before = 5ul;
+    const size_t n_after = 8ul;
+
+    RNGenT rgen;
+    rgen.set_seed(7u);
+    rgen.param(p);
+
+    for (size_t i = 0ul; i < n_before; i++) rgen();
+    const auto d = rgen.num_draws();
+
+    std::string rnseq1;
+    std::string rnseq2;
+    for (size_t i = 0ul; i < n_after; i++) {
+      rnseq1 += ' ' + std::to_string(rgen());
+    }
+    sstr << "RNG original  :" << rnseq1 << std::endl;
+
+    rgen.rewind(rgen.num_draws() - d);
+    for (size_t i = 0ul; i < n_after; i++) {
+      rnseq2 += ' ' + std::to_string(rgen());
+    }
+    sstr << "RNG rewound   :" << rnseq2 << std::endl;
+
+    return (rnseq1 == rnseq2);
+  }
+}
+
 #if defined(WCS_HAS_CATCH2)
 #define CHECK_RESULT REQUIRE(ok == true)
 TEST_CASE( "RNGen State IO", "[state I/O]" )
@@ -360,6 +399,15 @@ int main (int argc, char** argv)
            Cereal, StreamVec, sstr, false);
     CHECK_RESULT;
   }
+
+  SECTION("Roll back RNGen based on integer type uniform distribution by "
+          "the number of draws")
+  {
+    std::stringstream sstr;
+    ok = test_RNGen_rewind<rng_uint_t>(rng_uint_t::param_type(100, 4000000000u),
+           sstr);
+    CHECK_RESULT;
+  }
 #if !defined(WCS_HAS_CATCH2)
   return 0;
 #endif
@@ -376,7 +376,7 @@ fi
 seeds="47 147 1147"
 
 if [ -z "${methods}" ] ; then
-    methods="0 1 2"
+    methods="0 1 2 3 4 5"
 fi
 
 frag_sz=0